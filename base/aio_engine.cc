@@ -0,0 +1,382 @@
+#include "aio_engine.h"
+#include "cclog/cclog.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include <deque>
+#include <memory>
+#include <algorithm>
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#ifdef IORING_FEAT_RW_CUR_POS  // linux 5.6, for IORING_OP_READ/WRITE
+#define HAVE_IO_URING 1
+#endif
+#endif
+
+namespace {
+
+class ThreadPoolEngine : public AioEngine {
+  public:
+    explicit ThreadPoolEngine(uint32 thread_num)
+        : _cond(_mutex), _pool(thread_num) {
+    }
+    virtual ~ThreadPoolEngine() {
+      wait();
+    }
+
+    virtual const char* name() const {
+      return "threadpool";
+    }
+
+    // nothing to pin for pread/pwrite.
+    virtual bool registerBuffers(const std::vector<struct iovec>& bufs) {
+      return true;
+    }
+
+    virtual bool submit(Request* reqs, uint32 n);
+    virtual uint32 poll(uint32 min_complete);
+
+  private:
+    Mutex _mutex;
+    CondVar _cond;
+    std::deque<std::pair<Callback, int32>> _completed;
+
+    ThreadPool _pool;
+
+    void doRequest(const Request& req);
+};
+
+bool ThreadPoolEngine::submit(Request* reqs, uint32 n) {
+  for (uint32 i = 0; i < n; ++i) {
+    _pool.run(std::bind(&ThreadPoolEngine::doRequest, this, reqs[i]));
+  }
+  _pending += n;
+  return true;
+}
+
+void ThreadPoolEngine::doRequest(const Request& req) {
+  ssize_t ret;
+  do {
+    if (req.write) {
+      ret = ::pwrite(req.fd, req.buf, req.len, req.offset);
+    } else {
+      ret = ::pread(req.fd, req.buf, req.len, req.offset);
+    }
+  } while (ret == -1 && errno == EINTR);
+
+  MutexGuard g(_mutex);
+  _completed.push_back(std::make_pair(req.cb, ret >= 0 ? ret : -errno));
+  _cond.signal();
+}
+
+uint32 ThreadPoolEngine::poll(uint32 min_complete) {
+  if (min_complete > _pending) min_complete = _pending;
+
+  std::deque<std::pair<Callback, int32>> completed;
+  {
+    MutexGuard g(_mutex);
+    while (_completed.size() < min_complete) {
+      _cond.wait();
+    }
+    completed.swap(_completed);
+  }
+
+  _pending -= completed.size();
+  for (auto it = completed.begin(); it != completed.end(); ++it) {
+    if (it->first) it->first(it->second);
+  }
+  return completed.size();
+}
+
+#ifdef HAVE_IO_URING
+
+class IoUringEngine : public AioEngine {
+  public:
+    IoUringEngine()
+        : _fd(kInvalidFd), _sq_ring(NULL), _cq_ring(NULL), _sqes(NULL),
+          _sq_ring_size(0), _cq_ring_size(0), _sqes_size(0),
+          _registered(false) {
+    }
+    virtual ~IoUringEngine();
+
+    bool Init(uint32 queue_depth);
+
+    virtual const char* name() const {
+      return "io_uring";
+    }
+
+    virtual bool registerBuffers(const std::vector<struct iovec>& bufs);
+
+    virtual bool submit(Request* reqs, uint32 n);
+    virtual uint32 poll(uint32 min_complete);
+
+  private:
+    int _fd;
+
+    void* _sq_ring;
+    void* _cq_ring;
+    struct io_uring_sqe* _sqes;
+    size_t _sq_ring_size;
+    size_t _cq_ring_size;
+    size_t _sqes_size;
+
+    uint32* _sq_tail;
+    uint32 _sq_mask;
+    uint32 _sq_entries;
+    uint32* _sq_array;
+
+    uint32* _cq_head;
+    uint32* _cq_tail;
+    uint32 _cq_mask;
+    uint32 _cq_entries;
+    struct io_uring_cqe* _cqes;
+
+    bool _registered;
+
+    // user_data of sqe is the index of the callback.
+    std::vector<Callback> _callbacks;
+    std::vector<uint32> _free_slots;
+
+    int enter(uint32 to_submit, uint32 min_complete, uint32 flags) {
+      return ::syscall(__NR_io_uring_enter, _fd, to_submit, min_complete,
+                       flags, NULL, 0);
+    }
+
+    bool supported();
+    uint32 reap();
+};
+
+IoUringEngine::~IoUringEngine() {
+  if (_fd != kInvalidFd) wait();
+
+  if (_sqes != NULL) ::munmap(_sqes, _sqes_size);
+  if (_cq_ring != NULL && _cq_ring != _sq_ring) {
+    ::munmap(_cq_ring, _cq_ring_size);
+  }
+  if (_sq_ring != NULL) ::munmap(_sq_ring, _sq_ring_size);
+  closeWrapper(_fd);
+}
+
+bool IoUringEngine::Init(uint32 queue_depth) {
+  struct io_uring_params p;
+  ::memset(&p, 0, sizeof(p));
+  _fd = ::syscall(__NR_io_uring_setup, queue_depth, &p);
+  if (_fd < 0) {
+    _fd = kInvalidFd;
+    return false;
+  }
+
+  _sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(uint32);
+  _cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  bool single_mmap = p.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    _sq_ring_size = _cq_ring_size = std::max(_sq_ring_size, _cq_ring_size);
+  }
+
+  _sq_ring = ::mmap(NULL, _sq_ring_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+  if (_sq_ring == MAP_FAILED) {
+    _sq_ring = NULL;
+    return false;
+  }
+
+  if (single_mmap) {
+    _cq_ring = _sq_ring;
+  } else {
+    _cq_ring = ::mmap(NULL, _cq_ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+    if (_cq_ring == MAP_FAILED) {
+      _cq_ring = NULL;
+      return false;
+    }
+  }
+
+  _sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+  void* sqes = ::mmap(NULL, _sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) return false;
+  _sqes = (struct io_uring_sqe*) sqes;
+
+  char* sq = (char*) _sq_ring;
+  _sq_tail = (uint32*) (sq + p.sq_off.tail);
+  _sq_mask = *(uint32*) (sq + p.sq_off.ring_mask);
+  _sq_entries = p.sq_entries;
+  _sq_array = (uint32*) (sq + p.sq_off.array);
+
+  char* cq = (char*) _cq_ring;
+  _cq_head = (uint32*) (cq + p.cq_off.head);
+  _cq_tail = (uint32*) (cq + p.cq_off.tail);
+  _cq_mask = *(uint32*) (cq + p.cq_off.ring_mask);
+  _cq_entries = p.cq_entries;
+  _cqes = (struct io_uring_cqe*) (cq + p.cq_off.cqes);
+
+  return supported();
+}
+
+// IORING_OP_READ/WRITE are available since linux 5.6, as is the probe.
+bool IoUringEngine::supported() {
+  const uint32 kOpNum = 256;
+  size_t len = sizeof(struct io_uring_probe)
+      + kOpNum * sizeof(struct io_uring_probe_op);
+  std::unique_ptr<char[]> buf(new char[len]);
+  ::memset(buf.get(), 0, len);
+
+  auto probe = (struct io_uring_probe*) buf.get();
+  int ret = ::syscall(__NR_io_uring_register, _fd, IORING_REGISTER_PROBE,
+                      probe, kOpNum);
+  if (ret < 0) return false;
+
+  const int ops[] = { IORING_OP_READ, IORING_OP_WRITE };
+  for (uint32 i = 0; i < sizeof(ops) / sizeof(ops[0]); ++i) {
+    if (ops[i] > probe->last_op) return false;
+    if (!(probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED)) return false;
+  }
+  return true;
+}
+
+bool IoUringEngine::registerBuffers(const std::vector<struct iovec>& bufs) {
+  if (_registered) {
+    ::syscall(__NR_io_uring_register, _fd, IORING_UNREGISTER_BUFFERS, NULL,
+              0);
+    _registered = false;
+  }
+  if (bufs.empty()) return true;
+
+  int ret = ::syscall(__NR_io_uring_register, _fd, IORING_REGISTER_BUFFERS,
+                      &bufs[0], bufs.size());
+  if (ret < 0) {
+    WLOG<< "io_uring register buffers error: " << ::strerror(errno);
+    return false;
+  }
+
+  _registered = true;
+  return true;
+}
+
+bool IoUringEngine::submit(Request* reqs, uint32 n) {
+  uint32 i = 0;
+  while (i < n) {
+    // never have more requests in flight than the completion ring holds.
+    while (_pending >= _cq_entries) {
+      poll(1);
+    }
+
+    uint32 tail = *_sq_tail;
+    uint32 batch = std::min(n - i, _sq_entries);
+    batch = std::min(batch, _cq_entries - _pending);
+
+    for (uint32 k = 0; k < batch; ++k, ++i) {
+      const Request& req = reqs[i];
+
+      uint32 slot;
+      if (!_free_slots.empty()) {
+        slot = _free_slots.back();
+        _free_slots.pop_back();
+        _callbacks[slot] = req.cb;
+      } else {
+        slot = _callbacks.size();
+        _callbacks.push_back(req.cb);
+      }
+
+      uint32 index = (tail + k) & _sq_mask;
+      struct io_uring_sqe* sqe = &_sqes[index];
+      ::memset(sqe, 0, sizeof(*sqe));
+      if (req.buf_index >= 0 && _registered) {
+        sqe->opcode = req.write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+        sqe->buf_index = req.buf_index;
+      } else {
+        sqe->opcode = req.write ? IORING_OP_WRITE : IORING_OP_READ;
+      }
+      sqe->fd = req.fd;
+      sqe->addr = (uint64) req.buf;
+      sqe->len = req.len;
+      sqe->off = req.offset;
+      sqe->user_data = slot;
+
+      _sq_array[index] = index;
+    }
+
+    // make sqes visible to the kernel before the tail.
+    __atomic_store_n(_sq_tail, tail + batch, __ATOMIC_RELEASE);
+    // counted before enter(), reap() may see completions of this batch.
+    _pending += batch;
+
+    uint32 submitted = 0;
+    while (submitted < batch) {
+      int ret = enter(batch - submitted, 0, 0);
+      if (ret < 0) {
+        if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+          reap();
+          continue;
+        }
+        FLOG<< "io_uring_enter error: " << ::strerror(errno);
+      }
+      submitted += ret;
+    }
+  }
+
+  return true;
+}
+
+uint32 IoUringEngine::reap() {
+  uint32 head = *_cq_head;
+  uint32 tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+  if (head == tail) return 0;
+
+  // take the completions off the ring before running any callback, which
+  // may submit and poll, and so reap() again.
+  std::vector<std::pair<Callback, int32>> completed(tail - head);
+  for (uint32 i = 0; head != tail; ++head, ++i) {
+    const struct io_uring_cqe& cqe = _cqes[head & _cq_mask];
+    uint32 slot = static_cast<uint32>(cqe.user_data);
+
+    completed[i].first.swap(_callbacks[slot]);
+    completed[i].second = cqe.res;
+    _free_slots.push_back(slot);
+  }
+
+  __atomic_store_n(_cq_head, tail, __ATOMIC_RELEASE);
+  _pending -= completed.size();
+
+  for (auto it = completed.begin(); it != completed.end(); ++it) {
+    if (it->first) it->first(it->second);
+  }
+  return completed.size();
+}
+
+uint32 IoUringEngine::poll(uint32 min_complete) {
+  if (min_complete > _pending) min_complete = _pending;
+
+  uint32 n = reap();
+  while (n < min_complete) {
+    int ret = enter(0, min_complete - n, IORING_ENTER_GETEVENTS);
+    if (ret < 0 && errno != EINTR) {
+      FLOG<< "io_uring_enter error: " << ::strerror(errno);
+    }
+    n += reap();
+  }
+  return n;
+}
+
+#endif  // HAVE_IO_URING
+
+}  // namespace
+
+AioEngine* AioEngine::New(uint32 queue_depth, uint32 thread_num) {
+#ifdef HAVE_IO_URING
+  std::unique_ptr<IoUringEngine> engine(new IoUringEngine);
+  if (engine->Init(queue_depth)) return engine.release();
+  WLOG<< "io_uring not available, use thread pool for aio";
+#endif
+
+  return NewThreadPoolEngine(thread_num);
+}
+
+AioEngine* AioEngine::NewThreadPoolEngine(uint32 thread_num) {
+  return new ThreadPoolEngine(thread_num);
+}
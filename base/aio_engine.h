@@ -0,0 +1,93 @@
+#pragma once
+
+#include "data_types.h"
+#include "thread_util.h"
+
+#include <sys/uio.h>
+#include <sys/types.h>
+
+#include <vector>
+#include <functional>
+
+/*
+ * batched asynchronous file io.
+ *
+ *   io_uring is used if the kernel supports it, otherwise reads and writes
+ *   are done by pread/pwrite in a thread pool.  callbacks are always run in
+ *   the thread calling poll() (or submit(), when the ring is full).
+ *
+ *   std::unique_ptr<AioEngine> aio(AioEngine::New());
+ *   AioEngine::Request req;
+ *   req.fd = fd; req.buf = buf; req.len = len; req.offset = 0;
+ *   req.cb = [](int32 res) { ... };  // bytes transferred or -errno
+ *   aio->submit(&req, 1);
+ *   aio->wait();
+ *
+ * not threadsafe, submit() and poll() should be called in one thread.
+ */
+class AioEngine {
+  public:
+    // bytes transferred, may be short like pread(2), or -errno on error.
+    typedef std::function<void(int32 res)> Callback;
+
+    struct Request {
+      Request()
+          : fd(kInvalidFd), write(false), buf(NULL), len(0), offset(0),
+            buf_index(-1) {
+      }
+
+      int fd;
+      bool write;
+      char* buf;
+      uint32 len;
+      off_t offset;
+
+      // index of the registered buffer @buf lies in, -1 if not registered.
+      int buf_index;
+
+      Callback cb;
+    };
+
+    virtual ~AioEngine() {
+    }
+
+    // io_uring if possible, thread pool with @thread_num threads otherwise.
+    static AioEngine* New(uint32 queue_depth = 128, uint32 thread_num = 4);
+
+    // thread pool only, mainly for test.
+    static AioEngine* NewThreadPoolEngine(uint32 thread_num = 4);
+
+    virtual const char* name() const = 0;
+
+    // pin buffers in kernel, so requests with buf_index won't map pages
+    // for every io.  only one set of buffers can be registered.
+    virtual bool registerBuffers(const std::vector<struct iovec>& bufs) = 0;
+
+    virtual bool submit(Request* reqs, uint32 n) = 0;
+
+    // run callbacks of completed requests, wait for at least @min_complete
+    // of them.  return number of callbacks run.
+    virtual uint32 poll(uint32 min_complete = 0) = 0;
+
+    // number of requests not yet completed.
+    uint32 pending() const {
+      return _pending;
+    }
+
+    // poll until all requests completed.
+    void wait() {
+      while (_pending != 0) {
+        poll(1);
+      }
+    }
+
+  protected:
+    AioEngine()
+        : _pending(0) {
+    }
+
+    uint32 _pending;
+
+  private:
+    DISALLOW_COPY_AND_ASSIGN(AioEngine);
+};
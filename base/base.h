@@ -10,12 +10,15 @@
 
 #include "random.h"
 #include "stream_buf.h"
+#include "small_vector.h"
 #include "net_util.h"
 #include "time_util.h"
 #include "file_util.h"
+#include "aio_engine.h"
 #include "string_util.h"
 #include "thread_util.h"
 #include "signal_util.h"
+#include "histogram.h"
 
 #include "hash/md5.h"
 #include "hash/crc16.h"
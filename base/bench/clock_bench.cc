@@ -0,0 +1,57 @@
+#include "base/hash/bench/bench.h"
+
+namespace bench {
+
+// ns to read each clock.
+void clockBench() {
+  std::vector<std::string> cols = { "ns" };
+  printHeader("clock", cols, "ns", "clock");
+
+  printRow("utc.us", { nsPerCall([]() { use(sys::utc.us()); }) });
+  printRow("local_time.us", { nsPerCall([]() {
+    use(sys::local_time.us());
+  }) });
+  printRow("mono", { nsPerCall([]() { use(sys::mono_clock.ns()); }) });
+  printRow("mono coarse", { nsPerCall([]() {
+    use(sys::mono_clock.coarse_ns());
+  }) });
+  printRow("mono tsc", { nsPerCall([]() {
+    use(sys::mono_clock.tsc_ns());
+  }) });
+  printRow("cached_now.ms", { nsPerCall([]() {
+    use(sys::cached_now.ms());
+  }) });
+}
+
+
+// ns to format a time with local_time::to_string() (strftime) and with
+// time_formatter, for the same second and for a new second each call.
+void timeBench() {
+  std::vector<std::string> cols = { "strftime", "same sec", "next sec" };
+  printHeader("time", cols, "ns", "format");
+
+  static const struct {
+    const char* name;
+    const char* format;
+  } kFormats[] = {
+    { "default", "%Y-%m-%d %H:%M:%S" },
+    { "level log", "%m%d %H:%M:%S" },
+    { "http date", "%a, %d %b %Y %H:%M:%S GMT" },
+  };
+
+  for (auto& x : kFormats) {
+    const char* format = x.format;
+    int64 sec = sys::local_time.sec();
+    sys::time_formatter f(format);
+    char buf[64];
+
+    double a = nsPerCall([&]() {
+      use(sys::local_time.to_string(sec, format).size());
+    });
+    double b = nsPerCall([&]() { use(f.format(sec, buf, sizeof(buf))); });
+    double c = nsPerCall([&]() { use(f.format(++sec, buf, sizeof(buf))); });
+    printRow(x.name, { a, b, c });
+  }
+}
+
+}
@@ -0,0 +1,56 @@
+#include "base/hash/bench/bench.h"
+
+namespace bench {
+
+// ns to match a path against all of @n whitelist patterns.
+void globBench() {
+  std::vector<std::string> cols = { "pattern_match", "GlobPattern",
+                                    "GlobSet" };
+  printHeader("glob", cols, "ns", "patterns");
+
+  const std::string paths[] = {
+    "/api/v2/users/12345/profile.json",
+    "/static/img/logo-large.png",
+    "/not/listed/anywhere",
+  };
+
+  for (int n : { 16, 256 }) {
+    std::vector<std::string> pats;
+    for (int i = 0; i < n; ++i) {
+      const std::string k = util::to_string(i);
+      switch (i % 4) {
+        case 0: pats.push_back("/api/v" + k + "/*"); break;
+        case 1: pats.push_back("*." + k + "x"); break;
+        case 2: pats.push_back("/static/" + k + "/*.png"); break;
+        case 3: pats.push_back("/user?/" + k + "/*/profile"); break;
+      }
+    }
+    pats.push_back("/api/v2/users/*/profile.json");
+    pats.push_back("/static/img/*.png");
+
+    std::vector<util::GlobPattern*> compiled;
+    for (auto& p : pats) compiled.push_back(new util::GlobPattern(p));
+    util::GlobSet set(pats);
+
+    std::vector<double> row;
+    row.push_back(nsPerCall([&]() {
+      for (auto& s : paths) {
+        for (auto& p : pats) use(util::pattern_match(p, s));
+      }
+    }) / 3);
+    row.push_back(nsPerCall([&]() {
+      for (auto& s : paths) {
+        for (auto p : compiled) use(p->match(s));
+      }
+    }) / 3);
+    std::vector<uint32> v;
+    row.push_back(nsPerCall([&]() {
+      for (auto& s : paths) use(set.match(s, &v));
+    }) / 3);
+    printRow(util::to_string(pats.size()), row);
+
+    for (auto p : compiled) delete p;
+  }
+}
+
+}
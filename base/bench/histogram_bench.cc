@@ -0,0 +1,17 @@
+#include "base/hash/bench/bench.h"
+
+namespace bench {
+
+// ns to record a value, and to take a snapshot of a histogram.
+void histogramBench() {
+  std::vector<std::string> cols = { "ns" };
+  printHeader("histogram", cols, "ns", "op");
+
+  Histogram* h = NamedHistogram("bench.histogram");
+  uint64 v = 0;
+  printRow("record", { nsPerCall([&]() { h->record(v++ & 0xfffff); }) });
+  printRow("HIST_TIMER", { nsPerCall([]() { HIST_TIMER("bench.timer"); }) });
+  printRow("snapshot", { nsPerCall([&]() { use(h->snapshot().count()); }) });
+}
+
+}
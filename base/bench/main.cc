@@ -0,0 +1,44 @@
+#include "base/hash/bench/bench.h"
+
+DEF_string(bench, "all", "comma separated cases to run: all, split, parse, "
+                         "replace, glob, url, clock, time, histogram");
+
+namespace bench {
+void splitBench();
+void parseBench();
+void replaceBench();
+void globBench();
+void urlBench();
+void clockBench();
+void timeBench();
+void histogramBench();
+}
+
+int main(int argc, char** argv) {
+  ccflag::init_ccflag(argc, argv);
+  cclog::init_cclog(*argv);
+
+  static const struct {
+    const char* name;
+    void (*fun)();
+  } kCases[] = {
+    { "split", bench::splitBench },
+    { "parse", bench::parseBench },
+    { "replace", bench::replaceBench },
+    { "glob", bench::globBench },
+    { "url", bench::urlBench },
+    { "clock", bench::clockBench },
+    { "time", bench::timeBench },
+    { "histogram", bench::histogramBench },
+  };
+
+  auto names = util::split_string(FLG_bench, ',');
+  for (auto& c : kCases) {
+    if (FLG_bench == "all" ||
+        std::find(names.begin(), names.end(), c.name) != names.end()) {
+      c.fun();
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,72 @@
+#include "base/hash/bench/bench.h"
+
+#include <stdlib.h>
+
+namespace bench {
+
+// ns to parse each input, strtoll() and strtod() as the baseline.
+void parseBench() {
+  struct Input {
+    const char* name;
+    std::string s;
+    bool fp;
+  };
+  const Input inputs[] = {
+    { "port", "8080", false },
+    { "slot", "16383", false },
+    { "int64", "1234567890123456", false },
+    { "negative", "-42", false },
+    { "unit", "64k", false },
+    { "hex", "0x7fffffff", false },
+    { "double", "3.14159", true },
+    { "exponent", "-2.5e-3", true },
+    { "long double", "0.30000000000000004441", true },
+  };
+
+  std::vector<std::string> cols = { "strto*", "string,err", "char*,len" };
+  printHeader("parse", cols, "ns", "input");
+
+  for (auto& in : inputs) {
+    const std::string& s = in.s;
+    std::vector<double> row;
+
+    if (in.fp) {
+      double x = 0, y = 0;
+      std::string err;
+      CHECK(util::to_double(s, &x, err));
+      CHECK_EQ(util::to_double(s.data(), s.size(), &y), util::PARSE_OK);
+      CHECK_EQ(x, y);
+
+      row.push_back(nsPerCall([&]() {
+        use(::strtod(s.c_str(), NULL) > 0);
+      }));
+      row.push_back(nsPerCall([&]() {
+        std::string err;
+        use(util::to_double(s, &x, err) && x > 0);
+      }));
+      row.push_back(nsPerCall([&]() {
+        use(util::to_double(s.data(), s.size(), &y) + (y > 0));
+      }));
+    } else {
+      int64 x = 0, y = 0;
+      std::string err;
+      CHECK(util::to_int64(s, &x, err));
+      CHECK_EQ(util::to_int64(s.data(), s.size(), &y), util::PARSE_OK);
+      CHECK_EQ(x, y);
+
+      row.push_back(nsPerCall([&]() {
+        use(::strtoll(s.c_str(), NULL, 0));
+      }));
+      row.push_back(nsPerCall([&]() {
+        std::string err;
+        use(util::to_int64(s, &x, err) + x);
+      }));
+      row.push_back(nsPerCall([&]() {
+        use(util::to_int64(s.data(), s.size(), &y) + y);
+      }));
+    }
+    printRow(in.name, row);
+  }
+}
+
+}
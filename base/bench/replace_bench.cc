@@ -0,0 +1,55 @@
+#include "base/hash/bench/bench.h"
+#include "util/replacer.h"
+
+namespace bench {
+
+// the find and replace loop Replacer used before, pattern by pattern.
+static void replaceEach(const std::map<std::string, std::string>& m,
+                        std::string* s) {
+  for (auto it = m.begin(); it != m.end(); ++it) {
+    size_t pos;
+    while ((pos = s->find(it->first)) != std::string::npos) {
+      s->replace(pos, it->first.size(), it->second);
+    }
+  }
+}
+
+// ns to render a template of @size bytes with 4 or 32 variables.
+void replaceBench() {
+  std::vector<std::string> cols = { "find+replace", "ReplacePatterns" };
+  printHeader("replace", cols, "ns", "template");
+
+  for (int vars : { 4, 32 }) {
+    std::map<std::string, std::string> m;
+    for (int i = 0; i < vars; ++i) {
+      m["{{var" + util::to_string(i) + "}}"] = "value" + util::to_string(i);
+    }
+    util::ReplacePatterns p(m);
+
+    for (int size : { 1024, 16384 }) {
+      std::string tpl;
+      for (int i = 0; tpl.size() < static_cast<size_t>(size); ++i) {
+        tpl += "<div class=\"row\">{{var" + util::to_string(i % vars) +
+            "}}</div>\n";
+      }
+
+      std::string expected = tpl;
+      replaceEach(m, &expected);
+      CHECK_EQ(p.replace(tpl), expected);
+
+      std::vector<double> row;
+      row.push_back(nsPerCall([&]() {
+        std::string s = tpl;
+        replaceEach(m, &s);
+        use(s.size());
+      }));
+      row.push_back(nsPerCall([&]() {
+        use(p.replace(tpl).size());
+      }));
+      printRow(util::to_string(vars) + "vars/" + util::to_string(size),
+               row);
+    }
+  }
+}
+
+}
@@ -0,0 +1,78 @@
+#include "base/hash/bench/bench.h"
+#include "base/small_vector.h"
+
+namespace bench {
+
+// ns to split each input.
+void splitBench() {
+  std::string csv;
+  for (int i = 0; i < 64; ++i) {
+    csv += "field" + util::to_string(i * 7919) + ",";
+  }
+  std::string log;
+  for (int i = 0; i < 32; ++i) {
+    log += "key" + util::to_string(i) + " => value" + util::to_string(i);
+    log += " || ";
+  }
+
+  struct Input {
+    const char* name;
+    std::string s;
+    std::string separ;
+  };
+  const Input inputs[] = {
+    { "moved", "MOVED 3999 127.0.0.1:6381", " " },
+    { "slots", "0~5460 127.0.0.1:7000,127.0.0.1:7003", " " },
+    { "csv", csv, "," },
+    { "log", log, " || " },
+  };
+
+  std::vector<std::string> cols = { "split_string", "split_view",
+                                    "Tokenizer" };
+  printHeader("split", cols, "ns", "input");
+
+  for (auto& in : inputs) {
+    const std::string& s = in.s;
+    const std::string& separ = in.separ;
+
+    // the same fields.
+    SmallVector<util::StringView, 16> v;
+    auto expected = in.separ.size() == 1 ? util::split_string(s, separ[0]) :
+        util::split_string(s, separ);
+    util::split_view(s, separ, &v);
+    CHECK_EQ(v.size(), expected.size());
+    for (size_t i = 0; i < v.size(); ++i) CHECK(v[i] == expected[i]);
+
+    std::vector<double> row;
+    if (separ.size() == 1) {
+      row.push_back(nsPerCall([&]() {
+        use(util::split_string(s, separ[0]).size());
+      }));
+      row.push_back(nsPerCall([&]() {
+        util::split_view(s, separ[0], &v);
+        use(v.size());
+      }));
+      row.push_back(nsPerCall([&]() {
+        size_t n = 0;
+        for (auto& f : util::Tokenizer(s, separ[0])) n += f.size();
+        use(n);
+      }));
+    } else {
+      row.push_back(nsPerCall([&]() {
+        use(util::split_string(s, separ).size());
+      }));
+      row.push_back(nsPerCall([&]() {
+        util::split_view(s, separ, &v);
+        use(v.size());
+      }));
+      row.push_back(nsPerCall([&]() {
+        size_t n = 0;
+        for (auto& f : util::Tokenizer(s, separ)) n += f.size();
+        use(n);
+      }));
+    }
+    printRow(in.name, row);
+  }
+}
+
+}
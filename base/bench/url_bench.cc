@@ -0,0 +1,56 @@
+#include "base/hash/bench/bench.h"
+#include "util/url_coder.h"
+
+namespace bench {
+
+// ns to encode and decode a query string, a string returned or in a
+// caller buffer.
+void urlBench() {
+  std::string plain = "q=hello world&lang=zh-CN&page=2&sort=date";
+  std::string form;
+  for (int i = 0; form.size() < 2048; ++i) {
+    form += "field" + util::to_string(i) + "=" +
+        "some_long_value_without_escapes_" + util::to_string(i * 31) + "&";
+  }
+  form += "note=a b/c?d";
+
+  struct Input {
+    const char* name;
+    std::string s;
+  };
+  const Input inputs[] = {
+    { "query", plain },
+    { "form", form },
+  };
+
+  std::vector<std::string> cols = { "encode_url", "encode buf",
+                                    "decode_url", "decode inplace" };
+  printHeader("url", cols, "ns", "input");
+
+  for (auto& in : inputs) {
+    const std::string& s = in.s;
+    const std::string enc = util::encode_url(s);
+    CHECK_EQ(util::decode_url(enc), s);
+
+    std::vector<char> buf(util::encode_url_bound(s.size()));
+    std::string tmp;
+
+    std::vector<double> row;
+    row.push_back(nsPerCall([&]() {
+      use(util::encode_url(s).size());
+    }));
+    row.push_back(nsPerCall([&]() {
+      use(util::encode_url(s.data(), s.size(), buf.data()));
+    }));
+    row.push_back(nsPerCall([&]() {
+      use(util::decode_url(enc).size());
+    }));
+    row.push_back(nsPerCall([&]() {
+      tmp.assign(enc);
+      use(util::decode_url(&tmp));
+    }));
+    printRow(in.name, row);
+  }
+}
+
+}
@@ -78,7 +78,7 @@ Logger::Logger(uint32 ms)
         new StoppableThread(std::bind(&Logger::thread_fun, this), _ms));
     _log_thread->start();
 
-    int64 sec = sys::local_time.sec();
+    int64 sec = sys::cached_now.local_sec();
     _last_day = sec / 86400;
     _last_hour = sec / 3600;
 }
@@ -113,7 +113,7 @@ void Logger::stop() {
 
 class TaggedLogger : public Logger {
   public:
-    TaggedLogger() : Logger(500) {
+    TaggedLogger() : Logger(500), _time_fmt("%Y-%m-%d %H:%M:%S") {
     }
 
     virtual ~TaggedLogger() {
@@ -143,6 +143,7 @@ class TaggedLogger : public Logger {
   private:
     std::map<const char*, sys::wfile> _files;
     std::map<const char*, int> _strategy;
+    sys::time_formatter _time_fmt;  // used by the logging thread only
 
     void log_to_file(const std::string& time, TaggedLog* log);
 
@@ -179,7 +180,7 @@ inline void TaggedLogger::log_to_file(const std::string& time, TaggedLog* log) {
 }
 
 void TaggedLogger::write_logs(std::vector<void*>& logs) {
-    std::string time(sys::local_time.to_string()); // yyyy-mm-dd hh:mm:ss
+    std::string time(_time_fmt.to_string(sys::cached_now.local_sec()));
 
     for (::size_t i = 0; i < logs.size(); ++i) {
         TaggedLog* log = (TaggedLog*) logs[i];
@@ -189,7 +190,7 @@ void TaggedLogger::write_logs(std::vector<void*>& logs) {
 }
 
 void TaggedLogger::flush_log_files() {
-    uint64 ms = sys::local_time.ms() + _ms;
+    uint64 ms = sys::cached_now.local_ms() + _ms;
     uint32 day = ms / (86400 * 1000);
     uint32 hour = ms / (3600 * 1000);
 
@@ -243,6 +244,7 @@ class LevelLogger : public Logger {
     std::vector<sys::wfile> _files;
     std::vector<int> _index;
     std::unique_ptr<FailureHandler> _failure_handler;
+    sys::time_formatter _time_fmt;  // used by the logging thread only
 
     void log_to_file(const std::string& time, LevelLog* log);
     void log_to_stderr(const std::string& time, LevelLog* log);
@@ -254,7 +256,7 @@ class LevelLogger : public Logger {
     virtual void write_logs(std::vector<void*>& logs);
 };
 
-LevelLogger::LevelLogger() : Logger(1000) {
+LevelLogger::LevelLogger() : Logger(1000), _time_fmt("%m%d %H:%M:%S") {
     _files.resize(FATAL + 1);
     _index.resize(FATAL + 1);
     this->install_signal_handler();
@@ -334,7 +336,7 @@ inline void LevelLogger::log_to_stderr(const std::string& time, LevelLog* log) {
 }
 
 void LevelLogger::write_logs(std::vector<void*>& logs) {
-    std::string time(sys::local_time.to_string("%m%d %H:%M:%S"));
+    std::string time(_time_fmt.to_string(sys::cached_now.local_sec()));
 
     if (!FLG_log2stderr && !FLG_alsolog2stderr) { /* default: log to file */
         for (::size_t i = 0; i < logs.size(); ++i) {
@@ -399,7 +401,7 @@ void LevelLogger::push_fatal_log(LevelLog* log) {
 #undef WRITE_LOGS
 
 void LevelLogger::flush_log_files() {
-    uint32 day = sys::local_time.sec() / 86400;
+    uint32 day = sys::cached_now.local_sec() / 86400;
 
     // reset index on new day
     if (day != _last_day) {
@@ -420,7 +422,7 @@ void LevelLogger::flush_log_files() {
 
 class KLogger : public Logger {
   public:
-    KLogger() : Logger(500) {
+    KLogger() : Logger(500), _time_fmt("%Y-%m-%d %H:%M:%S") {
     }
 
     virtual ~KLogger() {
@@ -460,6 +462,7 @@ class KLogger : public Logger {
     std::function<void(const char*, const char*, uint32)> _log_cb;
     std::function<void()> _flush_cb;
     std::function<void()> _failure_cb;
+    sys::time_formatter _time_fmt;  // used by the logging thread only
 };
 
 void KLogger::log_to_file(const std::string& time, KLog* log) {
@@ -472,7 +475,7 @@ void KLogger::flush_log_files() {
 }
 
 void KLogger::write_logs(std::vector<void*>& logs) {
-    std::string time = sys::local_time.to_string();
+    std::string time = _time_fmt.to_string(sys::cached_now.local_sec());
 
     for (auto i = 0; i < logs.size(); ++i) {
         KLog* log = (KLog*) logs[i];
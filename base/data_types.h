@@ -43,6 +43,9 @@ inline T abs(T t) {
     Type(const Type&) ; \
     void operator=(const Type&)
 
+#define DISALLOW_ASSIGN(Type) \
+    void operator=(const Type&)
+
 template<typename To, typename From>
 inline To cstyle_cast(From f) {
     return (To) f;
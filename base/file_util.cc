@@ -6,6 +6,9 @@
 #include <fcntl.h>
 #include <cstring>
 #include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
 
 namespace {
 
@@ -209,14 +212,14 @@ int32 SequentialReadonlyFile::read(char* buf, uint32 len) {
 
 bool RandomAccessFile::Init() {
   if (_fd != kInvalidFd) return true;
-  return openFile(_fpath, &_fd, O_RDWR);
+  return openFile(_fpath, &_fd, _mode == READ_ONLY ? O_RDONLY : O_RDWR);
 }
 
 int32 RandomAccessFile::read(char* buf, uint32 len, off_t offset) {
   uint32 left = len;
   while (left > 0) {
     int32 readn = ::pread(_fd, buf, left, offset);
-    if (readn == 0) return 0;
+    if (readn == 0) break;
     else if (readn == -1) {
       if (errno == EINTR) continue;
       WLOG<< "pread error, path: " << _fpath;
@@ -255,6 +258,33 @@ int32 RandomAccessFile::write(const char* buf, uint32 len, off_t offset) {
   return len - left;
 }
 
+bool RandomAccessFile::asyncRead(AioEngine* aio, char* buf, uint32 len,
+                                 off_t offset, AioEngine::Callback cb) {
+  if (_fd == kInvalidFd) return false;
+
+  AioEngine::Request req;
+  req.fd = _fd;
+  req.buf = buf;
+  req.len = len;
+  req.offset = offset;
+  req.cb = cb;
+  return aio->submit(&req, 1);
+}
+
+bool RandomAccessFile::asyncWrite(AioEngine* aio, const char* buf, uint32 len,
+                                  off_t offset, AioEngine::Callback cb) {
+  if (_fd == kInvalidFd) return false;
+
+  AioEngine::Request req;
+  req.fd = _fd;
+  req.write = true;
+  req.buf = const_cast<char*>(buf);
+  req.len = len;
+  req.offset = offset;
+  req.cb = cb;
+  return aio->submit(&req, 1);
+}
+
 bool AppendonlyFile::Init() {
   _stream = ::fopen(_fpath.c_str(), "a");
   if (_stream == NULL) {
@@ -388,6 +418,105 @@ void AppendonlyMmapedFile::unMap() {
   }
 }
 
+MmapReadonlyFile::~MmapReadonlyFile() {
+  if (_mem != NULL) {
+    ::munmap(_mem, _size);
+    _mem = NULL;
+  }
+  closeWrapper(_fd);
+}
+
+bool MmapReadonlyFile::Init() {
+  if (_fd != kInvalidFd) return false;
+  if (!openFile(_fpath, &_fd, O_RDONLY | O_CLOEXEC)) return false;
+  if (!FileSize(_fd, &_size)) {
+    closeWrapper(_fd);
+    return false;
+  }
+  if (_size == 0) return true;
+
+  int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+  if (_flags & POPULATE) flags |= MAP_POPULATE;
+#endif
+  void* mem = Mmap(NULL, _size, PROT_READ, flags, _fd, 0);
+  if (mem == MAP_FAILED) {
+    WLOG<< "mmap64 error, path: " << _fpath << ", " << ::strerror(errno);
+    closeWrapper(_fd);
+    return false;
+  }
+  _mem = (char*) mem;
+
+  if (_flags & SEQUENTIAL) advise(MADV_SEQUENTIAL);
+  if (_flags & WILLNEED) advise(MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+  // only works if the kernel supports THP for page cache, not fatal.
+  if (_flags & HUGEPAGE) advise(MADV_HUGEPAGE);
+#endif
+  return true;
+}
+
+bool MmapReadonlyFile::advise(int advice, uint64 offset, uint64 len) {
+  if (_mem == NULL || offset >= _size) return false;
+  if (len == 0 || len > _size - offset) len = _size - offset;
+
+  // madvise requires page aligned address.
+  static const uint64 kPageSize = ::sysconf(_SC_PAGESIZE);
+  uint64 aligned = offset / kPageSize * kPageSize;
+  int ret = ::madvise(_mem + aligned, len + (offset - aligned), advice);
+  if (ret != 0) {
+    WLOG<< "madvise error, path: " << _fpath << ", advice: " << advice
+        << ", " << ::strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+void MmapReadonlyFile::prefault(uint64 offset, uint64 len) {
+#ifdef MADV_POPULATE_READ
+  if (advise(MADV_POPULATE_READ, offset, len)) return;
+#endif
+
+  static const uint64 kPageSize = ::sysconf(_SC_PAGESIZE);
+  volatile char dummy = 0;
+  for (uint64 pos = offset; pos < offset + len; pos += kPageSize) {
+    dummy += _mem[pos];
+  }
+  (void) dummy;
+}
+
+bool MmapReadonlyFile::prefault(uint32 thread_num) {
+  if (_mem == NULL) return false;
+
+  // at least 16M for each thread.
+  const uint64 kMinChunk = 16ULL << 20;
+  if (thread_num == 0) thread_num = 1;
+  thread_num = std::min<uint64>(thread_num, (_size + kMinChunk - 1) / kMinChunk);
+  if (thread_num <= 1) {
+    prefault(0, _size);
+    return true;
+  }
+
+  static const uint64 kPageSize = ::sysconf(_SC_PAGESIZE);
+  uint64 chunk = (_size / thread_num + kPageSize - 1) / kPageSize * kPageSize;
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (uint64 offset = 0; offset < _size; offset += chunk) {
+    uint64 len = std::min(chunk, _size - offset);
+    void (MmapReadonlyFile::*fun)(uint64, uint64) = &MmapReadonlyFile::prefault;
+    threads.emplace_back(new Thread(std::bind(fun, this, offset, len)));
+    if (!threads.back()->start()) {
+      WLOG<< "start prefault thread error, path: " << _fpath;
+      threads.pop_back();
+      prefault(offset, len);
+    }
+  }
+
+  for (auto it = threads.begin(); it != threads.end(); ++it) {
+    (*it)->join();
+  }
+  return true;
+}
+
 bool DirIterator::Init() {
   if (_dir != NULL) return false;
 
@@ -441,6 +570,110 @@ const std::string* DirIterator::next() {
   return NULL;
 }
 
+namespace {
+// see getdents64(2), glibc < 2.30 has no wrapper for it.
+struct linux_dirent64 {
+  uint64 d_ino;
+  int64 d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[];
+};
+}
+
+bool DirWalker::Init() {
+  if (!IsDir(_fpath)) {
+    WLOG<< "not a dir, path: " << _fpath;
+    return false;
+  }
+  return true;
+}
+
+bool DirWalker::walk(std::vector<Entry>* entries, bool sorted) {
+  entries->clear();
+  _entries = entries;
+  _failed = false;
+
+  if (_recursive && _thread_num > 1) {
+    _pool.reset(new ThreadPool(_thread_num));
+    walkDir(std::string());
+    _pool->wait();
+    _pool.reset();
+  } else {
+    walkDir(std::string());
+  }
+
+  _entries = NULL;
+  if (sorted) std::sort(entries->begin(), entries->end());
+  return !_failed;
+}
+
+void DirWalker::walkDir(const std::string& rel_path) {
+  const std::string path =
+      rel_path.empty() ? _fpath : _fpath + "/" + rel_path;
+  int fd;
+  if (!openFile(path, &fd, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) {
+    MutexGuard g(_mutex);
+    _failed = true;
+    return;
+  }
+
+  std::vector<Entry> entries;
+  std::unique_ptr<char[]> buf(new char[kBatchSize]);
+  while (true) {
+    long readn = ::syscall(SYS_getdents64, fd, buf.get(), kBatchSize);
+    if (readn == 0) break;
+    if (readn == -1) {
+      if (errno == EINTR) continue;
+      WLOG<< "getdents64 error, path: " << path << ", " << ::strerror(errno);
+      MutexGuard g(_mutex);
+      _failed = true;
+      break;
+    }
+
+    for (long pos = 0; pos < readn;) {
+      auto d = reinterpret_cast<linux_dirent64*>(buf.get() + pos);
+      pos += d->d_reclen;
+
+      const char* name = d->d_name;
+      if (name[0] == '.' && (name[1] == '\0'
+          || (name[1] == '.' && name[2] == '\0'))) {
+        continue;
+      }
+
+      uint8 type = d->d_type;
+      if (type == DT_UNKNOWN) {
+        // some file systems don't fill d_type.
+        struct stat st;
+        if (::fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0) {
+          type = IFTODT(st.st_mode);
+        }
+      }
+
+      Entry e;
+      e.path = rel_path.empty() ? name : rel_path + "/" + name;
+      e.type = type;
+      if (_filter && !_filter(e.path, e.type)) continue;
+
+      if (type == DT_DIR && _recursive) {
+        if (_pool != NULL) {
+          _pool->run(std::bind(&DirWalker::walkDir, this, e.path));
+        } else {
+          walkDir(e.path);
+        }
+      }
+
+      entries.push_back(std::move(e));
+    }
+  }
+  closeWrapper(fd);
+
+  MutexGuard g(_mutex);
+  for (auto it = entries.begin(); it != entries.end(); ++it) {
+    _entries->push_back(std::move(*it));
+  }
+}
+
 bool FileLocker::openFile(int mode) {
   CHECK_EQ(_fd, kInvalidFd);
   if (FileExist(_path)) {
@@ -487,3 +720,167 @@ void FileLocker::unLock() {
     ::abort();
   }
 }
+
+namespace sys {
+
+line_reader::line_reader(uint32 buf_size)
+    : _fd(-1), _eof(false), _cap(buf_size), _beg(0), _end(0), _scan(0) {
+    if (_cap < 64) _cap = 64;
+    _buf = (char*) ::malloc(_cap);
+    CHECK_NOTNULL(_buf);
+}
+
+line_reader::~line_reader() {
+    this->close();
+    ::free(_buf);
+}
+
+bool line_reader::open(const std::string& path) {
+    this->close();
+
+    _fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (_fd == -1) return false;
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    ::posix_fadvise(_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    return true;
+}
+
+void line_reader::close() {
+    if (_fd != -1) {
+        ::close(_fd);
+        _fd = -1;
+    }
+
+    _eof = false;
+    _beg = _end = _scan = 0;
+}
+
+bool line_reader::fill() {
+    if (_beg != 0) {
+        ::memmove(_buf, _buf + _beg, _end - _beg);
+        _end -= _beg;
+        _scan -= _beg;
+        _beg = 0;
+    }
+
+    // the line is longer than the buffer
+    if (_end == _cap) {
+        char* p = (char*) ::realloc(_buf, _cap * 2);
+        if (p == NULL) return false;
+        _buf = p;
+        _cap *= 2;
+    }
+
+    while (true) {
+        ssize_t r = ::read(_fd, _buf + _end, _cap - _end);
+        if (r > 0) {
+            _end += r;
+            return true;
+        }
+
+        if (r == -1 && errno == EINTR) continue;
+
+        _eof = true;
+        return false;
+    }
+}
+
+bool line_reader::next(const char** s, uint32* n) {
+    if (_fd == -1) return false;
+
+    while (true) {
+        char* p = (char*) ::memchr(_buf + _scan, '\n', _end - _scan);
+        if (p != NULL) {
+            *s = _buf + _beg;
+            *n = static_cast<uint32>(p - *s);
+            _beg = _scan = static_cast<uint32>(p - _buf) + 1;
+            return true;
+        }
+
+        _scan = _end;
+        if (!_eof && this->fill()) continue;
+
+        // the last line without '\n'
+        if (_beg == _end) return false;
+
+        *s = _buf + _beg;
+        *n = _end - _beg;
+        _beg = _scan = _end;
+        return true;
+    }
+}
+
+std::vector<std::pair<uint64, uint64>> split_lines(const char* data,
+                                                   uint64 size, uint32 n) {
+    std::vector<std::pair<uint64, uint64>> v;
+    if (size == 0) return v;
+    if (n == 0) n = 1;
+
+    uint64 chunk = (size + n - 1) / n;
+    uint64 beg = 0;
+
+    while (beg < size) {
+        uint64 end = beg + chunk;
+        if (end >= size) {
+            end = size;
+        } else {
+            // extend to the end of the line
+            const char* p = (const char*) ::memchr(data + end - 1, '\n',
+                                                   size - end + 1);
+            end = (p == NULL) ? size : (p - data) + 1;
+        }
+
+        v.push_back(std::make_pair(beg, end - beg));
+        beg = end;
+    }
+
+    return v;
+}
+
+namespace {
+void scan_range(const char* data, uint64 len, uint32 i,
+                std::function<void(uint32, const char*, uint32)>* cb) {
+    const char* end = data + len;
+    while (data < end) {
+        const char* p = (const char*) ::memchr(data, '\n', end - data);
+        if (p == NULL) p = end;
+
+        (*cb)(i, data, static_cast<uint32>(p - data));
+        data = p + 1;
+    }
+}
+} // namespace
+
+bool scan_lines(const std::string& path, uint32 n,
+                std::function<void(uint32, const char*, uint32)> cb) {
+    MmapReadonlyFile file(path, MmapReadonlyFile::SEQUENTIAL
+        | MmapReadonlyFile::WILLNEED);
+    if (!file.Init()) return false;
+
+    auto ranges = split_lines(file.data(), file.size(), n);
+    if (ranges.size() <= 1) {
+        if (!ranges.empty()) scan_range(file.data(), file.size(), 0, &cb);
+        return true;
+    }
+
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (uint32 i = 0; i < ranges.size(); ++i) {
+        threads.emplace_back(new Thread(std::bind(
+            &scan_range, file.data() + ranges[i].first, ranges[i].second, i,
+            &cb)));
+        if (!threads.back()->start()) {
+            WLOG<< "start scan thread error, path: " << path;
+            threads.pop_back();
+            scan_range(file.data() + ranges[i].first, ranges[i].second, i, &cb);
+        }
+    }
+
+    for (uint32 i = 0; i < threads.size(); ++i) {
+        threads[i]->join();
+    }
+    return true;
+}
+
+} // namespace sys
@@ -2,16 +2,20 @@
 
 #include "data_types.h"
 #include "cclog/cclog.h"
+#include "thread_util.h"
+#include "aio_engine.h"
 
 #include <cstdio>
 #include <dirent.h>
 #include <unistd.h>
 #include <errno.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 
 #include <string>
-#include <fstream>
 #include <vector>
+#include <memory>
+#include <functional>
 
 namespace sys {
 const char path_separ = '/';
@@ -127,16 +131,78 @@ class file_base {
     //DISALLOW_COPY_AND_ASSIGN(file_base);
 };
 
+/*
+ * buffered line reader, reads by large blocks and finds '\n' with memchr.
+ *
+ *   sys::line_reader r;
+ *   if (r.open(path)) {
+ *       const char* s;
+ *       uint32 n;
+ *       while (r.next(&s, &n)) { ... }  // s is valid until the next call
+ *   }
+ */
+class line_reader {
+  public:
+    explicit line_reader(uint32 buf_size = 64 * 1024);
+    ~line_reader();
+
+    line_reader(const line_reader&) = delete;
+    line_reader& operator=(const line_reader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool valid() const {
+        return _fd != -1;
+    }
+
+    /*
+     * '\n' is not included in @s, return false on EOF or error.
+     */
+    bool next(const char** s, uint32* n);
+
+  private:
+    int _fd;
+    bool _eof;
+
+    char* _buf;
+    uint32 _cap;
+    uint32 _beg;   // beginning of the current line
+    uint32 _end;   // end of valid data
+    uint32 _scan;  // no '\n' in [_beg, _scan)
+
+    bool fill();
+};
+
+/*
+ * split [data, data + size) into at most @n ranges of similar size, every
+ * range ends after a '\n' (except the last one), so they can be scanned in
+ * parallel.  return pairs of (offset, length).
+ */
+std::vector<std::pair<uint64, uint64>> split_lines(const char* data,
+                                                   uint64 size, uint32 n);
+
+/*
+ * mmap @path and scan lines of it with @n threads.  @cb(i, s, len) is called
+ * in the i-th thread (or the calling thread if it can't be started), and
+ * lines of the i-th range are passed in order.
+ *
+ *   return false if failed to open the file.
+ */
+bool scan_lines(const std::string& path, uint32 n,
+                std::function<void(uint32, const char*, uint32)> cb);
+
 /*
  * for reading file line by line
  */
 class ifile : public file_base {
   public:
     explicit ifile(const std::string& path)
-        : file_base(path), _ifs(path), _line(0) {
+        : file_base(path), _line(0), _fail(false) {
+        _reader.open(path);
     }
 
-    ifile() : _line(0) {
+    ifile() : _line(0), _fail(false) {
     }
 
     ~ifile() = default;
@@ -147,14 +213,31 @@ class ifile : public file_base {
     ifile(ifile&&) = delete;
     ifile& operator=(ifile&&) = delete;
 
+    /*
+     * false if not opened, or the last getline() reached EOF.
+     */
     bool valid() const {
-        return _ifs;
+        return _reader.valid() && !_fail;
     }
 
     std::string getline() {
-        std::string s;
-        if (std::getline(_ifs, s)) ++_line;
-        return s;
+        const char* s;
+        uint32 n;
+        if (!this->getline(&s, &n)) return std::string();
+        return std::string(s, n);
+    }
+
+    /*
+     * zero-copy version, @s is valid until the next call.
+     */
+    bool getline(const char** s, uint32* n) {
+        if (!_reader.next(s, n)) {
+            _fail = true;
+            return false;
+        }
+
+        ++_line;
+        return true;
     }
 
     int line() const {
@@ -162,12 +245,12 @@ class ifile : public file_base {
     }
 
     void close() {
-        _ifs.close();
+        _reader.close();
     }
 
     bool open(const std::string& path) {
-        _ifs.open(path.c_str());
-        if (!this->valid()) return false;
+        _fail = false;
+        if (!_reader.open(path)) return false;
 
         _line = 0;
         this->update_path(path);
@@ -181,8 +264,9 @@ class ifile : public file_base {
     }
 
   private:
-    std::ifstream _ifs;
+    line_reader _reader;
     int _line;
+    bool _fail;
 };
 
 /*
@@ -408,11 +492,17 @@ class SequentialReadonlyFile : public detail::FileAbstract {
 
 class RandomAccessFile : public detail::FileAbstract {
   public:
-    explicit RandomAccessFile(const std::string& fpath)
-        : FileAbstract(fpath), _fd(kInvalidFd) {
+    enum Mode {
+      READ_WRITE = 0,
+      READ_ONLY,  // for readers, write() fails.
+    };
+
+    explicit RandomAccessFile(const std::string& fpath,
+                              Mode mode = READ_WRITE)
+        : FileAbstract(fpath), _fd(kInvalidFd), _mode(mode) {
     }
     explicit RandomAccessFile(int fd)
-        : detail::FileAbstract("unknown"), _fd(fd) {
+        : detail::FileAbstract("unknown"), _fd(fd), _mode(READ_WRITE) {
     }
     virtual ~RandomAccessFile() {
       closeWrapper(_fd);
@@ -425,12 +515,70 @@ class RandomAccessFile : public detail::FileAbstract {
     bool flush(bool only_flush_data = true);
     int32 write(const char* buf, uint32 len, off_t offset);
 
+    // overlapped io, @cb is run in aio->poll() with bytes transferred
+    // or -errno. @buf must be valid until then.
+    bool asyncRead(AioEngine* aio, char* buf, uint32 len, off_t offset,
+                   AioEngine::Callback cb);
+    bool asyncWrite(AioEngine* aio, const char* buf, uint32 len, off_t offset,
+                    AioEngine::Callback cb);
+
+    int fd() const {
+      return _fd;
+    }
+
   private:
     int _fd;
+    Mode _mode;
 
     DISALLOW_COPY_AND_ASSIGN(RandomAccessFile);
 };
 
+// map the whole file readonly, data() is valid until destructed.
+class MmapReadonlyFile : public detail::FileAbstract {
+  public:
+    enum Flag {
+      NONE = 0,
+      POPULATE = (1 << 0),  // MAP_POPULATE, read the whole file in mmap().
+      WILLNEED = (1 << 1),  // MADV_WILLNEED, start readahead asynchronously.
+      SEQUENTIAL = (1 << 2),  // MADV_SEQUENTIAL, aggressive readahead.
+      HUGEPAGE = (1 << 3),  // MADV_HUGEPAGE, ignored if not supported.
+    };
+
+    explicit MmapReadonlyFile(const std::string& fpath, uint32 flags = NONE)
+        : FileAbstract(fpath), _fd(kInvalidFd), _mem(NULL), _size(0),
+          _flags(flags) {
+    }
+    virtual ~MmapReadonlyFile();
+
+    virtual bool Init();
+
+    // NULL for empty file.
+    const char* data() const {
+      return _mem;
+    }
+    uint64 size() const {
+      return _size;
+    }
+
+    // advise for [offset, offset + len), len = 0 means to the end.
+    bool advise(int advice, uint64 offset = 0, uint64 len = 0);
+
+    // touch every page with @thread_num threads, so the later access
+    // won't trigger page faults. useful for cold start of large files.
+    bool prefault(uint32 thread_num = 4);
+
+  private:
+    int _fd;
+
+    char* _mem;
+    uint64 _size;
+    const uint32 _flags;
+
+    void prefault(uint64 offset, uint64 len);
+
+    DISALLOW_COPY_AND_ASSIGN(MmapReadonlyFile);
+};
+
 class writeableFile : public detail::FileAbstract {
   public:
     explicit writeableFile(const std::string& fpath)
@@ -540,6 +688,58 @@ class DirIterator : public detail::FileAbstract {
     DISALLOW_COPY_AND_ASSIGN(DirIterator);
 };
 
+// list a directory (tree) by getdents64 in large batches, d_type is used
+// to avoid stat(2). sub directories are walked in parallel if thread_num > 1.
+class DirWalker : public detail::FileAbstract {
+  public:
+    struct Entry {
+      std::string path;  // relative to the root dir
+      uint8 type;  // DT_REG, DT_DIR, DT_LNK...
+
+      bool operator<(const Entry& e) const {
+        return path < e.path;
+      }
+    };
+
+    // return false to drop the entry, dropped dirs are not walked into.
+    // may be called in different threads concurrently.
+    typedef std::function<bool(const std::string& path, uint8 type)> Filter;
+
+    explicit DirWalker(const std::string& root, bool recursive = false,
+                       uint32 thread_num = 4)
+        : detail::FileAbstract(root), _recursive(recursive),
+          _thread_num(thread_num) {
+    }
+    virtual ~DirWalker() {
+    }
+
+    virtual bool Init();
+
+    void setFilter(Filter filter) {
+      _filter = filter;
+    }
+
+    // entries are sorted by path if @sorted is true.
+    bool walk(std::vector<Entry>* entries, bool sorted = true);
+
+  private:
+    const bool _recursive;
+    const uint32 _thread_num;
+
+    Filter _filter;
+
+    Mutex _mutex;
+    bool _failed;
+    std::vector<Entry>* _entries;
+    std::unique_ptr<ThreadPool> _pool;
+
+    void walkDir(const std::string& rel_path);
+
+    const static uint32 kBatchSize = 256 * 1024;
+
+    DISALLOW_COPY_AND_ASSIGN(DirWalker);
+};
+
 class FileLocker {
   public:
     explicit FileLocker(const std::string& path)
@@ -1,5 +1,14 @@
 #include "base64.h"
 
+#include <string.h>
+#include <algorithm>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define BASE64_HAVE_SIMD
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
 static const char EnBase64Tab[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
@@ -115,42 +124,410 @@ static int base64_decode(const char* pSrc, int nSrcLen, unsigned char* pDst) {
     *pDst = '\0';
     return nDstLen;
 }
+
+// encode @n bytes, @n is a multiple of 3.
+static char* encode_triples(const unsigned char* pSrc, int n, char* pDst) {
+    for (; n >= 3; n -= 3, pSrc += 3) {
+        *pDst++ = EnBase64Tab[pSrc[0] >> 2];
+        *pDst++ = EnBase64Tab[((pSrc[0] << 4) | (pSrc[1] >> 4)) & 0x3f];
+        *pDst++ = EnBase64Tab[((pSrc[1] << 2) | (pSrc[2] >> 6)) & 0x3f];
+        *pDst++ = EnBase64Tab[pSrc[2] & 0x3f];
+    }
+    return pDst;
+}
+
+/*
+ * SIMD loops return bytes consumed, always whole blocks.
+ *
+ *   encode: 3 bytes -> 4 sextets by shuffle and multiply, sextets -> ascii
+ *           by adding an offset looked up with pshufb.
+ *   decode: validate and translate with nibble lookups, stop at the first
+ *           block with a character out of the alphabet, '=' or a line
+ *           break, which are left to the scalar code.
+ */
+typedef int (*EncodeLoop)(const unsigned char* src, int n, char* dst);
+typedef int (*DecodeLoop)(const char* src, int n, unsigned char* dst);
+
+#ifdef BASE64_HAVE_SIMD
+#define SSE41 __attribute__((target("sse4.1")))
+#define AVX2 __attribute__((target("avx2")))
+
+SSE41 static inline __m128i enc_reshuffle(__m128i in) {
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5,
+                                           3, 4, 1, 2, 0, 1));
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
+}
+
+SSE41 static inline __m128i enc_translate(__m128i in) {
+    const __m128i lut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52,
+                                      '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                      '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                      '/' - 63, 'A', 0, 0);
+    __m128i idx = _mm_subs_epu8(in, _mm_set1_epi8(51));
+    const __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), in);
+    idx = _mm_or_si128(idx, _mm_and_si128(less, _mm_set1_epi8(13)));
+    return _mm_add_epi8(in, _mm_shuffle_epi8(lut, idx));
+}
+
+// 16 bytes are read, 12 encoded.
+SSE41 static inline int encode_sse41_loop(const unsigned char* src, int n,
+                                          char* dst) {
+    int done = 0;
+    for (; n - done >= 16; done += 12, dst += 16) {
+        __m128i in = _mm_loadu_si128((const __m128i*) (src + done));
+        _mm_storeu_si128((__m128i*) dst, enc_translate(enc_reshuffle(in)));
+    }
+    return done;
+}
+
+SSE41 static int encode_sse41(const unsigned char* src, int n, char* dst) {
+    return encode_sse41_loop(src, n, dst);
+}
+
+AVX2 static inline __m256i enc_reshuffle(__m256i in) {
+    in = _mm256_shuffle_epi8(in, _mm256_broadcastsi128_si256(_mm_set_epi8(
+        10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1)));
+    const __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+    const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+    const __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+    const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+    return _mm256_or_si256(t1, t3);
+}
+
+AVX2 static inline __m256i enc_translate(__m256i in) {
+    const __m256i lut = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0));
+    __m256i idx = _mm256_subs_epu8(in, _mm256_set1_epi8(51));
+    const __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), in);
+    idx = _mm256_or_si256(idx, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+    return _mm256_add_epi8(in, _mm256_shuffle_epi8(lut, idx));
+}
+
+// 28 bytes are read, 24 encoded, 12 in each lane.
+AVX2 static int encode_avx2(const unsigned char* src, int n, char* dst) {
+    int done = 0;
+    for (; n - done >= 28; done += 24, dst += 32) {
+        const __m128i* p = (const __m128i*) (src + done);
+        __m256i in = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(p)),
+            _mm_loadu_si128((const __m128i*) (src + done + 12)), 1);
+        _mm256_storeu_si256((__m256i*) dst, enc_translate(enc_reshuffle(in)));
+    }
+    done += encode_sse41_loop(src + done, n - done, dst);
+    _mm256_zeroupper();
+    return done;
+}
+
+// translate ascii to sextets, return false if any is out of the alphabet.
+SSE41 static inline bool dec_translate(__m128i* str) {
+    const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                         0x11, 0x11, 0x11, 0x11, 0x13, 0x1a,
+                                         0x1b, 0x1b, 0x1b, 0x1a);
+    const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08,
+                                         0x04, 0x08, 0x10, 0x10, 0x10, 0x10,
+                                         0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                           0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask = _mm_set1_epi8(0x2f);
+
+    const __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(*str, 4), mask);
+    const __m128i lo_nibbles = _mm_and_si128(*str, mask);
+    const __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+    const __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+    if (!_mm_testz_si128(lo, hi)) return false;
+
+    const __m128i eq_2f = _mm_cmpeq_epi8(*str, mask);
+    const __m128i roll = _mm_shuffle_epi8(lut_roll,
+                                          _mm_add_epi8(eq_2f, hi_nibbles));
+    *str = _mm_add_epi8(*str, roll);
+    return true;
+}
+
+// 4 sextets -> 3 bytes, packed in the low 12 bytes.
+SSE41 static inline __m128i dec_reshuffle(__m128i in) {
+    const __m128i ab_bc = _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+    const __m128i out = _mm_madd_epi16(ab_bc, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(out, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                               14, 13, 12, -1, -1, -1, -1));
+}
+
+// 16 characters -> 12 bytes.
+SSE41 static inline int decode_sse41_loop(const char* src, int n,
+                                          unsigned char* dst) {
+    int done = 0;
+    for (; n - done >= 16; done += 16, dst += 12) {
+        __m128i str = _mm_loadu_si128((const __m128i*) (src + done));
+        if (!dec_translate(&str)) break;
+        str = dec_reshuffle(str);
+        _mm_storel_epi64((__m128i*) dst, str);
+        int tail = _mm_extract_epi32(str, 2);
+        ::memcpy(dst + 8, &tail, 4);
+    }
+    return done;
+}
+
+SSE41 static int decode_sse41(const char* src, int n, unsigned char* dst) {
+    return decode_sse41_loop(src, n, dst);
+}
+
+AVX2 static inline bool dec_translate(__m256i* str) {
+    const __m256i lut_lo = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13,
+        0x1a, 0x1b, 0x1b, 0x1b, 0x1a));
+    const __m256i lut_hi = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x10, 0x10, 0x10));
+    const __m256i lut_roll = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0));
+    const __m256i mask = _mm256_set1_epi8(0x2f);
+
+    const __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(*str, 4),
+                                                mask);
+    const __m256i lo_nibbles = _mm256_and_si256(*str, mask);
+    const __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+    const __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+    if (!_mm256_testz_si256(lo, hi)) return false;
+
+    const __m256i eq_2f = _mm256_cmpeq_epi8(*str, mask);
+    const __m256i roll = _mm256_shuffle_epi8(
+        lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+    *str = _mm256_add_epi8(*str, roll);
+    return true;
+}
+
+// 32 characters -> 24 bytes, exactly 24 bytes are stored.  the 128-bit
+// tail is inlined to stay in VEX encoding, no AVX-SSE transition.
+AVX2 static int decode_avx2(const char* src, int n, unsigned char* dst) {
+    int done = 0;
+    for (; n - done >= 32; done += 32, dst += 24) {
+        __m256i str = _mm256_loadu_si256((const __m256i*) (src + done));
+        if (!dec_translate(&str)) break;
+
+        const __m256i ab_bc = _mm256_maddubs_epi16(
+            str, _mm256_set1_epi32(0x01400140));
+        str = _mm256_madd_epi16(ab_bc, _mm256_set1_epi32(0x00011000));
+        str = _mm256_shuffle_epi8(str, _mm256_broadcastsi128_si256(
+            _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1,
+                          -1)));
+        str = _mm256_permutevar8x32_epi32(
+            str, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+        _mm_storeu_si128((__m128i*) dst, _mm256_castsi256_si128(str));
+        _mm_storel_epi64((__m128i*) (dst + 16), _mm256_extracti128_si256(str, 1));
+    }
+    done += decode_sse41_loop(src + done, n - done, dst);
+    _mm256_zeroupper();
+    return done;
+}
+
+#undef SSE41
+#undef AVX2
+
+static bool cpu_has_sse41() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+    return (ecx & bit_SSE4_1) != 0;
+}
+
+// the os must save ymm registers too.
+static bool cpu_has_avx2() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+    if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) return false;
+
+    unsigned int xcr0, xcr0_hi;
+    __asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0_hi) : "c"(0));
+    if ((xcr0 & 6) != 6) return false;
+
+    if (__get_cpuid_max(0, NULL) < 7) return false;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return (ebx & bit_AVX2) != 0;
+}
+
+static const bool kHaveSse41 = cpu_has_sse41();
+static const bool kHaveAvx2 = kHaveSse41 && cpu_has_avx2();
+
+#else
+
+static const bool kHaveSse41 = false;
+static const bool kHaveAvx2 = false;
+
+#endif
+
+// the same output as base64_encode() above.
+static int base64_encode(EncodeLoop loop, const unsigned char* pSrc,
+                         int nSrcLen, char* pDst, bool change_line) {
+    char* p = pDst;
+    const unsigned char* end = pSrc + nSrcLen / 3 * 3;
+
+    // 19 groups a line
+    const int line = change_line ? 57 : nSrcLen;
+    while (pSrc < end) {
+        int n = std::min<int>(end - pSrc, line);
+        int done = loop(pSrc, n, p);
+        p += done / 3 * 4;
+        p = encode_triples(pSrc + done, n - done, p);
+        pSrc += n;
+
+        if (change_line && n == line) {
+            *p++ = '\r';
+            *p++ = '\n';
+        }
+    }
+
+    int nMod = nSrcLen % 3;
+    if (nMod == 1) {
+        *p++ = EnBase64Tab[(pSrc[0] & 0xfc) >> 2];
+        *p++ = EnBase64Tab[((pSrc[0] & 0x03) << 4)];
+        *p++ = '=';
+        *p++ = '=';
+    } else if (nMod == 2) {
+        *p++ = EnBase64Tab[(pSrc[0] & 0xfc) >> 2];
+        *p++ = EnBase64Tab[((pSrc[0] & 0x03) << 4) | ((pSrc[1] & 0xf0) >> 4)];
+        *p++ = EnBase64Tab[((pSrc[1] & 0x0f) << 2)];
+        *p++ = '=';
+    }
+
+    *p = '\0';
+    return p - pDst;
+}
+
+// the same output as base64_decode() above, what the loop stops at is
+// decoded by the scalar code, one group or one line break at a time.
+static int base64_decode(DecodeLoop loop, const char* pSrc, int nSrcLen,
+                         unsigned char* pDst) {
+    unsigned char* p = pDst;
+    int i = 0;
+
+    while (i < nSrcLen) {
+        int done = loop(pSrc, nSrcLen - i, p);
+        pSrc += done;
+        i += done;
+        p += done / 4 * 3;
+        if (i >= nSrcLen) break;
+
+        if (*pSrc != '\r' && *pSrc != '\n') {
+            if (i + 4 > nSrcLen) break;
+
+            int nValue = DeBase64Tab[int(*pSrc++)] << 18;
+            nValue += DeBase64Tab[int(*pSrc++)] << 12;
+            *p++ = (nValue & 0x00ff0000) >> 16;
+            if (*pSrc != '=') {
+                nValue += DeBase64Tab[int(*pSrc++)] << 6;
+                *p++ = (nValue & 0x0000ff00) >> 8;
+                if (*pSrc != '=') {
+                    nValue += DeBase64Tab[int(*pSrc++)];
+                    *p++ = nValue & 0x000000ff;
+                }
+            }
+
+            i += 4;
+        } else {
+            pSrc++;
+            i++;
+        }
+    }
+
+    *p = '\0';
+    return p - pDst;
+}
 } // namespace xx
 
-std::string base64_encode(const std::string& data,
-                         bool change_line/* = false*/) {
-    if (data.empty()) return std::string();
+Base64Impl base64_best_impl() {
+    if (xx::kHaveAvx2) return BASE64_AVX2;
+    if (xx::kHaveSse41) return BASE64_SSE41;
+    return BASE64_SCALAR;
+}
 
-    char *pDst = NULL;
-    int iBufSize = (int) (data.size() * 1.4) + 6;
-    pDst = new char[iBufSize];
-    if (pDst == NULL) return std::string();
+bool base64_impl_supported(Base64Impl impl) {
+    switch (impl) {
+      case BASE64_SCALAR:
+        return true;
+      case BASE64_SSE41:
+        return xx::kHaveSse41;
+      case BASE64_AVX2:
+        return xx::kHaveAvx2;
+      default:
+        return false;
+    }
+}
 
-    int iDstLen = xx::base64_encode((unsigned char*) data.c_str(), data.size(),
-                                    pDst, change_line);
-    std::string ret(pDst, iDstLen);
-    delete[] pDst;
-    return ret;
+const char* base64_impl_name(Base64Impl impl) {
+    static const char* names[] = { "scalar", "sse4.1", "avx2" };
+    if (impl < 0 || impl >= BASE64_IMPL_NUM) return "unknown";
+    return names[impl];
 }
 
-std::string base64_decode(const std::string& data) {
-    if (data.empty()) return std::string();
+int base64_encode(Base64Impl impl, const char* src, int src_len, char* dst,
+                  bool change_line) {
+    const unsigned char* p = (const unsigned char*) src;
+#ifdef BASE64_HAVE_SIMD
+    switch (impl) {
+      case BASE64_SSE41:
+        return xx::base64_encode(xx::encode_sse41, p, src_len, dst,
+                                 change_line);
+      case BASE64_AVX2:
+        return xx::base64_encode(xx::encode_avx2, p, src_len, dst,
+                                 change_line);
+      default:
+        break;
+    }
+#endif
+    return xx::base64_encode(p, src_len, dst, change_line);
+}
+
+int base64_decode(Base64Impl impl, const char* src, int src_len, char* dst) {
+    unsigned char* p = (unsigned char*) dst;
+#ifdef BASE64_HAVE_SIMD
+    switch (impl) {
+      case BASE64_SSE41:
+        return xx::base64_decode(xx::decode_sse41, src, src_len, p);
+      case BASE64_AVX2:
+        return xx::base64_decode(xx::decode_avx2, src, src_len, p);
+      default:
+        break;
+    }
+#endif
+    return xx::base64_decode(src, src_len, p);
+}
 
-    unsigned char *pDst = NULL;
-    pDst = new unsigned char[data.size()];
-    if (pDst == NULL) return std::string();
+void base64_encode(const std::string& data, std::string* out,
+                   bool change_line) {
+    out->resize(base64_encode_bound(data.size(), change_line));
+    int n = base64_encode(data.data(), data.size(), &(*out)[0], change_line);
+    out->resize(n);
+}
+
+void base64_decode(const std::string& data, std::string* out) {
+    out->resize(base64_decode_bound(data.size()));
+    int n = base64_decode(data.data(), data.size(), &(*out)[0]);
+    out->resize(n);
+}
 
-    int iDstLen = xx::base64_decode(data.c_str(), data.size(), pDst);
-    std::string ret((char*) pDst, iDstLen);
-    delete[] pDst;
+std::string base64_encode(const std::string& data,
+                         bool change_line/* = false*/) {
+    std::string ret;
+    base64_encode(data, &ret, change_line);
+    return ret;
+}
+
+std::string base64_decode(const std::string& data) {
+    std::string ret;
+    base64_decode(data, &ret);
     return ret;
 }
 
 int base64_encode(const char* src, int src_len, char* dst,
                   bool change_line) {
-    return xx::base64_encode((const unsigned char*) src, src_len, dst, change_line);
+    static const Base64Impl impl = base64_best_impl();
+    return base64_encode(impl, src, src_len, dst, change_line);
 }
 
 int base64_decode(const char* src, int src_len, char* dst) {
-    return xx::base64_decode(src, src_len, (unsigned char*) dst);
+    static const Base64Impl impl = base64_best_impl();
+    return base64_decode(impl, src, src_len, dst);
 }
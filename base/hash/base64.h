@@ -6,7 +6,42 @@ std::string base64_encode(const std::string& data, bool change_line = false);
 
 std::string base64_decode(const std::string& data);
 
+// write into @out, no allocation if @out has enough capacity.
+void base64_encode(const std::string& data, std::string* out,
+                   bool change_line = false);
+
+void base64_decode(const std::string& data, std::string* out);
+
+// @dst must hold base64_encode_bound() or base64_decode_bound() bytes,
+// the result is followed by a '\0'.
 int base64_encode(const char* src, int src_len, char* dst,
                   bool change_line = false);
 
 int base64_decode(const char* src, int src_len, char* dst);
+
+inline int base64_encode_bound(int src_len, bool change_line = false) {
+    return (src_len + 2) / 3 * 4 + (change_line ? src_len / 57 * 2 : 0) + 1;
+}
+
+inline int base64_decode_bound(int src_len) {
+    return src_len / 4 * 3 + 1;
+}
+
+// implementations of base64_encode/base64_decode, for test and benchmark.
+enum Base64Impl {
+    BASE64_SCALAR = 0,  // byte at a time
+    BASE64_SSE41,  // 12 bytes at a time
+    BASE64_AVX2,  // 24 bytes at a time
+    BASE64_IMPL_NUM,
+};
+
+// the one used by base64_encode() and base64_decode().
+Base64Impl base64_best_impl();
+bool base64_impl_supported(Base64Impl impl);
+const char* base64_impl_name(Base64Impl impl);
+
+// @impl must be supported.
+int base64_encode(Base64Impl impl, const char* src, int src_len, char* dst,
+                  bool change_line = false);
+
+int base64_decode(Base64Impl impl, const char* src, int src_len, char* dst);
@@ -0,0 +1,66 @@
+#include "bench.h"
+#include "base/hash/base64.h"
+
+namespace bench {
+
+void base64Bench() {
+  std::vector<std::string> cols;
+  for (int i = 0; i < BASE64_IMPL_NUM; ++i) {
+    cols.push_back(base64_impl_name(static_cast<Base64Impl>(i)));
+  }
+  cols.push_back("std::string");
+
+  std::vector<char> data = randomData(1 << 20);
+  std::vector<char> text(base64_encode_bound(data.size()));
+  std::vector<char> out(text.size());
+
+  // GB/s of the binary side for both directions.
+  printHeader("base64 encode", cols);
+  for (uint64 size = 64; size <= data.size(); size *= 4) {
+    std::vector<double> row;
+    for (int i = 0; i < BASE64_IMPL_NUM; ++i) {
+      Base64Impl impl = static_cast<Base64Impl>(i);
+      if (!base64_impl_supported(impl)) {
+        row.push_back(-1);
+        continue;
+      }
+
+      row.push_back(gbps(size, nsPerCall([&]() {
+        use(base64_encode(impl, data.data(), size, out.data()));
+      })));
+    }
+
+    std::string s(data.data(), size);
+    row.push_back(gbps(size, nsPerCall([&]() {
+      use(base64_encode(s).size());
+    })));
+    printRow(size, row);
+  }
+
+  printHeader("base64 decode", cols);
+  for (uint64 size = 64; size <= data.size(); size *= 4) {
+    uint64 len = base64_encode(data.data(), size, text.data());
+    std::vector<double> row;
+    for (int i = 0; i < BASE64_IMPL_NUM; ++i) {
+      Base64Impl impl = static_cast<Base64Impl>(i);
+      if (!base64_impl_supported(impl)) {
+        row.push_back(-1);
+        continue;
+      }
+
+      CHECK_EQ(base64_decode(impl, text.data(), len, out.data()), size);
+      CHECK_EQ(::memcmp(out.data(), data.data(), size), 0);
+      row.push_back(gbps(size, nsPerCall([&]() {
+        use(base64_decode(impl, text.data(), len, out.data()));
+      })));
+    }
+
+    std::string s(text.data(), len);
+    row.push_back(gbps(size, nsPerCall([&]() {
+      use(base64_decode(s).size());
+    })));
+    printRow(size, row);
+  }
+}
+
+}
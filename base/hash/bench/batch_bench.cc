@@ -0,0 +1,80 @@
+#include "bench.h"
+
+namespace bench {
+
+// keys like "user:{12345}:profile:7", 16 to 40 bytes.
+static std::vector<std::string> makeKeys(size_t n) {
+  std::vector<std::string> keys;
+  std::vector<char> r = randomData(n * 2);
+  for (size_t i = 0; i < n; ++i) {
+    std::string key = "user:{" + util::to_string(i * 7919) + "}:profile";
+    key.append(static_cast<uint8>(r[i * 2]) % 16, 'x');
+    keys.push_back(key);
+  }
+  return keys;
+}
+
+void batchBench() {
+  std::vector<std::string> cols = { "crc16", "crc16-batch", "slot",
+                                    "slot-batch", "murmur64",
+                                    "murmur64-batch", "xxh3", "xxh3-batch" };
+  printHeader("batched hashing, size is the batch", cols, "keys/us");
+
+  for (size_t n = 8; n <= 1024; n *= 2) {
+    std::vector<std::string> keys = makeKeys(n);
+    std::vector<uint16> s16(n), b16(n);
+    std::vector<uint64> s64(n), b64(n);
+    std::vector<double> row;
+
+    // the same results as one by one.
+    crc16Batch(keys, b16.data());
+    for (size_t i = 0; i < n; ++i) CHECK_EQ(b16[i], crc16(keys[i]));
+    redisHashSlotBatch(keys, b16.data());
+    for (size_t i = 0; i < n; ++i) CHECK_EQ(b16[i], redisHashSlot(keys[i]));
+    murmur_hash64_batch(keys, 7, b64.data());
+    for (size_t i = 0; i < n; ++i) CHECK_EQ(b64[i], murmur_hash64(keys[i], 7));
+    XXH3Hash64Batch(keys, 7, b64.data());
+    for (size_t i = 0; i < n; ++i) CHECK_EQ(b64[i], XXH3Hash64(keys[i], 7));
+
+    // keys per ns * 1000
+    auto rate = [n](double ns) {
+      return n / ns * 1000;
+    };
+
+    row.push_back(rate(nsPerCall([&]() {
+      for (size_t i = 0; i < n; ++i) s16[i] = crc16(keys[i]);
+      use(s16[n - 1]);
+    })));
+    row.push_back(rate(nsPerCall([&]() {
+      crc16Batch(keys, b16.data());
+      use(b16[n - 1]);
+    })));
+    row.push_back(rate(nsPerCall([&]() {
+      for (size_t i = 0; i < n; ++i) s16[i] = redisHashSlot(keys[i]);
+      use(s16[n - 1]);
+    })));
+    row.push_back(rate(nsPerCall([&]() {
+      redisHashSlotBatch(keys, b16.data());
+      use(b16[n - 1]);
+    })));
+    row.push_back(rate(nsPerCall([&]() {
+      for (size_t i = 0; i < n; ++i) s64[i] = murmur_hash64(keys[i], 7);
+      use(s64[n - 1]);
+    })));
+    row.push_back(rate(nsPerCall([&]() {
+      murmur_hash64_batch(keys, 7, b64.data());
+      use(b64[n - 1]);
+    })));
+    row.push_back(rate(nsPerCall([&]() {
+      for (size_t i = 0; i < n; ++i) s64[i] = XXH3Hash64(keys[i], 7);
+      use(s64[n - 1]);
+    })));
+    row.push_back(rate(nsPerCall([&]() {
+      XXH3Hash64Batch(keys, 7, b64.data());
+      use(b64[n - 1]);
+    })));
+    printRow(n, row);
+  }
+}
+
+}
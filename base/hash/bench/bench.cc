@@ -0,0 +1,103 @@
+#include "bench.h"
+
+DEF_uint32(bench_ms, 200, "run each case for this many milliseconds");
+DEF_string(bench_csv, "",
+           "if not empty, also write results to this file, one line for a "
+           "value: table,unit,row,column,value");
+
+namespace bench {
+
+volatile uint64 sink = 0;
+
+std::vector<char> randomData(uint64 size, uint32 seed) {
+  std::vector<char> data(size);
+  uint64 x = seed * 0x9e3779b97f4a7c15ULL + 1;
+  for (uint64 i = 0; i < size; ++i) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    data[i] = static_cast<char>(x);
+  }
+  return data;
+}
+
+static std::string sizeStr(uint64 size) {
+  if (size >= (1 << 20) && size % (1 << 20) == 0) {
+    return util::to_string(size >> 20) + "M";
+  }
+  if (size >= 1024 && size % 1024 == 0) {
+    return util::to_string(size >> 10) + "K";
+  }
+  return util::to_string(size);
+}
+
+// the table being printed, for csv lines.
+static struct {
+  std::string title;
+  std::string unit;
+  std::vector<std::string> cols;
+  int width;  // of the first column
+} table;
+
+static FILE* csvFile() {
+  static FILE* f = NULL;
+  if (f == NULL && !FLG_bench_csv.empty()) {
+    f = ::fopen(FLG_bench_csv.c_str(), "w");
+    CHECK(f != NULL) << "failed to open " << FLG_bench_csv;
+    ::fprintf(f, "table,unit,row,column,value\n");
+  }
+  return f;
+}
+
+static std::string csvField(const std::string& s) {
+  if (s.find_first_of(",\"") == std::string::npos) return s;
+  std::string r = "\"";
+  for (auto c : s) {
+    if (c == '"') r.push_back('"');
+    r.push_back(c);
+  }
+  return r + "\"";
+}
+
+void printHeader(const char* title, const std::vector<std::string>& cols,
+                 const char* unit, const char* first) {
+  table.title = title;
+  table.unit = unit;
+  table.cols = cols;
+  table.width = ::strcmp(first, "size") == 0 ? 8 : 14;
+
+  ::printf("\n%s (%s)\n%*s", title, unit, table.width, first);
+  for (auto& col : cols) {
+    ::printf(" %14s", col.c_str());
+  }
+  ::printf("\n");
+}
+
+void printRow(uint64 size, const std::vector<double>& values) {
+  printRow(sizeStr(size), values);
+}
+
+void printRow(const std::string& name, const std::vector<double>& values) {
+  ::printf("%*s", table.width, name.c_str());
+  for (auto v : values) {
+    if (v < 0) {
+      ::printf(" %14s", "-");
+    } else {
+      ::printf(" %14.2f", v);
+    }
+  }
+  ::printf("\n");
+  ::fflush(stdout);
+
+  FILE* f = csvFile();
+  if (f == NULL) return;
+  for (size_t i = 0; i < values.size() && i < table.cols.size(); ++i) {
+    if (values[i] < 0) continue;
+    ::fprintf(f, "%s,%s,%s,%s,%g\n", csvField(table.title).c_str(),
+              csvField(table.unit).c_str(), csvField(name).c_str(),
+              csvField(table.cols[i]).c_str(), values[i]);
+  }
+  ::fflush(f);
+}
+
+}
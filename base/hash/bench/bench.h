@@ -0,0 +1,65 @@
+#pragma once
+
+#include "base/base.h"
+
+#include <vector>
+
+DEC_uint32(bench_ms);
+
+namespace bench {
+
+// keep results alive so the compiler won't drop the work.
+extern volatile uint64 sink;
+
+template<typename T>
+inline void use(T v) {
+  sink += static_cast<uint64>(v);
+}
+
+// call @f repeatedly for -bench_ms milliseconds, return nanoseconds per call.
+template<typename F>
+double nsPerCall(F f) {
+  f();
+
+  uint64 n = 0;
+  uint64 batch = 1;
+  sys::timer t;
+  while (true) {
+    for (uint64 i = 0; i < batch; ++i) {
+      f();
+    }
+    n += batch;
+
+    int64 us = t.us();
+    if (us >= FLG_bench_ms * 1000) return us * 1000.0 / n;
+    if (us < FLG_bench_ms * 100) batch *= 2;
+  }
+}
+
+// bytes per nanosecond is GB per second.
+inline double gbps(uint64 bytes, double ns) {
+  return bytes / ns;
+}
+
+std::vector<char> randomData(uint64 size, uint32 seed = 7);
+
+// print the header of a table, @cols are the column names after @first.
+// tables are also written to -bench_csv if it's set.
+void printHeader(const char* title, const std::vector<std::string>& cols,
+                 const char* unit = "GB/s", const char* first = "size");
+
+// GB/s (or @unit) of each column for @size, a negative value means
+// unsupported.
+void printRow(uint64 size, const std::vector<double>& values);
+void printRow(const std::string& name, const std::vector<double>& values);
+
+// hashes of base/hash compared by the hash and quality cases.
+struct HashFun {
+  const char* name;
+  uint64 (*fun)(const char* data, uint32 len);
+  uint32 bits;  // of the result
+};
+
+const std::vector<HashFun>& hashFuns();
+
+}
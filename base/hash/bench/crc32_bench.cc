@@ -0,0 +1,38 @@
+#include "bench.h"
+#include "base/hash/crc32.h"
+
+namespace bench {
+
+void crc32Bench() {
+  std::vector<std::string> cols;
+  for (int i = 0; i < CRC32_IMPL_NUM; ++i) {
+    cols.push_back(crc32ImplName(static_cast<Crc32Impl>(i)));
+  }
+  cols.push_back("crc32Extend");
+  printHeader("crc32c", cols);
+
+  std::vector<char> data = randomData(1 << 20);
+  for (uint64 size = 64; size <= data.size(); size *= 4) {
+    std::vector<double> row;
+    for (int i = 0; i < CRC32_IMPL_NUM; ++i) {
+      Crc32Impl impl = static_cast<Crc32Impl>(i);
+      if (!crc32ImplSupported(impl)) {
+        row.push_back(-1);
+        continue;
+      }
+
+      CHECK_EQ(crc32Extend(impl, 0, data.data(), size),
+               crc32Extend(CRC32_PORTABLE, 0, data.data(), size));
+      row.push_back(gbps(size, nsPerCall([&]() {
+        use(crc32Extend(impl, 0, data.data(), size));
+      })));
+    }
+
+    row.push_back(gbps(size, nsPerCall([&]() {
+      use(crc32Value(data.data(), size));
+    })));
+    printRow(size, row);
+  }
+}
+
+}
@@ -0,0 +1,87 @@
+#include "bench.h"
+
+namespace bench {
+
+const std::vector<HashFun>& hashFuns() {
+  static const std::vector<HashFun> funs = {
+    { "md5", [](const char* d, uint32 n) -> uint64 {
+      MD5_CTX ctx;
+      unsigned char digest[16];
+      MD5_Init(&ctx);
+      MD5_Update(&ctx, d, n);
+      MD5_Final(digest, &ctx);
+      return v64(digest);
+    }, 64 },
+    { "crc16", [](const char* d, uint32 n) -> uint64 {
+      return crc16(d, n);
+    }, 16 },
+    { "crc32c", [](const char* d, uint32 n) -> uint64 {
+      return crc32Value(d, n);
+    }, 32 },
+    { "murmur32", [](const char* d, uint32 n) -> uint64 {
+      return murmur_hash32(d, static_cast<int>(n));
+    }, 32 },
+    { "murmur64", [](const char* d, uint32 n) -> uint64 {
+      return murmur_hash64(d, static_cast<int>(n));
+    }, 64 },
+    { "city64", [](const char* d, uint32 n) -> uint64 {
+      return cityHash64(d, n);
+    }, 64 },
+    { "SuperFastHash", [](const char* d, uint32 n) -> uint64 {
+      return SuperFastHash(d, static_cast<int>(n));
+    }, 32 },
+    { "xxh32", [](const char* d, uint32 n) -> uint64 {
+      return XXHash32(d, n);
+    }, 32 },
+    { "xxh64", [](const char* d, uint32 n) -> uint64 {
+      return XXHash64(d, n);
+    }, 64 },
+    { "xxh3-64", [](const char* d, uint32 n) -> uint64 {
+      return XXH3Hash64(d, n);
+    }, 64 },
+    { "xxh3-128", [](const char* d, uint32 n) -> uint64 {
+      return XXH3Hash128(d, n).low64;
+    }, 64 },
+  };
+  return funs;
+}
+
+// throughput from 4 bytes to 1M, and latency of short keys.
+void hashBench() {
+  std::vector<char> data = randomData(1 << 20);
+  const char* p = data.data();
+  auto& funs = hashFuns();
+
+  std::vector<std::string> cols;
+  for (auto& h : funs) {
+    cols.push_back(h.name);
+  }
+  printHeader("hash throughput", cols);
+
+  for (uint64 size = 4; size <= data.size(); size *= 4) {
+    std::vector<double> row;
+    for (auto& h : funs) {
+      row.push_back(gbps(size, nsPerCall([&]() {
+        use(h.fun(p, size));
+      })));
+    }
+    printRow(size, row);
+  }
+
+  // each key depends on the hash of the previous one, so calls can't
+  // overlap, as in a lookup of a hash table.
+  printHeader("hash latency of short keys", cols, "ns");
+  for (uint32 size = 4; size <= 64; size *= 2) {
+    std::vector<double> row;
+    for (auto& h : funs) {
+      uint64 prev = 0;
+      row.push_back(nsPerCall([&]() {
+        prev = h.fun(p + (prev & 1023), size);
+        use(prev);
+      }));
+    }
+    printRow(size, row);
+  }
+}
+
+}
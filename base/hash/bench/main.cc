@@ -0,0 +1,45 @@
+#include "bench.h"
+
+DEF_string(bench, "all",
+           "comma separated cases to run: all, hash, quality, crc32, base64, "
+           "xxhash, batch, md5, xxtea");
+
+namespace bench {
+void hashBench();
+void qualityBench();
+void crc32Bench();
+void base64Bench();
+void xxhashBench();
+void batchBench();
+void md5Bench();
+void xxteaBench();
+}
+
+int main(int argc, char** argv) {
+  ccflag::init_ccflag(argc, argv);
+  cclog::init_cclog(*argv);
+
+  static const struct {
+    const char* name;
+    void (*fun)();
+  } kCases[] = {
+    { "hash", bench::hashBench },
+    { "quality", bench::qualityBench },
+    { "crc32", bench::crc32Bench },
+    { "base64", bench::base64Bench },
+    { "xxhash", bench::xxhashBench },
+    { "batch", bench::batchBench },
+    { "md5", bench::md5Bench },
+    { "xxtea", bench::xxteaBench },
+  };
+
+  auto names = util::split_string(FLG_bench, ',');
+  for (auto& c : kCases) {
+    if (FLG_bench == "all" ||
+        std::find(names.begin(), names.end(), c.name) != names.end()) {
+      c.fun();
+    }
+  }
+
+  return 0;
+}
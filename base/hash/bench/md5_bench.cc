@@ -0,0 +1,45 @@
+#include "bench.h"
+
+namespace bench {
+
+// 16 buffers of each size, GB/s of all of them.
+void md5Bench() {
+  const uint32 kBuffers = 16;
+  std::vector<char> data = randomData(kBuffers << 20);
+
+  std::vector<std::string> cols;
+  for (int i = 0; i < MD5_IMPL_NUM; ++i) {
+    cols.push_back(md5ImplName(static_cast<Md5Impl>(i)));
+  }
+  printHeader("md5 of 16 buffers, md5Multi()", cols);
+
+  for (uint64 size = 64; size <= (1 << 20); size *= 4) {
+    std::vector<const char*> ptrs;
+    std::vector<uint64> lens(kBuffers, size);
+    for (uint32 i = 0; i < kBuffers; ++i) ptrs.push_back(&data[i << 20]);
+
+    std::vector<unsigned char> expected(16 * kBuffers);
+    md5Multi(MD5_SCALAR, ptrs.data(), lens.data(), kBuffers, expected.data());
+
+    std::vector<double> row;
+    for (int i = 0; i < MD5_IMPL_NUM; ++i) {
+      Md5Impl impl = static_cast<Md5Impl>(i);
+      if (!md5ImplSupported(impl)) {
+        row.push_back(-1);
+        continue;
+      }
+
+      std::vector<unsigned char> digests(16 * kBuffers);
+      md5Multi(impl, ptrs.data(), lens.data(), kBuffers, digests.data());
+      CHECK(digests == expected) << md5ImplName(impl);
+
+      row.push_back(gbps(size * kBuffers, nsPerCall([&]() {
+        md5Multi(impl, ptrs.data(), lens.data(), kBuffers, digests.data());
+        use(digests[0]);
+      })));
+    }
+    printRow(size, row);
+  }
+}
+
+}
@@ -0,0 +1,129 @@
+#include "bench.h"
+
+#include <cmath>
+
+DEF_uint32(avalanche_samples, 4000, "random keys for each avalanche test");
+
+namespace bench {
+
+// keys like "user:12345", the usual input of sharding.
+static std::vector<std::string> seqKeys(uint32 n) {
+  std::vector<std::string> keys;
+  for (uint32 i = 0; i < n; ++i) {
+    keys.push_back("user:" + util::to_string(i));
+  }
+  return keys;
+}
+
+static std::vector<std::string> randomKeys(uint32 n, uint32 len) {
+  std::vector<char> data = randomData(n * len, 13);
+  std::vector<std::string> keys;
+  for (uint32 i = 0; i < n; ++i) {
+    keys.push_back(std::string(&data[i * len], len));
+  }
+  return keys;
+}
+
+// chi-square / degrees of freedom and load of the fullest bucket / mean,
+// of hash % @buckets.  both are about 1.0 for a good hash.
+static void distribution(const HashFun& h, const std::vector<std::string>& keys,
+                         uint32 buckets, double* chi2, double* max_load) {
+  std::vector<uint32> count(buckets);
+  for (auto& key : keys) {
+    ++count[h.fun(key.data(), key.size()) % buckets];
+  }
+
+  double expected = static_cast<double>(keys.size()) / buckets;
+  double sum = 0;
+  uint32 max = 0;
+  for (auto c : count) {
+    sum += (c - expected) * (c - expected) / expected;
+    max = std::max(max, c);
+  }
+  *chi2 = sum / (buckets - 1);
+  *max_load = max / expected;
+}
+
+// flip each bit of random keys of @len bytes, the bias of an (input bit,
+// output bit) pair is |2 * p - 1|, p is the probability the output bit
+// flips.  return the worst and the mean bias in percent.
+static void avalanche(const HashFun& h, uint32 len, double* worst,
+                      double* mean) {
+  const uint32 samples = FLG_avalanche_samples;
+  const uint32 in_bits = len * 8;
+  std::vector<char> data = randomData(samples * len, 17);
+  std::vector<uint32> flips(in_bits * h.bits);
+
+  std::string key;
+  for (uint32 s = 0; s < samples; ++s) {
+    key.assign(&data[s * len], len);
+    uint64 h0 = h.fun(key.data(), len);
+    for (uint32 i = 0; i < in_bits; ++i) {
+      key[i / 8] ^= 1 << (i % 8);
+      uint64 diff = h0 ^ h.fun(key.data(), len);
+      key[i / 8] ^= 1 << (i % 8);
+
+      uint32* f = &flips[i * h.bits];
+      for (uint32 b = 0; b < h.bits; ++b) {
+        f[b] += (diff >> b) & 1;
+      }
+    }
+  }
+
+  double sum = 0;
+  *worst = 0;
+  for (auto f : flips) {
+    double bias = std::fabs(2.0 * f / samples - 1) * 100;
+    *worst = std::max(*worst, bias);
+    sum += bias;
+  }
+  *mean = sum / flips.size();
+}
+
+void qualityBench() {
+  auto& funs = hashFuns();
+
+  std::vector<std::string> seq = seqKeys(1 << 18);
+  std::vector<std::string> rand = randomKeys(1 << 18, 16);
+
+  // seq % 1000 is what most sharding code does.
+  std::vector<std::string> cols = { "seq%1000", "seq%1024", "rand%1024",
+                                    "seq%65536" };
+  std::vector<std::vector<double>> chi2(funs.size()), load(funs.size());
+  for (size_t i = 0; i < funs.size(); ++i) {
+    const std::vector<std::string>* keys[] = { &seq, &seq, &rand, &seq };
+    const uint32 buckets[] = { 1000, 1024, 1024, 65536 };
+    for (int k = 0; k < 4; ++k) {
+      double c, l;
+      distribution(funs[i], *keys[k], buckets[k], &c, &l);
+      chi2[i].push_back(c);
+      load[i].push_back(l);
+    }
+  }
+
+  printHeader("bucket distribution of 256K keys, 1.00 is ideal", cols,
+              "chi2/df", "hash");
+  for (size_t i = 0; i < funs.size(); ++i) printRow(funs[i].name, chi2[i]);
+  printHeader("load of the fullest bucket", cols, "max/mean", "hash");
+  for (size_t i = 0; i < funs.size(); ++i) printRow(funs[i].name, load[i]);
+
+  cols.clear();
+  const uint32 lens[] = { 4, 16, 64 };
+  for (auto len : lens) {
+    cols.push_back(util::to_string(len) + "B-worst");
+    cols.push_back(util::to_string(len) + "B-mean");
+  }
+  printHeader("avalanche bias of output bits, 0 is ideal", cols, "%", "hash");
+  for (auto& h : funs) {
+    std::vector<double> row;
+    for (auto len : lens) {
+      double worst, mean;
+      avalanche(h, len, &worst, &mean);
+      row.push_back(worst);
+      row.push_back(mean);
+    }
+    printRow(h.name, row);
+  }
+}
+
+}
@@ -0,0 +1,19 @@
+#!/bin/bash
+
+if [ -n "$1" ]
+then
+  scons -j8 release=1
+  if [ $? != 0 ]
+  then
+    echo "build failed..."
+    exit -1
+  fi
+fi
+
+bin=../../../build/hash_bench
+
+args="-bench=all \
+  -bench_ms=200 \
+  "
+
+$bin $args
@@ -0,0 +1,35 @@
+#include "bench.h"
+
+namespace bench {
+
+void xxhashBench() {
+  std::vector<char> data = randomData(1 << 20);
+  const char* p = data.data();
+
+  // the loop for inputs over 240 bytes, hashBench() compares xxh3 with
+  // the others.
+  std::vector<std::string> cols;
+  for (int i = 0; i < XXH3_IMPL_NUM; ++i) {
+    cols.push_back(xxh3ImplName(static_cast<XXH3Impl>(i)));
+  }
+  printHeader("xxh3-64", cols);
+
+  for (uint64 size = 256; size <= data.size(); size *= 4) {
+    std::vector<double> row;
+    for (int i = 0; i < XXH3_IMPL_NUM; ++i) {
+      XXH3Impl impl = static_cast<XXH3Impl>(i);
+      if (!xxh3ImplSupported(impl)) {
+        row.push_back(-1);
+        continue;
+      }
+
+      CHECK_EQ(XXH3Hash64(impl, p, size, 7), XXH3Hash64(p, size, 7));
+      row.push_back(gbps(size, nsPerCall([&]() {
+        use(XXH3Hash64(impl, p, size, 7));
+      })));
+    }
+    printRow(size, row);
+  }
+}
+
+}
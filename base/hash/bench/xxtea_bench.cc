@@ -0,0 +1,69 @@
+#include "bench.h"
+
+namespace bench {
+
+// encode 64 messages of each size, GB/s of all of them.
+void xxteaBench() {
+  const uint32 kMessages = 64;
+  const std::string key = "0123456789abcdef";
+  const XxteaKey xkey(key);
+
+  std::vector<std::string> cols = { "xxtea_encode", "XxteaKey" };
+  for (int i = 0; i < XXTEA_IMPL_NUM; ++i) {
+    cols.push_back(std::string("batch-") +
+                   xxteaImplName(static_cast<XxteaImpl>(i)));
+  }
+  printHeader("xxtea encode of 64 messages", cols);
+
+  for (int size = 16; size <= 4096; size *= 4) {
+    std::vector<char> data = randomData(size * kMessages);
+    std::vector<std::string> msgs;
+    for (uint32 i = 0; i < kMessages; ++i) {
+      msgs.push_back(std::string(&data[i * size], size));
+    }
+
+    const int bound = xxtea_encode_bound(size);
+    std::vector<char> out(bound * kMessages);
+    std::vector<char*> bufs;
+    std::vector<int> lens(kMessages, size);
+    for (uint32 i = 0; i < kMessages; ++i) bufs.push_back(&out[i * bound]);
+
+    std::vector<double> row;
+    row.push_back(gbps(size * kMessages, nsPerCall([&]() {
+      for (auto& m : msgs) use(xxtea_encode(m, key).size());
+    })));
+    row.push_back(gbps(size * kMessages, nsPerCall([&]() {
+      for (uint32 i = 0; i < kMessages; ++i) {
+        use(xkey.encode(msgs[i].data(), size, bufs[i], bound));
+      }
+    })));
+
+    for (int i = 0; i < XXTEA_IMPL_NUM; ++i) {
+      XxteaImpl impl = static_cast<XxteaImpl>(i);
+      if (!xxteaImplSupported(impl)) {
+        row.push_back(-1);
+        continue;
+      }
+
+      // the same results as one by one.
+      for (uint32 k = 0; k < kMessages; ++k) {
+        ::memcpy(bufs[k], msgs[k].data(), size);
+      }
+      xkey.encodeBatch(impl, bufs.data(), lens.data(), kMessages);
+      for (uint32 k = 0; k < kMessages; ++k) {
+        CHECK_EQ(std::string(bufs[k], bound), xxtea_encode(msgs[k], key));
+      }
+
+      row.push_back(gbps(size * kMessages, nsPerCall([&]() {
+        for (uint32 k = 0; k < kMessages; ++k) {
+          ::memcpy(bufs[k], msgs[k].data(), size);
+        }
+        xkey.encodeBatch(impl, bufs.data(), lens.data(), kMessages);
+        use(bufs[0][0]);
+      })));
+    }
+    printRow(size, row);
+  }
+}
+
+}
@@ -1,4 +1,8 @@
 #include "crc16.h"
+#include "hash_keys.h"
+
+#include <string.h>
+#include <algorithm>
 
 static const uint16_t crc16Table[256] = { 0x0000, 0x1021, 0x2042, 0x3063,
                                           0x4084, 0x50a5, 0x60c6, 0x70e7,
@@ -74,3 +78,118 @@ uint16 crc16(const char *data, int len) {
   }
   return nCrc;
 }
+
+namespace {
+
+inline uint16 crc16Step(uint16 crc, unsigned char c) {
+  return (crc << 8) ^ crc16Table[((crc >> 8) ^ c) & MASK];
+}
+
+inline uint16 crc16Update(uint16 crc, const unsigned char* p, uint32 len) {
+  for (uint32 i = 0; i < len; ++i) {
+    crc = crc16Step(crc, p[i]);
+  }
+  return crc;
+}
+
+// each step of a key depends on the last one, so 4 keys are walked
+// together over their common length, the lookups of them overlap.
+template<typename Keys>
+void crc16Keys(const Keys& keys, size_t n, uint16* out) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const unsigned char* p0 = (const unsigned char*) keys.data(i);
+    const unsigned char* p1 = (const unsigned char*) keys.data(i + 1);
+    const unsigned char* p2 = (const unsigned char*) keys.data(i + 2);
+    const unsigned char* p3 = (const unsigned char*) keys.data(i + 3);
+    uint32 len0 = keys.size(i), len1 = keys.size(i + 1);
+    uint32 len2 = keys.size(i + 2), len3 = keys.size(i + 3);
+    uint32 common = std::min(std::min(len0, len1), std::min(len2, len3));
+
+    uint16 c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    for (uint32 k = 0; k < common; ++k) {
+      c0 = crc16Step(c0, p0[k]);
+      c1 = crc16Step(c1, p1[k]);
+      c2 = crc16Step(c2, p2[k]);
+      c3 = crc16Step(c3, p3[k]);
+    }
+
+    out[i] = crc16Update(c0, p0 + common, len0 - common);
+    out[i + 1] = crc16Update(c1, p1 + common, len1 - common);
+    out[i + 2] = crc16Update(c2, p2 + common, len2 - common);
+    out[i + 3] = crc16Update(c3, p3 + common, len3 - common);
+  }
+
+  for (; i < n; ++i) {
+    out[i] = crc16Update(0, (const unsigned char*) keys.data(i),
+                         keys.size(i));
+  }
+}
+
+// the hash tag of a redis key, or the whole key.
+inline void hashTag(const char* key, uint32 len, const char** tag,
+                    uint32* tag_len) {
+  *tag = key;
+  *tag_len = len;
+
+  const char* start = static_cast<const char*>(::memchr(key, '{', len));
+  if (start == NULL) return;
+
+  ++start;
+  const char* end = static_cast<const char*>(
+      ::memchr(start, '}', key + len - start));
+  if (end == NULL || end == start) return;
+
+  *tag = start;
+  *tag_len = end - start;
+}
+
+template<typename Keys>
+void redisHashSlotKeys(const Keys& keys, size_t n, uint16* out) {
+  const size_t kChunk = 64;
+  const char* tags[kChunk];
+  uint32 lens[kChunk];
+
+  for (size_t i = 0; i < n; i += kChunk) {
+    size_t m = std::min(kChunk, n - i);
+    for (size_t j = 0; j < m; ++j) {
+      hashTag(keys.data(i + j), keys.size(i + j), &tags[j], &lens[j]);
+    }
+
+    hash_keys::PtrKeys chunk = { tags, lens };
+    crc16Keys(chunk, m, out + i);
+    for (size_t j = 0; j < m; ++j) {
+      out[i + j] &= 16383;
+    }
+  }
+}
+}
+
+void crc16Batch(const char* const* keys, const uint32* lens, size_t n,
+                uint16* out) {
+  hash_keys::PtrKeys k = { keys, lens };
+  crc16Keys(k, n, out);
+}
+
+void crc16Batch(const std::vector<std::string>& keys, uint16* out) {
+  hash_keys::StrKeys k = { keys.data() };
+  crc16Keys(k, keys.size(), out);
+}
+
+uint16 redisHashSlot(const char* key, uint32 len) {
+  const char* tag;
+  uint32 tag_len;
+  hashTag(key, len, &tag, &tag_len);
+  return crc16(tag, tag_len) & 16383;
+}
+
+void redisHashSlotBatch(const char* const* keys, const uint32* lens,
+                        size_t n, uint16* out) {
+  hash_keys::PtrKeys k = { keys, lens };
+  redisHashSlotKeys(k, n, out);
+}
+
+void redisHashSlotBatch(const std::vector<std::string>& keys, uint16* out) {
+  hash_keys::StrKeys k = { keys.data() };
+  redisHashSlotKeys(k, keys.size(), out);
+}
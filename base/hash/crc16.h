@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "base/data_types.h"
 
 uint16 crc16(const char *data, int len);
@@ -9,3 +10,20 @@ inline uint16 crc16(const std::string& data) {
   return crc16(data.data(), data.size());
 }
 
+
+// crc16 of @n keys, @keys[i] has @lens[i] bytes.  the table lookups of
+// several keys are interleaved, the results are the same as crc16().
+void crc16Batch(const char* const* keys, const uint32* lens, size_t n,
+                uint16* out);
+void crc16Batch(const std::vector<std::string>& keys, uint16* out);
+
+// redis cluster slot of a key, only the part between the first '{' and
+// the next '}' is hashed if it's not empty.
+uint16 redisHashSlot(const char* key, uint32 len);
+inline uint16 redisHashSlot(const std::string& key) {
+  return redisHashSlot(key.data(), key.size());
+}
+
+void redisHashSlotBatch(const char* const* keys, const uint32* lens,
+                        size_t n, uint16* out);
+void redisHashSlotBatch(const std::vector<std::string>& keys, uint16* out);
@@ -7,6 +7,15 @@
 
 #include "crc32.h"
 
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define CRC32_HAVE_SSE42
+#include <cpuid.h>
+#include <nmmintrin.h>
+#include <wmmintrin.h>
+#endif
+
 namespace {
 
 static const uint32_t table0_[256] = { 0x00000000, 0xf26b8303, 0xe13b70f7,
@@ -358,9 +367,8 @@ static const uint32_t table3_[256] = { 0x00000000, 0xdd45aab8, 0xbf672381,
 inline uint32_t LE_LOAD32(const uint8_t *p) {
   return *reinterpret_cast<const uint32_t*>(p);
 }
-}
 
-uint32_t crc32Extend(uint32_t crc, const char* buf, size_t size) {
+uint32_t crc32ExtendPortable(uint32_t crc, const char* buf, size_t size) {
   const uint8_t *p = reinterpret_cast<const uint8_t *>(buf);
   const uint8_t *e = p + size;
   uint32_t l = crc ^ 0xffffffffu;
@@ -414,3 +422,219 @@ uint32_t crc32Extend(uint32_t crc, const char* buf, size_t size) {
 #undef STEP1
   return l ^ 0xffffffffu;
 }
+
+// a * b mod P in the reflected bit order the crc register uses: bit 31 is
+// x^0 and bit 0 is x^31.
+uint32_t multModP(uint32_t a, uint32_t b) {
+  uint32_t m = 1u << 31;
+  uint32_t p = 0;
+  while (true) {
+    if (a & m) {
+      p ^= b;
+      if ((a & (m - 1)) == 0) break;
+    }
+    m >>= 1;
+    b = b & 1 ? (b >> 1) ^ 0x82f63b78u : b >> 1;
+  }
+  return p;
+}
+
+uint32_t xPowModP(uint64_t n) {
+  uint32_t p = 1u << 31;  // x^0
+  uint32_t x = 1u << 30;  // x^1
+  while (n != 0) {
+    if (n & 1) p = multModP(x, p);
+    x = multModP(x, x);
+    n >>= 1;
+  }
+  return p;
+}
+
+#ifdef CRC32_HAVE_SSE42
+
+// bytes of each stream in the 3-way loops.
+const size_t kLongStream = 8192;
+const size_t kShortStream = 256;
+
+struct Crc32Shift {
+  Crc32Shift(size_t len)
+      : shift(xPowModP(len * 8)), clmul(xPowModP(len * 8 - 33)) {
+  }
+
+  const uint32_t shift;  // x^(8 * len), for multModP()
+  const uint32_t clmul;  // x^(8 * len - 33), for pclmulqdq
+};
+
+const Crc32Shift kLongShift(kLongStream);
+const Crc32Shift kShortShift(kShortStream);
+
+inline uint64_t load64(const uint8_t* p) {
+  uint64_t v;
+  ::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+__attribute__((target("sse4.2")))
+uint32_t crc32Sse42(uint32_t l, const uint8_t* p, size_t size) {
+  const uint8_t* e = p + size;
+  uint64_t l64 = l;
+  while (e - p >= 8) {
+    l64 = _mm_crc32_u64(l64, load64(p));
+    p += 8;
+  }
+  l = static_cast<uint32_t>(l64);
+  while (p != e) {
+    l = _mm_crc32_u8(l, *p++);
+  }
+  return l;
+}
+
+// crc of 3 streams of @len bytes, with @l as the initial crc of the first.
+__attribute__((target("sse4.2")))
+inline void crc32Streams(uint64_t* l0, uint64_t* l1, uint64_t* l2,
+                         const uint8_t* p, size_t len) {
+  const uint8_t* e = p + len;
+  uint64_t c0 = *l0, c1 = 0, c2 = 0;
+  do {
+    c0 = _mm_crc32_u64(c0, load64(p));
+    c1 = _mm_crc32_u64(c1, load64(p + len));
+    c2 = _mm_crc32_u64(c2, load64(p + len * 2));
+    p += 8;
+  } while (p != e);
+  *l0 = c0;
+  *l1 = c1;
+  *l2 = c2;
+}
+
+// crc(A + B) = crc(A) * x^(8 * len(B)) ^ crc(B), with crc(B) from 0.  the
+// multiply is multModP(), a bitwise loop of up to 32 steps.
+inline uint32_t shiftCrc(uint32_t l, const Crc32Shift& s) {
+  return multModP(s.shift, l);
+}
+
+// crc32(0, l * x^(8n-33) * x) == l * x^(8n) mod P, the extra x is from
+// multiplying two reflected numbers.
+__attribute__((target("sse4.2,pclmul")))
+inline uint32_t shiftClmul(uint32_t l, const Crc32Shift& s) {
+  __m128i v = _mm_clmulepi64_si128(_mm_cvtsi32_si128(l),
+                                   _mm_cvtsi32_si128(s.clmul), 0);
+  return static_cast<uint32_t>(_mm_crc32_u64(0, _mm_cvtsi128_si64(v)));
+}
+
+template<bool kClmul>
+__attribute__((target("sse4.2,pclmul")))
+uint32_t crc32Sse42Way3(uint32_t l, const uint8_t* p, size_t size) {
+  const uint8_t* e = p + size;
+
+  // align to 8 bytes, so loads never cross a cache line.
+  while ((reinterpret_cast<uintptr_t>(p) & 7) != 0 && p != e) {
+    l = _mm_crc32_u8(l, *p++);
+  }
+
+  const size_t lens[] = { kLongStream, kShortStream };
+  const Crc32Shift* shifts[] = { &kLongShift, &kShortShift };
+  for (int i = 0; i < 2; ++i) {
+    const size_t len = lens[i];
+    const Crc32Shift& s = *shifts[i];
+
+    while (static_cast<size_t>(e - p) >= len * 3) {
+      uint64_t l0 = l, l1, l2;
+      crc32Streams(&l0, &l1, &l2, p, len);
+      if (kClmul) {
+        l = shiftClmul(static_cast<uint32_t>(l0), s) ^ l1;
+        l = shiftClmul(l, s) ^ l2;
+      } else {
+        l = shiftCrc(static_cast<uint32_t>(l0), s) ^ l1;
+        l = shiftCrc(l, s) ^ l2;
+      }
+      p += len * 3;
+    }
+  }
+
+  return crc32Sse42(l, p, e - p);
+}
+
+bool cpuSupports(uint32_t ecx_bit) {
+  uint32_t eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+  return (ecx & ecx_bit) != 0;
+}
+
+const bool kHaveSse42 = cpuSupports(bit_SSE4_2);
+const bool kHavePclmul = kHaveSse42 && cpuSupports(bit_PCLMUL);
+
+#else
+
+const bool kHaveSse42 = false;
+const bool kHavePclmul = false;
+
+#endif
+
+// crc of short records is cheaper in a single stream.
+const size_t kWay3Threshold = 1024;
+}
+
+Crc32Impl crc32BestImpl() {
+  if (kHavePclmul) return CRC32_PCLMUL;
+  if (kHaveSse42) return CRC32_SSE42_3WAY;
+  return CRC32_PORTABLE;
+}
+
+bool crc32ImplSupported(Crc32Impl impl) {
+  switch (impl) {
+    case CRC32_PORTABLE:
+      return true;
+    case CRC32_SSE42:
+    case CRC32_SSE42_3WAY:
+      return kHaveSse42;
+    case CRC32_PCLMUL:
+      return kHavePclmul;
+    default:
+      return false;
+  }
+}
+
+const char* crc32ImplName(Crc32Impl impl) {
+  static const char* names[] = { "portable", "sse4.2", "sse4.2-3way",
+                                 "pclmul-3way" };
+  if (impl < 0 || impl >= CRC32_IMPL_NUM) return "unknown";
+  return names[impl];
+}
+
+uint32_t crc32Extend(Crc32Impl impl, uint32_t crc, const char* buf,
+                     size_t size) {
+#ifdef CRC32_HAVE_SSE42
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(buf);
+  uint32_t l = crc ^ 0xffffffffu;
+
+  switch (impl) {
+    case CRC32_SSE42:
+      return crc32Sse42(l, p, size) ^ 0xffffffffu;
+    case CRC32_SSE42_3WAY:
+      return crc32Sse42Way3<false>(l, p, size) ^ 0xffffffffu;
+    case CRC32_PCLMUL:
+      return crc32Sse42Way3<true>(l, p, size) ^ 0xffffffffu;
+    default:
+      break;
+  }
+#endif
+  return crc32ExtendPortable(crc, buf, size);
+}
+
+uint32_t crc32Extend(uint32_t crc, const char* buf, size_t size) {
+#ifdef CRC32_HAVE_SSE42
+  if (kHaveSse42) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(buf);
+    uint32_t l = crc ^ 0xffffffffu;
+    if (size < kWay3Threshold) {
+      l = crc32Sse42(l, p, size);
+    } else if (kHavePclmul) {
+      l = crc32Sse42Way3<true>(l, p, size);
+    } else {
+      l = crc32Sse42Way3<false>(l, p, size);
+    }
+    return l ^ 0xffffffffu;
+  }
+#endif
+  return crc32ExtendPortable(crc, buf, size);
+}
@@ -9,6 +9,8 @@
 // Return the crc32c of concat(A, data[0,n-1]) where init_crc is the
 // crc32c of some string A.  Extend() is often used to maintain the
 // crc32c of a stream of data.
+//
+// the crc32 instruction of SSE4.2 is used if the cpu supports it.
 uint32_t crc32Extend(uint32_t init_crc, const char* data, size_t n);
 inline uint32_t crc32Extend(uint32_t init_crc, std::string& data) {
   return crc32Extend(init_crc, data.c_str(), data.size());
@@ -22,6 +24,24 @@ inline uint32_t crc32Value(const std::string& data) {
   return crc32Value(data.c_str(), data.size());
 }
 
+// implementations of crc32Extend, for test and benchmark.
+enum Crc32Impl {
+  CRC32_PORTABLE = 0,  // table driven, 4 bytes at a time
+  CRC32_SSE42,  // crc32 instruction, 8 bytes at a time
+  CRC32_SSE42_3WAY,  // 3 interleaved streams, combined by bitwise multiply
+  CRC32_PCLMUL,  // 3 interleaved streams, combined by carry-less multiply
+  CRC32_IMPL_NUM,
+};
+
+// the one used by crc32Extend().
+Crc32Impl crc32BestImpl();
+bool crc32ImplSupported(Crc32Impl impl);
+const char* crc32ImplName(Crc32Impl impl);
+
+// @impl must be supported.
+uint32_t crc32Extend(Crc32Impl impl, uint32_t init_crc, const char* data,
+                     size_t n);
+
 static const uint32_t kMaskDelta = 0xa282ead8ul;
 
 // Return a masked representation of crc.
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "base/data_types.h"
+
+// key arrays taken by the batched hash functions.
+namespace hash_keys {
+
+struct PtrKeys {
+  const char* const* keys;
+  const uint32* lens;
+
+  const char* data(size_t i) const {
+    return keys[i];
+  }
+  uint32 size(size_t i) const {
+    return lens[i];
+  }
+};
+
+struct StrKeys {
+  const std::string* keys;
+
+  const char* data(size_t i) const {
+    return keys[i].data();
+  }
+  uint32 size(size_t i) const {
+    return static_cast<uint32>(keys[i].size());
+  }
+};
+
+}
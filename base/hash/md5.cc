@@ -39,6 +39,13 @@
 
 #include "md5.h"
 #include "../cclog/cclog.h"
+#include "../file_util.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define MD5_HAVE_SIMD
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
 
 const std::string Md5Hash::toString() {
   unsigned char digest[16];
@@ -300,35 +307,572 @@ void MD5_Final(unsigned char *result, MD5_CTX *ctx) {
   memset(ctx, 0, sizeof(*ctx));
 }
 
-std::string md5sum(const std::string& path) {
-    FILE* f = fopen(path.c_str(), "r");
-    if (f == NULL) {
-        ELOG << "md5sum: failed to open file: " << path;
-        return std::string();
+namespace {
+
+/*
+ * the 64 steps of body() as S(f, a, b, c, d, word, t, s), for the
+ * multi-buffer implementations.
+ */
+#define MD5_STEPS(S) \
+  S(F, a, b, c, d, 0, 0xd76aa478, 7) \
+  S(F, d, a, b, c, 1, 0xe8c7b756, 12) \
+  S(F, c, d, a, b, 2, 0x242070db, 17) \
+  S(F, b, c, d, a, 3, 0xc1bdceee, 22) \
+  S(F, a, b, c, d, 4, 0xf57c0faf, 7) \
+  S(F, d, a, b, c, 5, 0x4787c62a, 12) \
+  S(F, c, d, a, b, 6, 0xa8304613, 17) \
+  S(F, b, c, d, a, 7, 0xfd469501, 22) \
+  S(F, a, b, c, d, 8, 0x698098d8, 7) \
+  S(F, d, a, b, c, 9, 0x8b44f7af, 12) \
+  S(F, c, d, a, b, 10, 0xffff5bb1, 17) \
+  S(F, b, c, d, a, 11, 0x895cd7be, 22) \
+  S(F, a, b, c, d, 12, 0x6b901122, 7) \
+  S(F, d, a, b, c, 13, 0xfd987193, 12) \
+  S(F, c, d, a, b, 14, 0xa679438e, 17) \
+  S(F, b, c, d, a, 15, 0x49b40821, 22) \
+  S(G, a, b, c, d, 1, 0xf61e2562, 5) \
+  S(G, d, a, b, c, 6, 0xc040b340, 9) \
+  S(G, c, d, a, b, 11, 0x265e5a51, 14) \
+  S(G, b, c, d, a, 0, 0xe9b6c7aa, 20) \
+  S(G, a, b, c, d, 5, 0xd62f105d, 5) \
+  S(G, d, a, b, c, 10, 0x02441453, 9) \
+  S(G, c, d, a, b, 15, 0xd8a1e681, 14) \
+  S(G, b, c, d, a, 4, 0xe7d3fbc8, 20) \
+  S(G, a, b, c, d, 9, 0x21e1cde6, 5) \
+  S(G, d, a, b, c, 14, 0xc33707d6, 9) \
+  S(G, c, d, a, b, 3, 0xf4d50d87, 14) \
+  S(G, b, c, d, a, 8, 0x455a14ed, 20) \
+  S(G, a, b, c, d, 13, 0xa9e3e905, 5) \
+  S(G, d, a, b, c, 2, 0xfcefa3f8, 9) \
+  S(G, c, d, a, b, 7, 0x676f02d9, 14) \
+  S(G, b, c, d, a, 12, 0x8d2a4c8a, 20) \
+  S(H, a, b, c, d, 5, 0xfffa3942, 4) \
+  S(H, d, a, b, c, 8, 0x8771f681, 11) \
+  S(H, c, d, a, b, 11, 0x6d9d6122, 16) \
+  S(H, b, c, d, a, 14, 0xfde5380c, 23) \
+  S(H, a, b, c, d, 1, 0xa4beea44, 4) \
+  S(H, d, a, b, c, 4, 0x4bdecfa9, 11) \
+  S(H, c, d, a, b, 7, 0xf6bb4b60, 16) \
+  S(H, b, c, d, a, 10, 0xbebfbc70, 23) \
+  S(H, a, b, c, d, 13, 0x289b7ec6, 4) \
+  S(H, d, a, b, c, 0, 0xeaa127fa, 11) \
+  S(H, c, d, a, b, 3, 0xd4ef3085, 16) \
+  S(H, b, c, d, a, 6, 0x04881d05, 23) \
+  S(H, a, b, c, d, 9, 0xd9d4d039, 4) \
+  S(H, d, a, b, c, 12, 0xe6db99e5, 11) \
+  S(H, c, d, a, b, 15, 0x1fa27cf8, 16) \
+  S(H, b, c, d, a, 2, 0xc4ac5665, 23) \
+  S(I, a, b, c, d, 0, 0xf4292244, 6) \
+  S(I, d, a, b, c, 7, 0x432aff97, 10) \
+  S(I, c, d, a, b, 14, 0xab9423a7, 15) \
+  S(I, b, c, d, a, 5, 0xfc93a039, 21) \
+  S(I, a, b, c, d, 12, 0x655b59c3, 6) \
+  S(I, d, a, b, c, 3, 0x8f0ccc92, 10) \
+  S(I, c, d, a, b, 10, 0xffeff47d, 15) \
+  S(I, b, c, d, a, 1, 0x85845dd1, 21) \
+  S(I, a, b, c, d, 8, 0x6fa87e4f, 6) \
+  S(I, d, a, b, c, 15, 0xfe2ce6e0, 10) \
+  S(I, c, d, a, b, 6, 0xa3014314, 15) \
+  S(I, b, c, d, a, 13, 0x4e0811a1, 21) \
+  S(I, a, b, c, d, 4, 0xf7537e82, 6) \
+  S(I, d, a, b, c, 11, 0xbd3af235, 10) \
+  S(I, c, d, a, b, 2, 0x2ad7d2bb, 15) \
+  S(I, b, c, d, a, 9, 0xeb86d391, 21)
+
+/*
+ * vector versions of the basic functions and STEP, ADD, XOR... are defined
+ * for each register width before use.
+ */
+#define VF(x, y, z)     XOR((z), AND((x), XOR((y), (z))))
+#define VG(x, y, z)     XOR((y), AND((z), XOR((x), (y))))
+#define VH(x, y, z)     XOR(XOR((x), (y)), (z))
+#define VI(x, y, z)     XOR((y), OR((x), XOR((z), ONES)))
+
+#define VSTEP(f, a, b, c, d, k, t, s) \
+  (a) = ADD((a), ADD(V##f((b), (c), (d)), ADD(w[k], SET1(t)))); \
+  (a) = OR(SHL((a), (s)), SHR((a), 32 - (s))); \
+  (a) = ADD((a), (b));
+
+const uint32 kMaxLanes = 8;
+
+// state[i * kMaxLanes + lane] is a, b, c, d of the lane, @ptrs[lane] points
+// to @blocks consecutive blocks.
+typedef void (*MultiFun)(uint32* state, const unsigned char* const* ptrs,
+                         uint64 blocks);
+
+#ifdef MD5_HAVE_SIMD
+
+#define ADD(x, y)       _mm_add_epi32((x), (y))
+#define XOR(x, y)       _mm_xor_si128((x), (y))
+#define AND(x, y)       _mm_and_si128((x), (y))
+#define OR(x, y)        _mm_or_si128((x), (y))
+#define SHL(x, n)       _mm_slli_epi32((x), (n))
+#define SHR(x, n)       _mm_srli_epi32((x), (n))
+#define SET1(t)         _mm_set1_epi32(static_cast<int>(t))
+#define ONES            _mm_set1_epi32(-1)
+
+void md5x4Sse2(uint32* state, const unsigned char* const* ptrs,
+               uint64 blocks) {
+  __m128i a = _mm_loadu_si128((const __m128i*) (state + 0 * kMaxLanes));
+  __m128i b = _mm_loadu_si128((const __m128i*) (state + 1 * kMaxLanes));
+  __m128i c = _mm_loadu_si128((const __m128i*) (state + 2 * kMaxLanes));
+  __m128i d = _mm_loadu_si128((const __m128i*) (state + 3 * kMaxLanes));
+
+  for (uint64 n = 0; n < blocks; ++n) {
+    // transpose 4x4 words, w[k] holds the k-th word of each lane.
+    __m128i w[16];
+    for (int q = 0; q < 4; ++q) {
+      __m128i r0 = _mm_loadu_si128((const __m128i*) (ptrs[0] + n * 64) + q);
+      __m128i r1 = _mm_loadu_si128((const __m128i*) (ptrs[1] + n * 64) + q);
+      __m128i r2 = _mm_loadu_si128((const __m128i*) (ptrs[2] + n * 64) + q);
+      __m128i r3 = _mm_loadu_si128((const __m128i*) (ptrs[3] + n * 64) + q);
+      __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+      __m128i t1 = _mm_unpackhi_epi32(r0, r1);
+      __m128i t2 = _mm_unpacklo_epi32(r2, r3);
+      __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+      w[q * 4 + 0] = _mm_unpacklo_epi64(t0, t2);
+      w[q * 4 + 1] = _mm_unpackhi_epi64(t0, t2);
+      w[q * 4 + 2] = _mm_unpacklo_epi64(t1, t3);
+      w[q * 4 + 3] = _mm_unpackhi_epi64(t1, t3);
     }
 
-    int ret = 0;
-    char buf[4096];
+    __m128i saved_a = a, saved_b = b, saved_c = c, saved_d = d;
+    MD5_STEPS(VSTEP)
+    a = ADD(a, saved_a);
+    b = ADD(b, saved_b);
+    c = ADD(c, saved_c);
+    d = ADD(d, saved_d);
+  }
+
+  _mm_storeu_si128((__m128i*) (state + 0 * kMaxLanes), a);
+  _mm_storeu_si128((__m128i*) (state + 1 * kMaxLanes), b);
+  _mm_storeu_si128((__m128i*) (state + 2 * kMaxLanes), c);
+  _mm_storeu_si128((__m128i*) (state + 3 * kMaxLanes), d);
+}
+
+#undef ADD
+#undef XOR
+#undef AND
+#undef OR
+#undef SHL
+#undef SHR
+#undef SET1
+#undef ONES
+
+#define ADD(x, y)       _mm256_add_epi32((x), (y))
+#define XOR(x, y)       _mm256_xor_si256((x), (y))
+#define AND(x, y)       _mm256_and_si256((x), (y))
+#define OR(x, y)        _mm256_or_si256((x), (y))
+#define SHL(x, n)       _mm256_slli_epi32((x), (n))
+#define SHR(x, n)       _mm256_srli_epi32((x), (n))
+#define SET1(t)         _mm256_set1_epi32(static_cast<int>(t))
+#define ONES            _mm256_set1_epi32(-1)
+
+__attribute__((target("avx2")))
+void md5x8Avx2(uint32* state, const unsigned char* const* ptrs,
+               uint64 blocks) {
+  __m256i a = _mm256_loadu_si256((const __m256i*) (state + 0 * kMaxLanes));
+  __m256i b = _mm256_loadu_si256((const __m256i*) (state + 1 * kMaxLanes));
+  __m256i c = _mm256_loadu_si256((const __m256i*) (state + 2 * kMaxLanes));
+  __m256i d = _mm256_loadu_si256((const __m256i*) (state + 3 * kMaxLanes));
+
+  for (uint64 n = 0; n < blocks; ++n) {
+    // transpose two 8x8 matrices of words, w[k] holds the k-th word of
+    // each lane.
+    __m256i w[16];
+    for (int h = 0; h < 2; ++h) {
+      __m256i r[8];
+      for (int i = 0; i < 8; ++i) {
+        r[i] = _mm256_loadu_si256((const __m256i*) (ptrs[i] + n * 64) + h);
+      }
+      __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+      __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+      __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+      __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+      __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+      __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+      __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+      __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+      __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+      __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+      __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+      __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+      __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+      __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+      __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+      __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+      w[h * 8 + 0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+      w[h * 8 + 1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+      w[h * 8 + 2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+      w[h * 8 + 3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+      w[h * 8 + 4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+      w[h * 8 + 5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+      w[h * 8 + 6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+      w[h * 8 + 7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+    }
+
+    __m256i saved_a = a, saved_b = b, saved_c = c, saved_d = d;
+    MD5_STEPS(VSTEP)
+    a = ADD(a, saved_a);
+    b = ADD(b, saved_b);
+    c = ADD(c, saved_c);
+    d = ADD(d, saved_d);
+  }
+
+  _mm256_storeu_si256((__m256i*) (state + 0 * kMaxLanes), a);
+  _mm256_storeu_si256((__m256i*) (state + 1 * kMaxLanes), b);
+  _mm256_storeu_si256((__m256i*) (state + 2 * kMaxLanes), c);
+  _mm256_storeu_si256((__m256i*) (state + 3 * kMaxLanes), d);
+  _mm256_zeroupper();
+}
+
+#undef ADD
+#undef XOR
+#undef AND
+#undef OR
+#undef SHL
+#undef SHR
+#undef SET1
+#undef ONES
+
+// the os must save ymm registers too.
+bool cpuHasAvx2() {
+  uint32 eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+  if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) return false;
+
+  uint32 xcr0, xcr0_hi;
+  __asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0_hi) : "c"(0));
+  if ((xcr0 & 6) != 6) return false;
+
+  if (__get_cpuid_max(0, NULL) < 7) return false;
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  return (ebx & bit_AVX2) != 0;
+}
+
+const bool kHaveSse2 = true;
+const bool kHaveAvx2 = cpuHasAvx2();
 
+#else
+
+const bool kHaveSse2 = false;
+const bool kHaveAvx2 = false;
+
+#endif
+
+// a buffer being hashed in a lane.  full blocks are read from the buffer,
+// the last one or two padded blocks from @tail.
+struct Md5Lane {
+  const unsigned char* data;
+  uint64 blocks;  // full blocks of data
+  uint64 total;  // blocks including the padded ones
+  uint64 done;
+  size_t index;  // of the buffer
+  bool busy;
+  unsigned char tail[128];
+};
+
+void startLane(Md5Lane* lane, const char* data, uint64 len, size_t index) {
+  lane->data = (const unsigned char *) data;
+  lane->blocks = len / 64;
+  lane->done = 0;
+  lane->index = index;
+  lane->busy = true;
+
+  // the same padding as MD5_Final().
+  uint32 used = len % 64;
+  uint32 tail_len = used + 9 > 64 ? 128 : 64;
+  if (used != 0) ::memcpy(lane->tail, data + lane->blocks * 64, used);
+  lane->tail[used] = 0x80;
+  ::memset(lane->tail + used + 1, 0, tail_len - used - 1 - 8);
+  uint64 bits = len << 3;
+  for (int i = 0; i < 8; ++i) {
+    lane->tail[tail_len - 8 + i] = static_cast<unsigned char>(bits >> (i * 8));
+  }
+  lane->total = lane->blocks + tail_len / 64;
+}
+
+// the rest of a lane by scalar md5, @state is that of the lane, a, b, c
+// and d are kMaxLanes apart.
+void finishLane(Md5Lane* lane, uint32* state) {
+  MD5_CTX ctx;
+  ctx.a = state[0];
+  ctx.b = state[kMaxLanes];
+  ctx.c = state[kMaxLanes * 2];
+  ctx.d = state[kMaxLanes * 3];
+
+  if (lane->done < lane->blocks) {
+    body(&ctx, lane->data + lane->done * 64,
+         (lane->blocks - lane->done) * 64);
+    lane->done = lane->blocks;
+  }
+  body(&ctx, lane->tail + (lane->done - lane->blocks) * 64,
+       (lane->total - lane->done) * 64);
+  lane->done = lane->total;
+
+  state[0] = ctx.a;
+  state[kMaxLanes] = ctx.b;
+  state[kMaxLanes * 2] = ctx.c;
+  state[kMaxLanes * 3] = ctx.d;
+}
+
+void md5MultiLanes(MultiFun fun, uint32 lanes, const char* const* data,
+                   const uint64* lens, size_t n, unsigned char* digests) {
+  static const uint32 kInit[4] = {
+    0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476,
+  };
+
+  Md5Lane lane[kMaxLanes];
+  uint32 state[4 * kMaxLanes];
+  for (uint32 i = 0; i < lanes; ++i) lane[i].busy = false;
+
+  size_t next = 0;
+  while (true) {
+    // refill idle lanes.
+    int first = -1;
+    uint32 busy = 0;
+    for (uint32 i = 0; i < lanes; ++i) {
+      if (!lane[i].busy && next < n) {
+        startLane(&lane[i], data[next], lens[next], next);
+        ++next;
+        for (int k = 0; k < 4; ++k) state[k * kMaxLanes + i] = kInit[k];
+      }
+      if (!lane[i].busy) continue;
+      if (first < 0) first = i;
+      ++busy;
+    }
+    if (first < 0) break;
+
+    if (busy == 1 && next == n) {
+      // the last buffer, idle lanes would only repeat its work.
+      finishLane(&lane[first], state + first);
+
+    } else {
+      // run until a lane finishes or moves from its data to the tail.
+      const unsigned char* ptrs[kMaxLanes];
+      uint64 run = MAX_UINT64;
+      for (uint32 i = 0; i < lanes; ++i) {
+        const Md5Lane& l = lane[i];
+        if (!l.busy) continue;
+        uint64 left;
+        if (l.done < l.blocks) {
+          ptrs[i] = l.data + l.done * 64;
+          left = l.blocks - l.done;
+        } else {
+          ptrs[i] = l.tail + (l.done - l.blocks) * 64;
+          left = l.total - l.done;
+        }
+        run = std::min(run, left);
+      }
+      // idle lanes hash the data of a busy one, the results are dropped.
+      for (uint32 i = 0; i < lanes; ++i) {
+        if (!lane[i].busy) ptrs[i] = ptrs[first];
+      }
+
+      fun(state, ptrs, run);
+      for (uint32 i = 0; i < lanes; ++i) {
+        if (lane[i].busy) lane[i].done += run;
+      }
+    }
+
+    for (uint32 i = 0; i < lanes; ++i) {
+      Md5Lane& l = lane[i];
+      if (!l.busy || l.done < l.total) continue;
+
+      unsigned char* result = digests + l.index * 16;
+      for (int k = 0; k < 4; ++k) {
+        uint32 v = state[k * kMaxLanes + i];
+        result[k * 4] = v;
+        result[k * 4 + 1] = v >> 8;
+        result[k * 4 + 2] = v >> 16;
+        result[k * 4 + 3] = v >> 24;
+      }
+      l.busy = false;
+    }
+  }
+}
+
+std::string md5Hex(const unsigned char* digest) {
+  std::string s;
+  s.resize(32);
+  for (int i = 0; i < 16; ++i) {
+    s[i * 2] = "0123456789abcdef"[(digest[i] & 0xf0) >> 4];
+    s[i * 2 + 1] = "0123456789abcdef"[digest[i] & 0x0f];
+  }
+  return s;
+}
+
+// for files that can't be mmaped, pipes or those in /proc for example.
+bool md5Read(const std::string& path, unsigned char* digest) {
+  FILE* f = fopen(path.c_str(), "r");
+  if (f == NULL) {
+    ELOG << "md5sum: failed to open file: " << path;
+    return false;
+  }
+
+  MD5_CTX ctx;
+  MD5_Init(&ctx);
+
+  char buf[64 * 1024];
+  size_t ret;
+  while ((ret = fread(buf, 1, sizeof(buf), f)) > 0) {
+    MD5_Update(&ctx, buf, ret);
+  }
+  bool ok = !ferror(f);
+  fclose(f);
+  if (!ok) {
+    ELOG << "md5sum: failed to read file: " << path;
+    return false;
+  }
+
+  MD5_Final(digest, &ctx);
+  return true;
+}
+
+// files hashed by md5Multi() at a time.
+const size_t kFilesPerRound = 32;
+
+}
+
+Md5Impl md5BestImpl() {
+  if (kHaveAvx2) return MD5_AVX2;
+  if (kHaveSse2) return MD5_SSE2;
+  return MD5_SCALAR;
+}
+
+bool md5ImplSupported(Md5Impl impl) {
+  switch (impl) {
+    case MD5_SCALAR:
+      return true;
+    case MD5_SSE2:
+      return kHaveSse2;
+    case MD5_AVX2:
+      return kHaveAvx2;
+    default:
+      return false;
+  }
+}
+
+const char* md5ImplName(Md5Impl impl) {
+  static const char* names[] = { "scalar", "sse2", "avx2" };
+  if (impl < 0 || impl >= MD5_IMPL_NUM) return "unknown";
+  return names[impl];
+}
+
+void md5Multi(Md5Impl impl, const char* const* data, const uint64* lens,
+              size_t n, unsigned char* digests) {
+#ifdef MD5_HAVE_SIMD
+  if (impl == MD5_AVX2) {
+    md5MultiLanes(md5x8Avx2, 8, data, lens, n, digests);
+    return;
+  }
+  if (impl == MD5_SSE2) {
+    md5MultiLanes(md5x4Sse2, 4, data, lens, n, digests);
+    return;
+  }
+#endif
+
+  for (size_t i = 0; i < n; ++i) {
     MD5_CTX ctx;
     MD5_Init(&ctx);
+    MD5_Update(&ctx, data[i], lens[i]);
+    MD5_Final(digests + i * 16, &ctx);
+  }
+}
 
-    do {
-        ret = fread(buf, 1, 4096, f);
-        if (ret > 0) MD5_Update(&ctx, buf, ret);
-    } while (ret > 0);
+void md5Multi(const char* const* data, const uint64* lens, size_t n,
+              unsigned char* digests) {
+  static const Md5Impl impl = md5BestImpl();
+  md5Multi(impl, data, lens, n, digests);
+}
 
-    unsigned char md5[16];
-    MD5_Final(md5, &ctx);
+std::string md5sum(const std::string& path) {
+  std::vector<std::string> sums;
+  md5sum(std::vector<std::string>(1, path), &sums);
+  return sums[0];
+}
+
+void md5sum(const std::vector<std::string>& paths,
+            std::vector<std::string>* sums) {
+  sums->assign(paths.size(), std::string());
+
+  for (size_t start = 0; start < paths.size(); start += kFilesPerRound) {
+    size_t end = std::min(paths.size(), start + kFilesPerRound);
+
+    // mmap files of the round so readahead of them goes in parallel.
+    std::vector<std::unique_ptr<MmapReadonlyFile>> files;
+    std::vector<const char*> data;
+    std::vector<uint64> lens;
+    std::vector<size_t> index;
+    for (size_t i = start; i < end; ++i) {
+      std::unique_ptr<MmapReadonlyFile> file(new MmapReadonlyFile(
+          paths[i], MmapReadonlyFile::SEQUENTIAL |
+          MmapReadonlyFile::WILLNEED));
+      // empty files are read too, those in /proc look empty.
+      if (!file->Init() || file->size() == 0) {
+        unsigned char digest[16];
+        if (md5Read(paths[i], digest)) (*sums)[i] = md5Hex(digest);
+        continue;
+      }
+
+      data.push_back(file->data());
+      lens.push_back(file->size());
+      index.push_back(i);
+      files.push_back(std::move(file));
+    }
 
-    std::string s;
-    s.resize(32);
-    for (int i = 0; i < 16; ++i) {
-        s[i * 2] = "0123456789abcdef"[(md5[i] & 0xf0) >> 4];
-        s[i * 2 + 1] = "0123456789abcdef"[md5[i] & 0x0f];
+    std::vector<unsigned char> digests(16 * data.size());
+    md5Multi(data.data(), lens.data(), data.size(), digests.data());
+    for (size_t i = 0; i < index.size(); ++i) {
+      (*sums)[index[i]] = md5Hex(&digests[i * 16]);
     }
+  }
+}
+
+bool md5sumDir(const std::string& dir,
+               std::map<std::string, std::string>* sums, uint32 thread_num,
+               bool recursive) {
+  sums->clear();
+
+  DirWalker walker(dir, recursive, thread_num);
+  if (!walker.Init()) return false;
+  std::vector<DirWalker::Entry> entries;
+  bool ok = walker.walk(&entries, false);
+
+  std::vector<std::string> paths;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (entries[i].type == DT_REG) paths.push_back(dir + "/" + entries[i].path);
+  }
 
-    fclose(f);
+  // a task hashes a round of files, results go to disjoint ranges.
+  std::vector<std::string> result(paths.size());
+  auto task = [&paths, &result](size_t start) {
+    size_t end = std::min(paths.size(), start + kFilesPerRound);
+    std::vector<std::string> sub(paths.begin() + start, paths.begin() + end);
+    std::vector<std::string> sub_sums;
+    md5sum(sub, &sub_sums);
+    std::copy(sub_sums.begin(), sub_sums.end(), result.begin() + start);
+  };
+
+  if (thread_num > 1 && paths.size() > kFilesPerRound) {
+    ThreadPool pool(thread_num);
+    for (size_t i = 0; i < paths.size(); i += kFilesPerRound) {
+      pool.run(std::bind(task, i));
+    }
+    pool.wait();
+  } else {
+    for (size_t i = 0; i < paths.size(); i += kFilesPerRound) task(i);
+  }
 
-    return s;
+  size_t j = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (entries[i].type != DT_REG) continue;
+    if (result[j].empty()) {
+      ok = false;
+    } else {
+      (*sums)[entries[i].path] = result[j];
+    }
+    ++j;
+  }
+  return ok;
 }
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <map>
 #include <string>
+#include <vector>
 #include <cassert>
 
 #include "../string_util.h"
@@ -79,4 +81,47 @@ inline void md5Encode(const std::string& data, std::string* out) {
   md5Encode(data.data(), data.size(), out);
 }
 
+// md5 of the file in hex, the file is mmaped if possible.  an empty string
+// if failed to read it.
 std::string md5sum(const std::string& path);
+
+// md5sum of each of @paths, an empty string for those failed to read.
+// files are hashed with md5Multi() a few dozens at a time.
+void md5sum(const std::vector<std::string>& paths,
+            std::vector<std::string>* sums);
+
+// md5sum of regular files under @dir with @thread_num threads, keyed by the
+// path relative to @dir.  return false if any of them failed to read.
+bool md5sumDir(const std::string& dir,
+               std::map<std::string, std::string>* sums,
+               uint32 thread_num = 4, bool recursive = true);
+
+// implementations of md5Multi(), the results are the same as MD5_Final()
+// of each buffer.
+enum Md5Impl {
+  MD5_SCALAR = 0,  // one buffer at a time
+  MD5_SSE2,  // 4 buffers in the lanes of xmm registers
+  MD5_AVX2,  // 8 buffers in the lanes of ymm registers
+  MD5_IMPL_NUM,
+};
+
+// the one used by md5Multi().
+Md5Impl md5BestImpl();
+bool md5ImplSupported(Md5Impl impl);
+const char* md5ImplName(Md5Impl impl);
+
+/*
+ * md5 of @n independent buffers, @data[i] has @lens[i] bytes and its digest
+ * is written to @digests + 16 * i.
+ *
+ *   md5 can't be vectorized within a buffer, but the same step of different
+ *   buffers can.  a lane is refilled with the next buffer once its buffer
+ *   is done, so buffers of different sizes keep all lanes busy.  the last
+ *   buffer left, or a single one, is finished by scalar md5.
+ */
+void md5Multi(const char* const* data, const uint64* lens, size_t n,
+              unsigned char* digests);
+
+// @impl must be supported.
+void md5Multi(Md5Impl impl, const char* const* data, const uint64* lens,
+              size_t n, unsigned char* digests);
@@ -1,4 +1,8 @@
 #include "murmur_hash.h"
+#include "hash_keys.h"
+
+#include <string.h>
+#include <algorithm>
 
 //  Copyright (c) 2013, Facebook, Inc.  All rights reserved.
 //  This source code is licensed under the BSD-style license found in the
@@ -17,27 +21,33 @@
 // and endian-ness issues if used across multiple platforms.
 //
 // 64-bit hash for 64-bit platforms
-uint64_t murmur_hash64(const void * key, int len, uint64_t seed) {
-  const uint64_t m = 0xc6a4a7935bd1e995;
-  const int r = 47;
+namespace {
+const uint64_t kMurmur64M = 0xc6a4a7935bd1e995;
+const int kMurmur64R = 47;
 
-  uint64_t h = seed ^ (len * m);
+inline uint64_t murmur64Block(uint64_t h, const char* p) {
+  uint64_t k;
+  ::memcpy(&k, p, 8);
 
-  const uint64_t * data = (const uint64_t *) key;
-  const uint64_t * end = data + (len / 8);
+  k *= kMurmur64M;
+  k ^= k >> kMurmur64R;
+  k *= kMurmur64M;
 
-  while (data != end) {
-    uint64_t k = *data++;
+  h ^= k;
+  return h * kMurmur64M;
+}
 
-    k *= m;
-    k ^= k >> r;
-    k *= m;
+// the blocks of @key, the tail and the final mix.
+inline uint64_t murmur64Finish(uint64_t h, const char* key, int len) {
+  const uint64_t m = kMurmur64M;
+  const int r = kMurmur64R;
 
-    h ^= k;
-    h *= m;
+  const char* end = key + (len / 8) * 8;
+  for (; key != end; key += 8) {
+    h = murmur64Block(h, key);
   }
 
-  const unsigned char * data2 = (const unsigned char*) data;
+  const unsigned char * data2 = (const unsigned char*) key;
 
   switch (len & 7) {
     case 7:
@@ -64,6 +74,59 @@ uint64_t murmur_hash64(const void * key, int len, uint64_t seed) {
   return h;
 }
 
+// 4 keys are mixed together over their common blocks, the multiplies of
+// them overlap.
+template<typename Keys>
+void murmur64Keys(const Keys& keys, size_t n, uint64_t seed, uint64_t* out) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const char* p0 = keys.data(i);
+    const char* p1 = keys.data(i + 1);
+    const char* p2 = keys.data(i + 2);
+    const char* p3 = keys.data(i + 3);
+    int len0 = keys.size(i), len1 = keys.size(i + 1);
+    int len2 = keys.size(i + 2), len3 = keys.size(i + 3);
+    int common = std::min(std::min(len0, len1), std::min(len2, len3)) & ~7;
+
+    uint64_t h0 = seed ^ (len0 * kMurmur64M);
+    uint64_t h1 = seed ^ (len1 * kMurmur64M);
+    uint64_t h2 = seed ^ (len2 * kMurmur64M);
+    uint64_t h3 = seed ^ (len3 * kMurmur64M);
+    for (int k = 0; k < common; k += 8) {
+      h0 = murmur64Block(h0, p0 + k);
+      h1 = murmur64Block(h1, p1 + k);
+      h2 = murmur64Block(h2, p2 + k);
+      h3 = murmur64Block(h3, p3 + k);
+    }
+
+    out[i] = murmur64Finish(h0, p0 + common, len0 - common);
+    out[i + 1] = murmur64Finish(h1, p1 + common, len1 - common);
+    out[i + 2] = murmur64Finish(h2, p2 + common, len2 - common);
+    out[i + 3] = murmur64Finish(h3, p3 + common, len3 - common);
+  }
+
+  for (; i < n; ++i) {
+    out[i] = murmur_hash64(keys.data(i), keys.size(i), seed);
+  }
+}
+}
+
+uint64_t murmur_hash64(const char* key, int len, uint64_t seed) {
+  return murmur64Finish(seed ^ (len * kMurmur64M), key, len);
+}
+
+void murmur_hash64_batch(const char* const* keys, const uint32_t* lens,
+                         size_t n, uint64_t seed, uint64_t* out) {
+  hash_keys::PtrKeys k = { keys, lens };
+  murmur64Keys(k, n, seed, out);
+}
+
+void murmur_hash64_batch(const std::vector<std::string>& keys, uint64_t seed,
+                         uint64_t* out) {
+  hash_keys::StrKeys k = { keys.data() };
+  murmur64Keys(k, keys.size(), seed, out);
+}
+
 // -------------------------------------------------------------------
 //
 // Note - This code makes a few assumptions about how your machine behaves -
@@ -77,7 +140,7 @@ uint64_t murmur_hash64(const void * key, int len, uint64_t seed) {
 // 2. It will not produce the same results on little-endian and big-endian
 //    machines.
 
-unsigned int murmur_hash32(const void * key, int len, uint32_t seed) {
+uint32_t murmur_hash32(const char* key, int len, uint32_t seed) {
   // 'm' and 'r' are mixing constants generated offline.
   // They're not really 'magic', they just happen to work well.
 
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 uint32_t murmur_hash32(const char* data, int len, uint32_t seed);
 inline uint32_t murmur_hash32(const char* data, int len) {
@@ -25,3 +26,10 @@ inline uint64_t murmur_hash64(const std::string& s) {
   return murmur_hash64(s, 0);
 }
 
+
+// murmur_hash64 of @n keys, @keys[i] has @lens[i] bytes.  the multiply
+// chains of several keys are interleaved, the results are the same.
+void murmur_hash64_batch(const char* const* keys, const uint32_t* lens,
+                         size_t n, uint64_t seed, uint64_t* out);
+void murmur_hash64_batch(const std::vector<std::string>& keys, uint64_t seed,
+                         uint64_t* out);
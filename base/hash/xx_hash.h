@@ -1,6 +1,7 @@
 #pragma once
 
 #include "xx_hash_internal.h"
+#include "xx_hash64.h"  // XXH64 and XXH3
 
 // for xxhash.
 inline uint32 XXHash32(const char* data, uint32 len, uint32 seed) {
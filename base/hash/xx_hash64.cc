@@ -0,0 +1,869 @@
+/*
+ * XXH64 and XXH3 from xxHash 0.8 by Yann Collet, BSD 2-Clause License.
+ * https://github.com/Cyan4973/xxHash
+ */
+
+#include "xx_hash64.h"
+#include "hash_keys.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define XXH3_HAVE_SIMD
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const uint64 PRIME32_1 = 0x9E3779B1U;
+const uint64 PRIME32_2 = 0x85EBCA77U;
+const uint64 PRIME32_3 = 0xC2B2AE3DU;
+
+const uint64 PRIME64_1 = 0x9E3779B185EBCA87ULL;
+const uint64 PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64 PRIME64_3 = 0x165667B19E3779F9ULL;
+const uint64 PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+const uint64 PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+const uint64 PRIME_MX1 = 0x165667919E3779F9ULL;
+const uint64 PRIME_MX2 = 0x9FB21C651E98DF25ULL;
+
+typedef unsigned char uint8x;
+
+inline uint32 read32(const uint8x* p) {
+  uint32 v;
+  ::memcpy(&v, p, 4);
+  return v;
+}
+
+inline uint64 read64(const uint8x* p) {
+  uint64 v;
+  ::memcpy(&v, p, 8);
+  return v;
+}
+
+inline void write64(uint8x* p, uint64 v) {
+  ::memcpy(p, &v, 8);
+}
+
+inline uint64 rotl64(uint64 x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+inline uint32 rotl32(uint32 x, int r) {
+  return (x << r) | (x >> (32 - r));
+}
+
+inline XXH128Value mul128(uint64 a, uint64 b) {
+  unsigned __int128 m = (unsigned __int128) a * b;
+  XXH128Value r = { static_cast<uint64>(m), static_cast<uint64>(m >> 64) };
+  return r;
+}
+
+inline uint64 mul128Fold64(uint64 a, uint64 b) {
+  XXH128Value m = mul128(a, b);
+  return m.low64 ^ m.high64;
+}
+
+// ---------------------------------------------------------------- XXH64
+
+inline uint64 xxh64Round(uint64 acc, uint64 input) {
+  acc += input * PRIME64_2;
+  acc = rotl64(acc, 31);
+  return acc * PRIME64_1;
+}
+
+inline uint64 xxh64Merge(uint64 acc, uint64 val) {
+  acc ^= xxh64Round(0, val);
+  return acc * PRIME64_1 + PRIME64_4;
+}
+
+inline uint64 xxh64Avalanche(uint64 h) {
+  h ^= h >> 33;
+  h *= PRIME64_2;
+  h ^= h >> 29;
+  h *= PRIME64_3;
+  h ^= h >> 32;
+  return h;
+}
+
+// consume 32 bytes stripes, return the end.
+inline const uint8x* xxh64Stripes(uint64* v, const uint8x* p,
+                                  const uint8x* limit) {
+  do {
+    v[0] = xxh64Round(v[0], read64(p));
+    v[1] = xxh64Round(v[1], read64(p + 8));
+    v[2] = xxh64Round(v[2], read64(p + 16));
+    v[3] = xxh64Round(v[3], read64(p + 24));
+    p += 32;
+  } while (p <= limit);
+  return p;
+}
+
+inline uint64 xxh64Converge(const uint64* v) {
+  uint64 h = rotl64(v[0], 1) + rotl64(v[1], 7) + rotl64(v[2], 12) +
+      rotl64(v[3], 18);
+  h = xxh64Merge(h, v[0]);
+  h = xxh64Merge(h, v[1]);
+  h = xxh64Merge(h, v[2]);
+  return xxh64Merge(h, v[3]);
+}
+
+uint64 xxh64Finalize(uint64 h, const uint8x* p, size_t len) {
+  len &= 31;
+  for (; len >= 8; len -= 8, p += 8) {
+    h ^= xxh64Round(0, read64(p));
+    h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+  }
+  if (len >= 4) {
+    h ^= read32(p) * PRIME64_1;
+    h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+    p += 4;
+    len -= 4;
+  }
+  for (; len > 0; --len, ++p) {
+    h ^= *p * PRIME64_5;
+    h = rotl64(h, 11) * PRIME64_1;
+  }
+  return xxh64Avalanche(h);
+}
+
+inline void xxh64Init(uint64* v, uint64 seed) {
+  v[0] = seed + PRIME64_1 + PRIME64_2;
+  v[1] = seed + PRIME64_2;
+  v[2] = seed;
+  v[3] = seed - PRIME64_1;
+}
+
+// ----------------------------------------------------------------- XXH3
+
+const uint8x kSecret[192] = {
+  0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c,
+  0xf7, 0x21, 0xad, 0x1c, 0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb,
+  0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f, 0xcb, 0x79, 0xe6, 0x4e,
+  0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+  0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6,
+  0x81, 0x3a, 0x26, 0x4c, 0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb,
+  0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3, 0x71, 0x64, 0x48, 0x97,
+  0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+  0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7,
+  0xc7, 0x0b, 0x4f, 0x1d, 0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31,
+  0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64, 0xea, 0xc5, 0xac, 0x83,
+  0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+  0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26,
+  0x29, 0xd4, 0x68, 0x9e, 0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc,
+  0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce, 0x45, 0xcb, 0x3a, 0x8f,
+  0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+const size_t kSecretSize = sizeof(kSecret);
+const size_t kStripeLen = 64;
+const size_t kStripesPerBlock = (kSecretSize - kStripeLen) / 8;
+const size_t kBlockLen = kStripeLen * kStripesPerBlock;
+const size_t kSecretLastAccStart = 7;
+const size_t kSecretMergeAccsStart = 11;
+const size_t kMidSizeMax = 240;
+
+inline uint64 xxh3Avalanche(uint64 h) {
+  h ^= h >> 37;
+  h *= PRIME_MX1;
+  return h ^ (h >> 32);
+}
+
+inline uint64 rrmxmx(uint64 h, uint64 len) {
+  h ^= rotl64(h, 49) ^ rotl64(h, 24);
+  h *= PRIME_MX2;
+  h ^= (h >> 35) + len;
+  h *= PRIME_MX2;
+  return h ^ (h >> 28);
+}
+
+inline uint64 mix16B(const uint8x* p, const uint8x* secret, uint64 seed) {
+  return mul128Fold64(read64(p) ^ (read64(secret) + seed),
+                      read64(p + 8) ^ (read64(secret + 8) - seed));
+}
+
+inline uint64 xxh3Len0To16(const uint8x* p, size_t len,
+                           const uint8x* secret, uint64 seed) {
+  if (len > 8) {
+    uint64 bitflip1 = (read64(secret + 24) ^ read64(secret + 32)) + seed;
+    uint64 bitflip2 = (read64(secret + 40) ^ read64(secret + 48)) - seed;
+    uint64 lo = read64(p) ^ bitflip1;
+    uint64 hi = read64(p + len - 8) ^ bitflip2;
+    uint64 acc = len + __builtin_bswap64(lo) + hi + mul128Fold64(lo, hi);
+    return xxh3Avalanche(acc);
+  }
+
+  if (len >= 4) {
+    seed ^= static_cast<uint64>(__builtin_bswap32(static_cast<uint32>(seed)))
+        << 32;
+    uint64 bitflip = (read64(secret + 8) ^ read64(secret + 16)) - seed;
+    uint64 input = read32(p + len - 4) +
+        (static_cast<uint64>(read32(p)) << 32);
+    return rrmxmx(input ^ bitflip, len);
+  }
+
+  if (len > 0) {
+    uint32 combined = (static_cast<uint32>(p[0]) << 16) |
+        (static_cast<uint32>(p[len >> 1]) << 24) | p[len - 1] |
+        static_cast<uint32>(len << 8);
+    uint64 bitflip = (read32(secret) ^ read32(secret + 4)) + seed;
+    return xxh64Avalanche(combined ^ bitflip);
+  }
+
+  return xxh64Avalanche(seed ^ read64(secret + 56) ^ read64(secret + 64));
+}
+
+inline uint64 xxh3Len17To128(const uint8x* p, size_t len,
+                             const uint8x* secret, uint64 seed) {
+  uint64 acc = len * PRIME64_1;
+  if (len > 32) {
+    if (len > 64) {
+      if (len > 96) {
+        acc += mix16B(p + 48, secret + 96, seed);
+        acc += mix16B(p + len - 64, secret + 112, seed);
+      }
+      acc += mix16B(p + 32, secret + 64, seed);
+      acc += mix16B(p + len - 48, secret + 80, seed);
+    }
+    acc += mix16B(p + 16, secret + 32, seed);
+    acc += mix16B(p + len - 32, secret + 48, seed);
+  }
+  acc += mix16B(p, secret, seed);
+  acc += mix16B(p + len - 16, secret + 16, seed);
+  return xxh3Avalanche(acc);
+}
+
+uint64 xxh3Len129To240(const uint8x* p, size_t len, const uint8x* secret,
+                       uint64 seed) {
+  uint64 acc = len * PRIME64_1;
+  size_t rounds = len / 16;
+  for (size_t i = 0; i < 8; ++i) {
+    acc += mix16B(p + 16 * i, secret + 16 * i, seed);
+  }
+  acc = xxh3Avalanche(acc);
+
+  for (size_t i = 8; i < rounds; ++i) {
+    acc += mix16B(p + 16 * i, secret + 16 * (i - 8) + 3, seed);
+  }
+  acc += mix16B(p + len - 16, secret + 136 - 17, seed);
+  return xxh3Avalanche(acc);
+}
+
+XXH128Value xxh3Len0To16x128(const uint8x* p, size_t len,
+                             const uint8x* secret, uint64 seed) {
+  XXH128Value h;
+  if (len > 8) {
+    uint64 bitflipl = (read64(secret + 32) ^ read64(secret + 40)) - seed;
+    uint64 bitfliph = (read64(secret + 48) ^ read64(secret + 56)) + seed;
+    uint64 lo = read64(p);
+    uint64 hi = read64(p + len - 8);
+    XXH128Value m = mul128(lo ^ hi ^ bitflipl, PRIME64_1);
+    m.low64 += static_cast<uint64>(len - 1) << 54;
+    hi ^= bitfliph;
+    m.high64 += hi + static_cast<uint32>(hi) * (PRIME32_2 - 1);
+    m.low64 ^= __builtin_bswap64(m.high64);
+
+    h = mul128(m.low64, PRIME64_2);
+    h.high64 += m.high64 * PRIME64_2;
+    h.low64 = xxh3Avalanche(h.low64);
+    h.high64 = xxh3Avalanche(h.high64);
+    return h;
+  }
+
+  if (len >= 4) {
+    seed ^= static_cast<uint64>(__builtin_bswap32(static_cast<uint32>(seed)))
+        << 32;
+    uint64 input = read32(p) + (static_cast<uint64>(read32(p + len - 4)) << 32);
+    uint64 bitflip = (read64(secret + 16) ^ read64(secret + 24)) + seed;
+    XXH128Value m = mul128(input ^ bitflip, PRIME64_1 + (len << 2));
+    m.high64 += m.low64 << 1;
+    m.low64 ^= m.high64 >> 3;
+    m.low64 ^= m.low64 >> 35;
+    m.low64 *= PRIME_MX2;
+    m.low64 ^= m.low64 >> 28;
+    m.high64 = xxh3Avalanche(m.high64);
+    return m;
+  }
+
+  if (len > 0) {
+    uint32 combinedl = (static_cast<uint32>(p[0]) << 16) |
+        (static_cast<uint32>(p[len >> 1]) << 24) | p[len - 1] |
+        static_cast<uint32>(len << 8);
+    uint32 combinedh = rotl32(__builtin_bswap32(combinedl), 13);
+    uint64 bitflipl = (read32(secret) ^ read32(secret + 4)) + seed;
+    uint64 bitfliph = (read32(secret + 8) ^ read32(secret + 12)) - seed;
+    h.low64 = xxh64Avalanche(combinedl ^ bitflipl);
+    h.high64 = xxh64Avalanche(combinedh ^ bitfliph);
+    return h;
+  }
+
+  h.low64 = xxh64Avalanche(seed ^ read64(secret + 64) ^ read64(secret + 72));
+  h.high64 = xxh64Avalanche(seed ^ read64(secret + 80) ^ read64(secret + 88));
+  return h;
+}
+
+inline void mix32B(XXH128Value* acc, const uint8x* p1, const uint8x* p2,
+                   const uint8x* secret, uint64 seed) {
+  acc->low64 += mix16B(p1, secret, seed);
+  acc->low64 ^= read64(p2) + read64(p2 + 8);
+  acc->high64 += mix16B(p2, secret + 16, seed);
+  acc->high64 ^= read64(p1) + read64(p1 + 8);
+}
+
+inline XXH128Value xxh3Finish128(const XXH128Value& acc, size_t len,
+                                 uint64 seed) {
+  XXH128Value h;
+  h.low64 = xxh3Avalanche(acc.low64 + acc.high64);
+  h.high64 = 0 - xxh3Avalanche(acc.low64 * PRIME64_1 +
+                               acc.high64 * PRIME64_4 +
+                               (len - seed) * PRIME64_2);
+  return h;
+}
+
+XXH128Value xxh3Len17To128x128(const uint8x* p, size_t len,
+                               const uint8x* secret, uint64 seed) {
+  XXH128Value acc = { len * PRIME64_1, 0 };
+  if (len > 32) {
+    if (len > 64) {
+      if (len > 96) {
+        mix32B(&acc, p + 48, p + len - 64, secret + 96, seed);
+      }
+      mix32B(&acc, p + 32, p + len - 48, secret + 64, seed);
+    }
+    mix32B(&acc, p + 16, p + len - 32, secret + 32, seed);
+  }
+  mix32B(&acc, p, p + len - 16, secret, seed);
+  return xxh3Finish128(acc, len, seed);
+}
+
+XXH128Value xxh3Len129To240x128(const uint8x* p, size_t len,
+                                const uint8x* secret, uint64 seed) {
+  XXH128Value acc = { len * PRIME64_1, 0 };
+  size_t rounds = len / 32;
+  for (size_t i = 0; i < 4; ++i) {
+    mix32B(&acc, p + 32 * i, p + 32 * i + 16, secret + 32 * i, seed);
+  }
+  acc.low64 = xxh3Avalanche(acc.low64);
+  acc.high64 = xxh3Avalanche(acc.high64);
+
+  for (size_t i = 4; i < rounds; ++i) {
+    mix32B(&acc, p + 32 * i, p + 32 * i + 16, secret + 3 + 32 * (i - 4),
+           seed);
+  }
+  mix32B(&acc, p + len - 16, p + len - 32, secret + 136 - 17 - 16, 0 - seed);
+  return xxh3Finish128(acc, len, seed);
+}
+
+/*
+ * long inputs: 8 accumulators eat 64 bytes stripes, the accumulators are
+ * scrambled after every block of 16 stripes.
+ */
+typedef void (*AccumulateFun)(uint64* acc, const uint8x* p,
+                              const uint8x* secret, size_t stripes);
+typedef void (*ScrambleFun)(uint64* acc, const uint8x* secret);
+
+void accumulateScalar(uint64* acc, const uint8x* p, const uint8x* secret,
+                      size_t stripes) {
+  for (size_t n = 0; n < stripes; ++n, p += kStripeLen, secret += 8) {
+    for (int i = 0; i < 8; ++i) {
+      uint64 data = read64(p + 8 * i);
+      uint64 key = data ^ read64(secret + 8 * i);
+      acc[i ^ 1] += data;
+      acc[i] += static_cast<uint32>(key) * (key >> 32);
+    }
+  }
+}
+
+void scrambleScalar(uint64* acc, const uint8x* secret) {
+  for (int i = 0; i < 8; ++i) {
+    uint64 a = acc[i];
+    a ^= a >> 47;
+    a ^= read64(secret + 8 * i);
+    acc[i] = a * PRIME32_1;
+  }
+}
+
+#ifdef XXH3_HAVE_SIMD
+
+void accumulateSse2(uint64* acc, const uint8x* p, const uint8x* secret,
+                    size_t stripes) {
+  __m128i a[4];
+  for (int i = 0; i < 4; ++i) {
+    a[i] = _mm_loadu_si128((const __m128i*) acc + i);
+  }
+
+  for (size_t n = 0; n < stripes; ++n, p += kStripeLen, secret += 8) {
+    for (int i = 0; i < 4; ++i) {
+      __m128i data = _mm_loadu_si128((const __m128i*) p + i);
+      __m128i key = _mm_loadu_si128((const __m128i*) secret + i);
+      __m128i dk = _mm_xor_si128(data, key);
+      __m128i dk_hi = _mm_shuffle_epi32(dk, _MM_SHUFFLE(0, 3, 0, 1));
+      __m128i product = _mm_mul_epu32(dk, dk_hi);
+      __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+      a[i] = _mm_add_epi64(a[i], _mm_add_epi64(product, swapped));
+    }
+  }
+
+  for (int i = 0; i < 4; ++i) {
+    _mm_storeu_si128((__m128i*) acc + i, a[i]);
+  }
+}
+
+void scrambleSse2(uint64* acc, const uint8x* secret) {
+  const __m128i prime = _mm_set1_epi32(static_cast<int>(PRIME32_1));
+  for (int i = 0; i < 4; ++i) {
+    __m128i a = _mm_loadu_si128((const __m128i*) acc + i);
+    a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+    a = _mm_xor_si128(a, _mm_loadu_si128((const __m128i*) secret + i));
+    __m128i a_hi = _mm_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1));
+    __m128i lo = _mm_mul_epu32(a, prime);
+    __m128i hi = _mm_mul_epu32(a_hi, prime);
+    _mm_storeu_si128((__m128i*) acc + i,
+                     _mm_add_epi64(lo, _mm_slli_epi64(hi, 32)));
+  }
+}
+
+__attribute__((target("avx2")))
+void accumulateAvx2(uint64* acc, const uint8x* p, const uint8x* secret,
+                    size_t stripes) {
+  __m256i a0 = _mm256_loadu_si256((const __m256i*) acc);
+  __m256i a1 = _mm256_loadu_si256((const __m256i*) acc + 1);
+
+  for (size_t n = 0; n < stripes; ++n, p += kStripeLen, secret += 8) {
+    __m256i d0 = _mm256_loadu_si256((const __m256i*) p);
+    __m256i d1 = _mm256_loadu_si256((const __m256i*) p + 1);
+    __m256i k0 = _mm256_xor_si256(
+        d0, _mm256_loadu_si256((const __m256i*) secret));
+    __m256i k1 = _mm256_xor_si256(
+        d1, _mm256_loadu_si256((const __m256i*) secret + 1));
+    __m256i p0 = _mm256_mul_epu32(
+        k0, _mm256_shuffle_epi32(k0, _MM_SHUFFLE(0, 3, 0, 1)));
+    __m256i p1 = _mm256_mul_epu32(
+        k1, _mm256_shuffle_epi32(k1, _MM_SHUFFLE(0, 3, 0, 1)));
+    a0 = _mm256_add_epi64(a0, _mm256_add_epi64(
+        p0, _mm256_shuffle_epi32(d0, _MM_SHUFFLE(1, 0, 3, 2))));
+    a1 = _mm256_add_epi64(a1, _mm256_add_epi64(
+        p1, _mm256_shuffle_epi32(d1, _MM_SHUFFLE(1, 0, 3, 2))));
+  }
+
+  _mm256_storeu_si256((__m256i*) acc, a0);
+  _mm256_storeu_si256((__m256i*) acc + 1, a1);
+  _mm256_zeroupper();
+}
+
+__attribute__((target("avx2")))
+void scrambleAvx2(uint64* acc, const uint8x* secret) {
+  const __m256i prime = _mm256_set1_epi32(static_cast<int>(PRIME32_1));
+  for (int i = 0; i < 2; ++i) {
+    __m256i a = _mm256_loadu_si256((const __m256i*) acc + i);
+    a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+    a = _mm256_xor_si256(a, _mm256_loadu_si256((const __m256i*) secret + i));
+    __m256i a_hi = _mm256_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1));
+    __m256i lo = _mm256_mul_epu32(a, prime);
+    __m256i hi = _mm256_mul_epu32(a_hi, prime);
+    _mm256_storeu_si256((__m256i*) acc + i,
+                        _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32)));
+  }
+  _mm256_zeroupper();
+}
+
+// the os must save ymm registers too.
+bool cpuHasAvx2() {
+  uint32 eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+  if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) return false;
+
+  uint32 xcr0, xcr0_hi;
+  __asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0_hi) : "c"(0));
+  if ((xcr0 & 6) != 6) return false;
+
+  if (__get_cpuid_max(0, NULL) < 7) return false;
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  return (ebx & bit_AVX2) != 0;
+}
+
+const bool kHaveSse2 = true;
+const bool kHaveAvx2 = cpuHasAvx2();
+
+#else
+
+const bool kHaveSse2 = false;
+const bool kHaveAvx2 = false;
+
+#endif
+
+struct LongImpl {
+  AccumulateFun accumulate;
+  ScrambleFun scramble;
+};
+
+LongImpl longImpl(XXH3Impl impl) {
+  LongImpl r = { accumulateScalar, scrambleScalar };
+#ifdef XXH3_HAVE_SIMD
+  if (impl == XXH3_SSE2) {
+    r.accumulate = accumulateSse2;
+    r.scramble = scrambleSse2;
+  } else if (impl == XXH3_AVX2) {
+    r.accumulate = accumulateAvx2;
+    r.scramble = scrambleAvx2;
+  }
+#endif
+  return r;
+}
+
+const LongImpl kBestLongImpl = longImpl(xxh3BestImpl());
+
+void initAcc(uint64* acc) {
+  acc[0] = PRIME32_3;
+  acc[1] = PRIME64_1;
+  acc[2] = PRIME64_2;
+  acc[3] = PRIME64_3;
+  acc[4] = PRIME64_4;
+  acc[5] = PRIME32_2;
+  acc[6] = PRIME64_5;
+  acc[7] = PRIME32_1;
+}
+
+// the secret of a seed, kSecret with the seed added.
+void initSecret(uint8x* secret, uint64 seed) {
+  for (size_t i = 0; i < kSecretSize; i += 16) {
+    write64(secret + i, read64(kSecret + i) + seed);
+    write64(secret + i + 8, read64(kSecret + i + 8) - seed);
+  }
+}
+
+void hashLong(const LongImpl& impl, uint64* acc, const uint8x* p,
+              size_t len, const uint8x* secret) {
+  initAcc(acc);
+  size_t blocks = (len - 1) / kBlockLen;
+  for (size_t n = 0; n < blocks; ++n) {
+    impl.accumulate(acc, p + n * kBlockLen, secret, kStripesPerBlock);
+    impl.scramble(acc, secret + kSecretSize - kStripeLen);
+  }
+
+  size_t stripes = ((len - 1) - kBlockLen * blocks) / kStripeLen;
+  impl.accumulate(acc, p + blocks * kBlockLen, secret, stripes);
+  impl.accumulate(acc, p + len - kStripeLen,
+                  secret + kSecretSize - kStripeLen - kSecretLastAccStart, 1);
+}
+
+uint64 mergeAccs(const uint64* acc, const uint8x* secret, uint64 start) {
+  uint64 h = start;
+  for (int i = 0; i < 4; ++i) {
+    h += mul128Fold64(acc[2 * i] ^ read64(secret + 16 * i),
+                      acc[2 * i + 1] ^ read64(secret + 16 * i + 8));
+  }
+  return xxh3Avalanche(h);
+}
+
+inline uint64 merge64(const uint64* acc, const uint8x* secret, size_t len) {
+  return mergeAccs(acc, secret + kSecretMergeAccsStart, len * PRIME64_1);
+}
+
+inline XXH128Value merge128(const uint64* acc, const uint8x* secret,
+                            size_t len) {
+  XXH128Value h;
+  h.low64 = mergeAccs(acc, secret + kSecretMergeAccsStart, len * PRIME64_1);
+  h.high64 = mergeAccs(acc, secret + kSecretSize - 64 - kSecretMergeAccsStart,
+                       ~(len * PRIME64_2));
+  return h;
+}
+
+// hash of inputs up to 240 bytes.
+uint64 xxh3Short64(const uint8x* p, size_t len, uint64 seed) {
+  if (len <= 16) return xxh3Len0To16(p, len, kSecret, seed);
+  if (len <= 128) return xxh3Len17To128(p, len, kSecret, seed);
+  return xxh3Len129To240(p, len, kSecret, seed);
+}
+
+XXH128Value xxh3Short128(const uint8x* p, size_t len, uint64 seed) {
+  if (len <= 16) return xxh3Len0To16x128(p, len, kSecret, seed);
+  if (len <= 128) return xxh3Len17To128x128(p, len, kSecret, seed);
+  return xxh3Len129To240x128(p, len, kSecret, seed);
+}
+
+uint64 xxh3Long64(const LongImpl& impl, const uint8x* p, size_t len,
+                  uint64 seed) {
+  uint64 acc[8];
+  if (seed == 0) {
+    hashLong(impl, acc, p, len, kSecret);
+    return merge64(acc, kSecret, len);
+  }
+
+  uint8x secret[kSecretSize];
+  initSecret(secret, seed);
+  hashLong(impl, acc, p, len, secret);
+  return merge64(acc, secret, len);
+}
+
+XXH128Value xxh3Long128(const LongImpl& impl, const uint8x* p, size_t len,
+                        uint64 seed) {
+  uint64 acc[8];
+  if (seed == 0) {
+    hashLong(impl, acc, p, len, kSecret);
+    return merge128(acc, kSecret, len);
+  }
+
+  uint8x secret[kSecretSize];
+  initSecret(secret, seed);
+  hashLong(impl, acc, p, len, secret);
+  return merge128(acc, secret, len);
+}
+
+}  // namespace
+
+uint64 XXHash64(const void* input, size_t len, uint64 seed) {
+  const uint8x* p = static_cast<const uint8x*>(input);
+  uint64 h;
+  if (len >= 32) {
+    uint64 v[4];
+    xxh64Init(v, seed);
+    p = xxh64Stripes(v, p, p + len - 32);
+    h = xxh64Converge(v);
+  } else {
+    h = seed + PRIME64_5;
+  }
+
+  h += len;
+  return xxh64Finalize(h, p, len);
+}
+
+XXH3Impl xxh3BestImpl() {
+  if (kHaveAvx2) return XXH3_AVX2;
+  if (kHaveSse2) return XXH3_SSE2;
+  return XXH3_SCALAR;
+}
+
+bool xxh3ImplSupported(XXH3Impl impl) {
+  switch (impl) {
+    case XXH3_SCALAR:
+      return true;
+    case XXH3_SSE2:
+      return kHaveSse2;
+    case XXH3_AVX2:
+      return kHaveAvx2;
+    default:
+      return false;
+  }
+}
+
+const char* xxh3ImplName(XXH3Impl impl) {
+  static const char* names[] = { "scalar", "sse2", "avx2" };
+  if (impl < 0 || impl >= XXH3_IMPL_NUM) return "unknown";
+  return names[impl];
+}
+
+uint64 XXH3Hash64(const void* input, size_t len, uint64 seed) {
+  const uint8x* p = static_cast<const uint8x*>(input);
+  if (len <= kMidSizeMax) return xxh3Short64(p, len, seed);
+  return xxh3Long64(kBestLongImpl, p, len, seed);
+}
+
+XXH128Value XXH3Hash128(const void* input, size_t len, uint64 seed) {
+  const uint8x* p = static_cast<const uint8x*>(input);
+  if (len <= kMidSizeMax) return xxh3Short128(p, len, seed);
+  return xxh3Long128(kBestLongImpl, p, len, seed);
+}
+
+namespace {
+// short keys take the inlined paths, and the keys ahead are prefetched.
+template<typename Keys>
+void xxh3Keys(const Keys& keys, size_t n, uint64 seed, uint64* out) {
+  const size_t kAhead = 16;
+  for (size_t i = 0; i < n; ++i) {
+    if (i + kAhead < n) __builtin_prefetch(keys.data(i + kAhead));
+
+    const uint8x* p = reinterpret_cast<const uint8x*>(keys.data(i));
+    size_t len = keys.size(i);
+    if (len <= 16) {
+      out[i] = xxh3Len0To16(p, len, kSecret, seed);
+    } else if (len <= 128) {
+      out[i] = xxh3Len17To128(p, len, kSecret, seed);
+    } else if (len <= kMidSizeMax) {
+      out[i] = xxh3Len129To240(p, len, kSecret, seed);
+    } else {
+      out[i] = xxh3Long64(kBestLongImpl, p, len, seed);
+    }
+  }
+}
+}
+
+void XXH3Hash64Batch(const char* const* keys, const uint32* lens, size_t n,
+                     uint64 seed, uint64* out) {
+  hash_keys::PtrKeys k = { keys, lens };
+  xxh3Keys(k, n, seed, out);
+}
+
+void XXH3Hash64Batch(const std::vector<std::string>& keys, uint64 seed,
+                     uint64* out) {
+  hash_keys::StrKeys k = { keys.data() };
+  xxh3Keys(k, keys.size(), seed, out);
+}
+
+uint64 XXH3Hash64(XXH3Impl impl, const void* input, size_t len, uint64 seed) {
+  const uint8x* p = static_cast<const uint8x*>(input);
+  if (len <= kMidSizeMax) return xxh3Short64(p, len, seed);
+  return xxh3Long64(longImpl(impl), p, len, seed);
+}
+
+XXH128Value XXH3Hash128(XXH3Impl impl, const void* input, size_t len,
+                        uint64 seed) {
+  const uint8x* p = static_cast<const uint8x*>(input);
+  if (len <= kMidSizeMax) return xxh3Short128(p, len, seed);
+  return xxh3Long128(longImpl(impl), p, len, seed);
+}
+
+void XXH64State::reset(uint64 seed) {
+  total_len_ = 0;
+  seed_ = seed;
+  xxh64Init(v_, seed);
+  memsize_ = 0;
+}
+
+void XXH64State::update(const void* input, size_t len) {
+  const uint8x* p = static_cast<const uint8x*>(input);
+  const uint8x* const end = p + len;
+  total_len_ += len;
+
+  if (memsize_ + len < 32) {
+    ::memcpy(mem_ + memsize_, p, len);
+    memsize_ += len;
+    return;
+  }
+
+  if (memsize_ > 0) {
+    ::memcpy(mem_ + memsize_, p, 32 - memsize_);
+    const uint8x* m = reinterpret_cast<const uint8x*>(mem_);
+    xxh64Stripes(v_, m, m);
+    p += 32 - memsize_;
+    memsize_ = 0;
+  }
+
+  if (p + 32 <= end) p = xxh64Stripes(v_, p, end - 32);
+
+  if (p < end) {
+    ::memcpy(mem_, p, end - p);
+    memsize_ = end - p;
+  }
+}
+
+uint64 XXH64State::digest() const {
+  uint64 h;
+  if (total_len_ >= 32) {
+    h = xxh64Converge(v_);
+  } else {
+    h = seed_ + PRIME64_5;
+  }
+
+  h += total_len_;
+  return xxh64Finalize(h, reinterpret_cast<const uint8x*>(mem_), memsize_);
+}
+
+namespace {
+// accumulate @stripes, scramble at the end of a block.
+void consumeStripes(uint64* acc, uint32* stripes_so_far, const uint8x* p,
+                    size_t stripes, const uint8x* secret) {
+  const LongImpl& impl = kBestLongImpl;
+  const uint8x* scramble_secret = secret + kSecretSize - kStripeLen;
+  if (kStripesPerBlock - *stripes_so_far <= stripes) {
+    size_t to_end = kStripesPerBlock - *stripes_so_far;
+    size_t from_start = stripes - to_end;
+    impl.accumulate(acc, p, secret + *stripes_so_far * 8, to_end);
+    impl.scramble(acc, scramble_secret);
+    impl.accumulate(acc, p + to_end * kStripeLen, secret, from_start);
+    *stripes_so_far = from_start;
+  } else {
+    impl.accumulate(acc, p, secret + *stripes_so_far * 8, stripes);
+    *stripes_so_far += stripes;
+  }
+}
+}
+
+void XXH3State::reset(uint64 seed) {
+  initAcc(acc_);
+  initSecret(secret_, seed);
+  buffered_ = 0;
+  stripes_ = 0;
+  total_len_ = 0;
+  seed_ = seed;
+}
+
+// the buffer always keeps the last byte, so the last stripe is hashed by
+// the digest.
+void XXH3State::update(const void* input, size_t len) {
+  const uint8x* p = static_cast<const uint8x*>(input);
+  const uint8x* const end = p + len;
+  const size_t stripes = sizeof(buffer_) / kStripeLen;
+  total_len_ += len;
+
+  if (buffered_ + len <= sizeof(buffer_)) {
+    ::memcpy(buffer_ + buffered_, p, len);
+    buffered_ += len;
+    return;
+  }
+
+  if (buffered_ > 0) {
+    size_t n = sizeof(buffer_) - buffered_;
+    ::memcpy(buffer_ + buffered_, p, n);
+    p += n;
+    consumeStripes(acc_, &stripes_, buffer_, stripes, secret_);
+    buffered_ = 0;
+  }
+
+  if (p + sizeof(buffer_) < end) {
+    const uint8x* limit = end - sizeof(buffer_);
+    do {
+      consumeStripes(acc_, &stripes_, p, stripes, secret_);
+      p += sizeof(buffer_);
+    } while (p < limit);
+
+    // the last stripe may need bytes before the buffered ones.
+    ::memcpy(buffer_ + sizeof(buffer_) - kStripeLen, p - kStripeLen,
+             kStripeLen);
+  }
+
+  ::memcpy(buffer_, p, end - p);
+  buffered_ = end - p;
+}
+
+void XXH3State::digestLong(uint64* acc) const {
+  const LongImpl& impl = kBestLongImpl;
+  const uint8x* last_secret =
+      secret_ + kSecretSize - kStripeLen - kSecretLastAccStart;
+
+  ::memcpy(acc, acc_, sizeof(acc_));
+  if (buffered_ >= kStripeLen) {
+    uint32 stripes_so_far = stripes_;
+    consumeStripes(acc, &stripes_so_far, buffer_,
+                   (buffered_ - 1) / kStripeLen, secret_);
+    impl.accumulate(acc, buffer_ + buffered_ - kStripeLen, last_secret, 1);
+  } else {
+    uint8x last[kStripeLen];
+    size_t catchup = kStripeLen - buffered_;
+    ::memcpy(last, buffer_ + sizeof(buffer_) - catchup, catchup);
+    ::memcpy(last + catchup, buffer_, buffered_);
+    impl.accumulate(acc, last, last_secret, 1);
+  }
+}
+
+uint64 XXH3State::digest64() const {
+  if (total_len_ <= kMidSizeMax) {
+    return xxh3Short64(buffer_, total_len_, seed_);
+  }
+
+  uint64 acc[8];
+  digestLong(acc);
+  return merge64(acc, secret_, total_len_);
+}
+
+XXH128Value XXH3State::digest128() const {
+  if (total_len_ <= kMidSizeMax) {
+    return xxh3Short128(buffer_, total_len_, seed_);
+  }
+
+  uint64 acc[8];
+  digestLong(acc);
+  return merge128(acc, secret_, total_len_);
+}
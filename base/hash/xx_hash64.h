@@ -0,0 +1,124 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "../data_types.h"
+
+/*
+ * XXH64 and XXH3 of xxHash 0.8, the same results as the reference
+ * implementation on little-endian machines.
+ *
+ *   XXH3 is the fastest for both short keys and large buffers, XXH64 is
+ *   kept for data already hashed by it.
+ */
+struct XXH128Value {
+  uint64 low64;
+  uint64 high64;
+};
+
+inline bool operator==(const XXH128Value& a, const XXH128Value& b) {
+  return a.low64 == b.low64 && a.high64 == b.high64;
+}
+inline bool operator!=(const XXH128Value& a, const XXH128Value& b) {
+  return !(a == b);
+}
+
+uint64 XXHash64(const void* data, size_t len, uint64 seed);
+inline uint64 XXHash64(const void* data, size_t len) {
+  return XXHash64(data, len, 0);
+}
+inline uint64 XXHash64(const std::string& data, uint64 seed = 0) {
+  return XXHash64(data.data(), data.size(), seed);
+}
+
+uint64 XXH3Hash64(const void* data, size_t len, uint64 seed);
+inline uint64 XXH3Hash64(const void* data, size_t len) {
+  return XXH3Hash64(data, len, 0);
+}
+inline uint64 XXH3Hash64(const std::string& data, uint64 seed = 0) {
+  return XXH3Hash64(data.data(), data.size(), seed);
+}
+
+XXH128Value XXH3Hash128(const void* data, size_t len, uint64 seed);
+inline XXH128Value XXH3Hash128(const void* data, size_t len) {
+  return XXH3Hash128(data, len, 0);
+}
+inline XXH128Value XXH3Hash128(const std::string& data, uint64 seed = 0) {
+  return XXH3Hash128(data.data(), data.size(), seed);
+}
+
+// XXH3Hash64 of @n keys, @keys[i] has @lens[i] bytes.
+void XXH3Hash64Batch(const char* const* keys, const uint32* lens, size_t n,
+                     uint64 seed, uint64* out);
+void XXH3Hash64Batch(const std::vector<std::string>& keys, uint64 seed,
+                     uint64* out);
+
+// implementations of the XXH3 loop for inputs over 240 bytes, for test and
+// benchmark.
+enum XXH3Impl {
+  XXH3_SCALAR = 0,
+  XXH3_SSE2,  // 2 lanes of 64 bits
+  XXH3_AVX2,  // 4 lanes of 64 bits
+  XXH3_IMPL_NUM,
+};
+
+// the one used by XXH3Hash64() and XXH3Hash128().
+XXH3Impl xxh3BestImpl();
+bool xxh3ImplSupported(XXH3Impl impl);
+const char* xxh3ImplName(XXH3Impl impl);
+
+// @impl must be supported.
+uint64 XXH3Hash64(XXH3Impl impl, const void* data, size_t len, uint64 seed);
+XXH128Value XXH3Hash128(XXH3Impl impl, const void* data, size_t len,
+                        uint64 seed);
+
+// streaming states, digest() can be called at any time, and data can be
+// fed after it.
+class XXH64State {
+  public:
+    explicit XXH64State(uint64 seed = 0) {
+      reset(seed);
+    }
+
+    void reset(uint64 seed = 0);
+    void update(const void* data, size_t len);
+    void update(const std::string& data) {
+      update(data.data(), data.size());
+    }
+
+    uint64 digest() const;
+
+  private:
+    uint64 total_len_;
+    uint64 seed_;
+    uint64 v_[4];
+    char mem_[32];
+    uint32 memsize_;
+};
+
+class XXH3State {
+  public:
+    explicit XXH3State(uint64 seed = 0) {
+      reset(seed);
+    }
+
+    void reset(uint64 seed = 0);
+    void update(const void* data, size_t len);
+    void update(const std::string& data) {
+      update(data.data(), data.size());
+    }
+
+    uint64 digest64() const;
+    XXH128Value digest128() const;
+
+  private:
+    uint64 acc_[8];
+    unsigned char secret_[192];
+    unsigned char buffer_[256];
+    uint32 buffered_;
+    uint32 stripes_;  // stripes accumulated in the current block
+    uint64 total_len_;
+    uint64 seed_;
+
+    void digestLong(uint64* acc) const;
+};
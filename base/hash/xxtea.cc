@@ -1,180 +1,485 @@
 #include "xxtea.h"
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
 #include <vector>
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#define XXTEA_HAVE_SIMD
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
 namespace xx {
-static int xxtea_encode(const unsigned char* str, int slen, const unsigned char* key, int keylen, unsigned char* enc_chr, int enclen)
-{
-    unsigned int* v = NULL;
-    int vlen;
+const uint32 kDelta = 0x9E3779B9;
 
-    int n;
-    int q;
+#define MX (((z >> 5 ^ y << 2) + (y >> 3 ^ z << 4)) ^ \
+            ((sum ^ y) + (k[(p & 3) ^ e] ^ z)))
 
-    unsigned int z;
-    unsigned int y;
-    unsigned int delta;
-    unsigned int mx, e;
-    unsigned int sum;
-    int i;
-    unsigned int k[4];
+// @n words, at least 1.
+static void encrypt(uint32* v, uint32 n, const uint32* k) {
+    uint32 last = n - 1;
+    uint32 z = v[last], y, e, p;
+    uint32 sum = 0;
+    uint32 q = 6 + 52 / n;
 
-    vlen = (slen & 3);
-    if(vlen == 0){
-        vlen = slen + 4;
-    }
-    else{
-        vlen = slen + 8 - vlen;
+    while (q-- > 0) {
+        sum += kDelta;
+        e = sum >> 2 & 3;
+        for (p = 0; p < last; ++p) {
+            y = v[p + 1];
+            z = v[p] += MX;
+        }
+        y = v[0];
+        z = v[last] += MX;
     }
+}
 
-    if(enc_chr == NULL){
-        return vlen;
+// @n words, at least 2.
+static void decrypt(uint32* v, uint32 n, const uint32* k) {
+    uint32 last = n - 1;
+    uint32 z, y = v[0], e, p;
+    uint32 q = 6 + 52 / n;
+    uint32 sum = q * kDelta;
+
+    while (sum != 0) {
+        e = sum >> 2 & 3;
+        for (p = last; p > 0; --p) {
+            z = v[p - 1];
+            y = v[p] -= MX;
+        }
+        z = v[last];
+        y = v[0] -= MX;
+        sum -= kDelta;
     }
-    if(enclen < vlen) return -1;
+}
 
-    enclen = vlen;
+#undef MX
 
-    if(enc_chr != str){
-        memcpy(enc_chr, str, slen * sizeof(unsigned char));
-    }
+// pad @buf of @len bytes and append the length, return the words.
+static uint32 pad(char* buf, int len) {
+    int padded = (len + 3) & ~3;
+    memset(buf + len, 0, padded - len);
+    uint32 n = len;
+    memcpy(buf + padded, &n, 4);
+    return padded / 4 + 1;
+}
 
+// check the length word of a decrypted message and terminate it.
+static int unpad(char* buf, int len) {
+    uint32 n;
+    memcpy(&n, buf + len - 4, 4);
+    if (n > static_cast<uint32>(len - 4)) return -4;
+    buf[n] = '\0';
+    return n;
+}
 
-    v = (unsigned int*)enc_chr;
-    vlen = enclen >> 2;
+// lanes of interleaved messages of the same length, word i of lane l is
+// at v[i * lanes + l].
+typedef void (*BatchFun)(uint32* v, uint32 n, const uint32* k);
+
+#ifdef XXTEA_HAVE_SIMD
+
+#define VMX(z, y, kx, sumv) \
+    XOR(ADD(XOR(SHR(z, 5), SHL(y, 2)), XOR(SHR(y, 3), SHL(z, 4))), \
+        ADD(XOR(sumv, y), XOR(kx, z)))
+
+#define ADD(x, y)       _mm_add_epi32((x), (y))
+#define SUB(x, y)       _mm_sub_epi32((x), (y))
+#define XOR(x, y)       _mm_xor_si128((x), (y))
+#define SHL(x, n)       _mm_slli_epi32((x), (n))
+#define SHR(x, n)       _mm_srli_epi32((x), (n))
+#define SET1(x)         _mm_set1_epi32(static_cast<int>(x))
+#define LOAD(i)         _mm_loadu_si128((const __m128i*) (v + (i) * 4))
+#define STORE(i, x)     _mm_storeu_si128((__m128i*) (v + (i) * 4), (x))
+
+static void encryptSse2(uint32* v, uint32 n, const uint32* k) {
+    uint32 last = n - 1;
+    uint32 sum = 0;
+    uint32 q = 6 + 52 / n;
+    __m128i z = LOAD(last), y;
+
+    while (q-- > 0) {
+        sum += kDelta;
+        uint32 e = sum >> 2 & 3;
+        __m128i sumv = SET1(sum);
+        for (uint32 p = 0; p < last; ++p) {
+            y = LOAD(p + 1);
+            z = ADD(LOAD(p), VMX(z, y, SET1(k[(p & 3) ^ e]), sumv));
+            STORE(p, z);
+        }
+        y = LOAD(0);
+        z = ADD(LOAD(last), VMX(z, y, SET1(k[(last & 3) ^ e]), sumv));
+        STORE(last, z);
+    }
+}
 
-    v[vlen - 1] = slen;
+static void decryptSse2(uint32* v, uint32 n, const uint32* k) {
+    uint32 last = n - 1;
+    uint32 q = 6 + 52 / n;
+    uint32 sum = q * kDelta;
+    __m128i y = LOAD(0), z;
 
-    if((slen & 3) != 0){
-        memset((enc_chr + slen), 0, (4 - (slen & 3)) * sizeof(unsigned char));
+    while (sum != 0) {
+        uint32 e = sum >> 2 & 3;
+        __m128i sumv = SET1(sum);
+        for (uint32 p = last; p > 0; --p) {
+            z = LOAD(p - 1);
+            y = SUB(LOAD(p), VMX(z, y, SET1(k[(p & 3) ^ e]), sumv));
+            STORE(p, y);
+        }
+        z = LOAD(last);
+        y = SUB(LOAD(0), VMX(z, y, SET1(k[e]), sumv));
+        STORE(0, y);
+        sum -= kDelta;
     }
+}
 
-    memcpy(k, key, keylen);
+#undef ADD
+#undef SUB
+#undef XOR
+#undef SHL
+#undef SHR
+#undef SET1
+#undef LOAD
+#undef STORE
+
+#define ADD(x, y)       _mm256_add_epi32((x), (y))
+#define SUB(x, y)       _mm256_sub_epi32((x), (y))
+#define XOR(x, y)       _mm256_xor_si256((x), (y))
+#define SHL(x, n)       _mm256_slli_epi32((x), (n))
+#define SHR(x, n)       _mm256_srli_epi32((x), (n))
+#define SET1(x)         _mm256_set1_epi32(static_cast<int>(x))
+#define LOAD(i)         _mm256_loadu_si256((const __m256i*) (v + (i) * 8))
+#define STORE(i, x)     _mm256_storeu_si256((__m256i*) (v + (i) * 8), (x))
+
+__attribute__((target("avx2")))
+static void encryptAvx2(uint32* v, uint32 n, const uint32* k) {
+    uint32 last = n - 1;
+    uint32 sum = 0;
+    uint32 q = 6 + 52 / n;
+    __m256i z = LOAD(last), y;
+
+    while (q-- > 0) {
+        sum += kDelta;
+        uint32 e = sum >> 2 & 3;
+        __m256i sumv = SET1(sum);
+        for (uint32 p = 0; p < last; ++p) {
+            y = LOAD(p + 1);
+            z = ADD(LOAD(p), VMX(z, y, SET1(k[(p & 3) ^ e]), sumv));
+            STORE(p, z);
+        }
+        y = LOAD(0);
+        z = ADD(LOAD(last), VMX(z, y, SET1(k[(last & 3) ^ e]), sumv));
+        STORE(last, z);
+    }
+    _mm256_zeroupper();
+}
 
-    n = vlen - 1;
-    z = v[n];
-    y = v[0];
-    delta = 0x9E3779B9;
-    q = 6 + 52 / (n + 1);
-    sum = 0;
-    while (0 < q--) {
-        sum = sum + delta ;
-        e = sum >> 2 & 3;
-        for (i = 0; i < n; i++) {
-            y = v[i + 1];
-            mx = (unsigned int)(z >> 5 ^ y << 2) + (unsigned int)(y >> 3 ^ z << 4) ^ (sum ^ y) + (unsigned int)(k[(((unsigned int)i) & 3) ^ e] ^ z);
-            z = v[i] = v[i] + mx ;
+__attribute__((target("avx2")))
+static void decryptAvx2(uint32* v, uint32 n, const uint32* k) {
+    uint32 last = n - 1;
+    uint32 q = 6 + 52 / n;
+    uint32 sum = q * kDelta;
+    __m256i y = LOAD(0), z;
+
+    while (sum != 0) {
+        uint32 e = sum >> 2 & 3;
+        __m256i sumv = SET1(sum);
+        for (uint32 p = last; p > 0; --p) {
+            z = LOAD(p - 1);
+            y = SUB(LOAD(p), VMX(z, y, SET1(k[(p & 3) ^ e]), sumv));
+            STORE(p, y);
         }
-        y = v[0];
-        mx = (z >> 5 ^ y << 2) + (y >> 3 ^ z << 4) ^ (sum ^ y) + (k[(((unsigned int)i) & 3) ^ e] ^ z);
-        z = v[n] = v[n] + mx & 0xffffffff;
+        z = LOAD(last);
+        y = SUB(LOAD(0), VMX(z, y, SET1(k[e]), sumv));
+        STORE(0, y);
+        sum -= kDelta;
     }
+    _mm256_zeroupper();
+}
 
-    return vlen << 2;
+#undef ADD
+#undef SUB
+#undef XOR
+#undef SHL
+#undef SHR
+#undef SET1
+#undef LOAD
+#undef STORE
+#undef VMX
+
+// the os must save ymm registers too.
+static bool cpuHasAvx2() {
+    uint32 eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+    if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) return false;
+
+    uint32 xcr0, xcr0_hi;
+    __asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0_hi) : "c"(0));
+    if ((xcr0 & 6) != 6) return false;
+
+    if (__get_cpuid_max(0, NULL) < 7) return false;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return (ebx & bit_AVX2) != 0;
 }
 
-static int xxtea_decode(const unsigned char* str, int slen, const unsigned char* key, int keylen, unsigned char* dec_chr, int declen) {
-    unsigned int* v = NULL;
-    int vlen;
-    int i;
+static const bool kHaveSse2 = true;
+static const bool kHaveAvx2 = cpuHasAvx2();
+
+#else
+
+static const bool kHaveSse2 = false;
+static const bool kHaveAvx2 = false;
 
-    int n;
-    unsigned int z;
-    unsigned int y;
-    unsigned int delta;
-    unsigned int mx, e;
-    int q;
-    unsigned int sum;
-    unsigned int k[4];
+#endif
 
-    vlen = slen;
-    if((slen & 3) != 0){
-        return -1;
+/*
+ * run @fun over @n messages, @lanes at a time.  messages are grouped by
+ * length, those left over of a group are done by @scalar.  @words(i) is
+ * the words of message i, 0 to skip it.
+ */
+template<typename Words, typename Scalar>
+static void batch(BatchFun fun, uint32 lanes, char* const* bufs, size_t n,
+                  const uint32* k, Words words, Scalar scalar) {
+    std::vector<std::pair<uint32, size_t>> order;
+    for (size_t i = 0; i < n; ++i) {
+        uint32 w = words(i);
+        if (w != 0) order.push_back(std::make_pair(w, i));
     }
+    std::sort(order.begin(), order.end());
+
+    std::vector<uint32> v;
+    for (size_t start = 0; start < order.size();) {
+        uint32 w = order[start].first;
+        size_t end = start;
+        while (end < order.size() && order[end].first == w) ++end;
+
+        for (; fun != NULL && start + lanes <= end; start += lanes) {
+            v.resize(w * lanes);
+            for (uint32 l = 0; l < lanes; ++l) {
+                const char* p = bufs[order[start + l].second];
+                for (uint32 j = 0; j < w; ++j) {
+                    memcpy(&v[j * lanes + l], p + j * 4, 4);
+                }
+            }
+            fun(v.data(), w, k);
+            for (uint32 l = 0; l < lanes; ++l) {
+                char* p = bufs[order[start + l].second];
+                for (uint32 j = 0; j < w; ++j) {
+                    memcpy(p + j * 4, &v[j * lanes + l], 4);
+                }
+            }
+        }
 
-    if(dec_chr == NULL){
-        return vlen;
+        for (; start < end; ++start) scalar(order[start].second);
     }
-    if(declen < vlen) return -2;
+}
+} // namespace xx
 
-    declen = vlen;
+XxteaImpl xxteaBestImpl() {
+    if (xx::kHaveAvx2) return XXTEA_AVX2;
+    if (xx::kHaveSse2) return XXTEA_SSE2;
+    return XXTEA_SCALAR;
+}
 
-    if(dec_chr != str){
-        memcpy(dec_chr, str, slen * sizeof(unsigned char));
+bool xxteaImplSupported(XxteaImpl impl) {
+    switch (impl) {
+        case XXTEA_SCALAR:
+            return true;
+        case XXTEA_SSE2:
+            return xx::kHaveSse2;
+        case XXTEA_AVX2:
+            return xx::kHaveAvx2;
+        default:
+            return false;
     }
+}
+
+const char* xxteaImplName(XxteaImpl impl) {
+    static const char* names[] = { "scalar", "sse2", "avx2" };
+    if (impl < 0 || impl >= XXTEA_IMPL_NUM) return "unknown";
+    return names[impl];
+}
+
+XxteaKey::XxteaKey(const char* key, int keylen) {
+    memset(_k, 0, sizeof(_k));
+    memcpy(_k, key, std::min(std::max(keylen, 0), 16));
+}
+
+XxteaKey::XxteaKey(const std::string& key) {
+    memset(_k, 0, sizeof(_k));
+    memcpy(_k, key.data(), std::min<size_t>(key.size(), 16));
+}
+
+int XxteaKey::encode(const char* data, int len, char* out,
+                     int out_len) const {
+    int vlen = xxtea_encode_bound(len);
+    if (out == NULL) return vlen;
+    if (out_len < vlen) return -1;
+
+    if (out != data) memcpy(out, data, len);
+    uint32 n = xx::pad(out, len);
+    xx::encrypt(reinterpret_cast<uint32*>(out), n, _k);
+    return vlen;
+}
 
-    v = (unsigned int*)dec_chr;
-    vlen = declen >> 2;
+int XxteaKey::decode(const char* data, int len, char* out,
+                     int out_len) const {
+    if ((len & 3) != 0) return -1;
+    if (out == NULL) return len;
+    if (out_len < len) return -2;
 
-    memcpy(k, key, keylen);
+    if (out != data) memcpy(out, data, len);
+    if (len / 4 < 2) return -3;
+    xx::decrypt(reinterpret_cast<uint32*>(out), len / 4, _k);
+    return xx::unpad(out, len);
+}
 
-    n = vlen - 1;
-    if (n == 0) {
-        return -3;
+void XxteaKey::encode(std::string* data) const {
+    int len = data->size();
+    data->resize(xxtea_encode_bound(len));
+    this->encode(&(*data)[0], len, &(*data)[0], data->size());
+}
+
+bool XxteaKey::decode(std::string* data) const {
+    if (data->empty()) return false;
+    int n = this->decode(&(*data)[0], data->size(), &(*data)[0],
+                         data->size());
+    if (n < 0) return false;
+    data->resize(n);
+    return true;
+}
+
+void XxteaKey::encodeBatch(XxteaImpl impl, char* const* bufs,
+                           const int* lens, size_t n) const {
+    xx::BatchFun fun = NULL;
+    uint32 lanes = 1;
+#ifdef XXTEA_HAVE_SIMD
+    if (impl == XXTEA_SSE2) {
+        fun = xx::encryptSse2;
+        lanes = 4;
+    } else if (impl == XXTEA_AVX2) {
+        fun = xx::encryptAvx2;
+        lanes = 8;
     }
-    z = v[n - 1];
-    y = v[0];
-    delta = 0x9E3779B9;
-    q = 6 + 52 / (n + 1);
-    sum = q * delta;
+#endif
+
+    xx::batch(fun, lanes, bufs, n, _k,
+              [bufs, lens](size_t i) {
+                  return xx::pad(bufs[i], lens[i]);
+              },
+              [this, bufs, lens](size_t i) {
+                  xx::encrypt(reinterpret_cast<uint32*>(bufs[i]),
+                              xxtea_encode_bound(lens[i]) / 4, _k);
+              });
+}
 
-    while (sum != 0) {
-        e = sum >> 2 & 3;
-        for (i = n; i > 0; i--) {
-            z = v[i - 1];
-            mx = (unsigned int)(z >> 5 ^ y << 2) + (unsigned int)(y >> 3 ^ z << 4) ^ (sum ^ y) + (unsigned int)(k[(((unsigned int)i) & 3) ^ e] ^ z);
-            y = v[i] = v[i] - mx;
+void XxteaKey::decodeBatch(XxteaImpl impl, char* const* bufs,
+                           const int* lens, size_t n, int* results) const {
+    xx::BatchFun fun = NULL;
+    uint32 lanes = 1;
+#ifdef XXTEA_HAVE_SIMD
+    if (impl == XXTEA_SSE2) {
+        fun = xx::decryptSse2;
+        lanes = 4;
+    } else if (impl == XXTEA_AVX2) {
+        fun = xx::decryptAvx2;
+        lanes = 8;
+    }
+#endif
+
+    // errors before decryption are decided here, the rest after.
+    for (size_t i = 0; i < n; ++i) {
+        results[i] = 0;
+        if ((lens[i] & 3) != 0) {
+            results[i] = -1;
+        } else if (lens[i] / 4 < 2) {
+            results[i] = -3;
         }
-        z = v[n];
-        mx = (z >> 5 ^ y << 2) + (y >> 3 ^ z << 4) ^ (sum ^ y) + (k[(((unsigned int)i) & 3) ^ e] ^ z);
-        y = v[0] = v[0] - mx;
-        sum = sum - delta;
     }
 
-    n = v[vlen - 1];
+    xx::batch(fun, lanes, bufs, n, _k,
+              [lens, results](size_t i) -> uint32 {
+                  return results[i] < 0 ? 0 : lens[i] / 4;
+              },
+              [this, bufs, lens](size_t i) {
+                  xx::decrypt(reinterpret_cast<uint32*>(bufs[i]),
+                              lens[i] / 4, _k);
+              });
+
+    for (size_t i = 0; i < n; ++i) {
+        if (results[i] == 0) results[i] = xx::unpad(bufs[i], lens[i]);
+    }
+}
+
+void XxteaKey::encodeBatch(char* const* bufs, const int* lens,
+                           size_t n) const {
+    static const XxteaImpl impl = xxteaBestImpl();
+    this->encodeBatch(impl, bufs, lens, n);
+}
 
-    if(n >= 0 && n <= (vlen - 1) * 4){
-        dec_chr[n] = '\0';
-        return n;
+void XxteaKey::decodeBatch(char* const* bufs, const int* lens, size_t n,
+                           int* results) const {
+    static const XxteaImpl impl = xxteaBestImpl();
+    this->decodeBatch(impl, bufs, lens, n, results);
+}
+
+void XxteaKey::encodeBatch(std::vector<std::string>* msgs) const {
+    std::vector<char*> bufs(msgs->size());
+    std::vector<int> lens(msgs->size());
+    for (size_t i = 0; i < msgs->size(); ++i) {
+        std::string& s = (*msgs)[i];
+        lens[i] = s.size();
+        s.resize(xxtea_encode_bound(lens[i]));
+        bufs[i] = &s[0];
     }
-    return -4;
+    this->encodeBatch(bufs.data(), lens.data(), msgs->size());
+}
+
+bool XxteaKey::decodeBatch(std::vector<std::string>* msgs) const {
+    std::vector<char*> bufs(msgs->size());
+    std::vector<int> lens(msgs->size());
+    std::vector<int> results(msgs->size());
+    for (size_t i = 0; i < msgs->size(); ++i) {
+        std::string& s = (*msgs)[i];
+        lens[i] = s.size();
+        bufs[i] = s.empty() ? NULL : &s[0];
+    }
+    this->decodeBatch(bufs.data(), lens.data(), msgs->size(), results.data());
+
+    bool ok = true;
+    for (size_t i = 0; i < msgs->size(); ++i) {
+        if (results[i] < 0) {
+            ok = false;
+            (*msgs)[i].clear();
+        } else {
+            (*msgs)[i].resize(results[i]);
+        }
+    }
+    return ok;
 }
-} // namespace xx
 
 std::string xxtea_encode(const std::string &data, const std::string &key)
 {
-    int len = data.length()+8;
-    std::vector<unsigned char> enc;
-    enc.resize(len);
-
-    len = xx::xxtea_encode((unsigned char *)data.c_str(), data.length(), (unsigned char *)key.c_str(), 16, &enc[0], len);
-    std::string s((char *)&enc[0], len);
-
+    std::string s(data);
+    XxteaKey(key).encode(&s);
     return s;
 }
 
 std::string xxtea_decode(const std::string &data, const std::string &key)
 {
-    int len = data.length();
-    std::vector<unsigned char> tbs;
-    tbs.resize(len);
-
-    len = xx::xxtea_decode((unsigned char *)data.c_str(), data.length(), (unsigned char *)key.c_str(), 16, &tbs[0], len);
-    std::string s((char *)&tbs[0], len);
-
+    std::string s(data);
+    if (!XxteaKey(key).decode(&s)) s.clear();
     return s;
 }
 
 int xxtea_encode(const char* str, int slen, const char* key, int keylen,
                  char* enc_chr, int enclen) {
-    return xx::xxtea_encode((const unsigned char*) str, slen,
-                            (const unsigned char*) key, keylen,
-                            (unsigned char*) enc_chr, enclen);
+    return XxteaKey(key, keylen).encode(str, slen, enc_chr, enclen);
 }
 
 int xxtea_decode(const char* str, int slen, const char* key, int keylen,
                  char* dec_chr, int declen) {
-    return xx::xxtea_decode((const unsigned char*) str, slen,
-                            (const unsigned char*) key, keylen,
-                            (unsigned char*) dec_chr, declen);
+    return XxteaKey(key, keylen).decode(str, slen, dec_chr, declen);
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include "../data_types.h"
 
 //#define XXTEA_MX ((z >> 5 ^ y << 2) + (y >> 3 ^ z << 4)) ^ ((sum ^ y) + ((k[(p & 3) ^ e]) ^ z))
 //#define XXTEA_DELTA 0x9e3779b9
@@ -8,8 +10,72 @@
 std::string xxtea_encode(const std::string& data, const std::string& key);
 std::string xxtea_decode(const std::string& data, const std::string& key);
 
+/*
+ * encode to @enc_chr, which may be @str, return the encoded length, or -1
+ * if @enclen is too small.  return the length needed if @enc_chr is NULL.
+ */
 int xxtea_encode(const char* str, int slen, const char* key, int keylen,
                  char* enc_chr, int enclen);
 
+// return the decoded length, or a negative value on error.
 int xxtea_decode(const char* str, int slen, const char* key, int keylen,
                  char* dec_chr, int declen);
+
+// data is padded to 4 bytes and followed by its length.
+inline int xxtea_encode_bound(int len) {
+  return ((len + 3) & ~3) + 4;
+}
+
+// implementations of the batch functions of XxteaKey.
+enum XxteaImpl {
+  XXTEA_SCALAR = 0,
+  XXTEA_SSE2,  // 4 messages in the lanes of xmm registers
+  XXTEA_AVX2,  // 8 messages in the lanes of ymm registers
+  XXTEA_IMPL_NUM,
+};
+
+XxteaImpl xxteaBestImpl();
+bool xxteaImplSupported(XxteaImpl impl);
+const char* xxteaImplName(XxteaImpl impl);
+
+/*
+ * a key ready for use, to encode or decode many messages with the same key.
+ * the results are the same as xxtea_encode() and xxtea_decode().
+ *
+ *   xxtea is serial within a message, batches run messages of the same
+ *   length in parallel simd lanes, others one by one.
+ */
+class XxteaKey {
+  public:
+    // only the first 16 bytes are used, shorter keys are padded with zeros.
+    XxteaKey(const char* key, int keylen);
+    explicit XxteaKey(const std::string& key);
+
+    // the same as xxtea_encode() and xxtea_decode(), @out may be @data.
+    int encode(const char* data, int len, char* out, int out_len) const;
+    int decode(const char* data, int len, char* out, int out_len) const;
+
+    // in place, decode() returns false if @data isn't a valid encoding.
+    void encode(std::string* data) const;
+    bool decode(std::string* data) const;
+
+    // encode @n messages in place, @bufs[i] holds @lens[i] bytes and has
+    // room for xxtea_encode_bound(@lens[i]).
+    void encodeBatch(char* const* bufs, const int* lens, size_t n) const;
+    void encodeBatch(std::vector<std::string>* msgs) const;
+
+    // decode @n messages in place, @results[i] is what decode() returns.
+    void decodeBatch(char* const* bufs, const int* lens, size_t n,
+                     int* results) const;
+    // return false if any failed, failed ones are cleared.
+    bool decodeBatch(std::vector<std::string>* msgs) const;
+
+    // @impl must be supported.
+    void encodeBatch(XxteaImpl impl, char* const* bufs, const int* lens,
+                     size_t n) const;
+    void decodeBatch(XxteaImpl impl, char* const* bufs, const int* lens,
+                     size_t n, int* results) const;
+
+  private:
+    uint32 _k[4];
+};
@@ -0,0 +1,177 @@
+#include "histogram.h"
+#include "stream_buf.h"
+
+#include <math.h>
+#include <string.h>
+
+uint64 HistogramSnapshot::highest(uint32 i) {
+    if (i < 64) return i;
+
+    uint32 b = (i - 64) / 32 + 6;
+    uint64 low = static_cast<uint64>(32 + (i - 64) % 32) << (b - 5);
+    return low + ((1ULL << (b - 5)) - 1);
+}
+
+void HistogramSnapshot::merge(const HistogramSnapshot& s) {
+    for (uint32 i = 0; i < kBuckets; ++i) {
+        _counts[i] += s._counts[i];
+    }
+    _count += s._count;
+    _sum += s._sum;
+}
+
+void HistogramSnapshot::subtract(const HistogramSnapshot& old) {
+    for (uint32 i = 0; i < kBuckets; ++i) {
+        _counts[i] -= old._counts[i];
+    }
+    _count -= old._count;
+    _sum -= old._sum;
+}
+
+uint64 HistogramSnapshot::percentile(double p) const {
+    if (_count == 0) return 0;
+
+    uint64 rank = static_cast<uint64>(::ceil(p / 100 * _count));
+    if (rank == 0) rank = 1;
+    if (rank > _count) rank = _count;
+
+    uint64 n = 0;
+    for (uint32 i = 0; i < kBuckets; ++i) {
+        n += _counts[i];
+        if (n >= rank) return highest(i);
+    }
+
+    return 0;
+}
+
+std::string HistogramSnapshot::to_string() const {
+    StreamBuf sb(128);
+    sb << "count: " << _count << " mean: " << this->mean()
+       << " p50: " << this->percentile(50)
+       << " p90: " << this->percentile(90)
+       << " p99: " << this->percentile(99)
+       << " p999: " << this->percentile(99.9)
+       << " max: " << this->max();
+    return sb.to_string();
+}
+
+Histogram::Histogram(const std::string& name)
+    : _name(name) {
+    int err = ::pthread_key_create(&_key, &Histogram::release_shard);
+    CHECK_EQ(err, 0) << ::strerror(err);
+}
+
+Histogram::~Histogram() {
+    ::pthread_key_delete(_key);
+    for (size_t i = 0; i < _shards.size(); ++i) {
+        delete _shards[i];
+    }
+}
+
+// the counts of a dead thread stay in its shard for the next thread.
+void Histogram::release_shard(void* shard) {
+    atomic_release(&static_cast<Shard*>(shard)->used);
+}
+
+Histogram::Shard* Histogram::new_shard() {
+    Shard* s = NULL;
+    {
+        ::MutexGuard g(_mtx);
+        for (size_t i = 0; i < _shards.size(); ++i) {
+            if (atomic_swap(&_shards[i]->used, true) == false) {
+                s = _shards[i];
+                break;
+            }
+        }
+
+        if (s == NULL) {
+            s = new Shard();
+            s->used = true;
+            _shards.push_back(s);
+        }
+    }
+
+    ::pthread_setspecific(_key, s);
+    return s;
+}
+
+HistogramSnapshot Histogram::snapshot() const {
+    HistogramSnapshot r;
+
+    ::MutexGuard g(_mtx);
+    for (size_t i = 0; i < _shards.size(); ++i) {
+        const Shard* s = _shards[i];
+        for (uint32 k = 0; k < HistogramSnapshot::kBuckets; ++k) {
+            uint64 c = s->counts[k];
+            r._counts[k] += c;
+            r._count += c;
+        }
+        r._sum += s->sum;
+    }
+
+    return r;
+}
+
+namespace {
+::Mutex& histogramMutex() {
+    static ::Mutex mtx;
+    return mtx;
+}
+
+std::map<std::string, Histogram*>& histograms() {
+    static std::map<std::string, Histogram*> m;
+    return m;
+}
+
+std::vector<Histogram*> namedHistograms() {
+    std::vector<Histogram*> v;
+
+    ::MutexGuard g(histogramMutex());
+    for (auto it = histograms().begin(); it != histograms().end(); ++it) {
+        v.push_back(it->second);
+    }
+
+    return v;
+}
+} // namespace
+
+Histogram* NamedHistogram(const std::string& name) {
+    ::MutexGuard g(histogramMutex());
+    Histogram*& h = histograms()[name];
+    if (h == NULL) h = new Histogram(name);
+    return h;
+}
+
+std::string HistogramReport() {
+    std::string s;
+    auto v = namedHistograms();
+    for (size_t i = 0; i < v.size(); ++i) {
+        s += v[i]->name() + " " + v[i]->snapshot().to_string() + "\n";
+    }
+    return s;
+}
+
+HistogramDumper::HistogramDumper(uint32 sec, const char* tag)
+    : _tag(tag) {
+    _thread.reset(new StoppableThread(std::bind(&HistogramDumper::dump, this),
+                                      sec * 1000));
+    _thread->start();
+}
+
+HistogramDumper::~HistogramDumper() {
+    _thread->join();
+}
+
+void HistogramDumper::dump() {
+    auto v = namedHistograms();
+    for (size_t i = 0; i < v.size(); ++i) {
+        HistogramSnapshot s = v[i]->snapshot();
+        HistogramSnapshot& last = _last[v[i]->name()];
+
+        HistogramSnapshot d = s;
+        d.subtract(last);
+        last = s;
+
+        if (d.count() != 0) TLOG(_tag) << v[i]->name() << " " << d.to_string();
+    }
+}
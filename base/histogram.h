@@ -0,0 +1,172 @@
+#pragma once
+
+#include "data_types.h"
+#include "thread_util.h"
+#include "time_util.h"
+
+#include <pthread.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * counts of values in buckets, like HdrHistogram: values below 64 have a
+ * bucket each, larger ones keep their top 6 bits, so a bucket is at most
+ * 1/32 of its values wide.  snapshots of the same or different histograms
+ * can be merged.
+ */
+class HistogramSnapshot {
+  public:
+    enum {
+        kBuckets = 64 + 58 * 32,
+    };
+
+    HistogramSnapshot()
+        : _counts(kBuckets, 0), _count(0), _sum(0) {
+    }
+    ~HistogramSnapshot() = default;
+
+    void merge(const HistogramSnapshot& s);
+
+    // the counts recorded since @old, an earlier snapshot of this histogram.
+    void subtract(const HistogramSnapshot& old);
+
+    uint64 count() const {
+        return _count;
+    }
+    uint64 sum() const {
+        return _sum;
+    }
+    double mean() const {
+        return _count == 0 ? 0 : static_cast<double>(_sum) / _count;
+    }
+
+    // the value at @p percent in [0, 100], as the highest value of its
+    // bucket, 0 if empty.  min() and max() are the same for 0 and 100.
+    uint64 percentile(double p) const;
+    uint64 min() const {
+        return this->percentile(0);
+    }
+    uint64 max() const {
+        return this->percentile(100);
+    }
+
+    // count: 1024 mean: 12.3 p50: 10 p90: 21 p99: 40 p999: 97 max: 101
+    std::string to_string() const;
+
+    static uint32 bucket(uint64 v) {
+        if (v < 64) return static_cast<uint32>(v);
+        uint32 b = 63 - __builtin_clzll(v);
+        return 64 + (b - 6) * 32 + static_cast<uint32>((v >> (b - 5)) & 31);
+    }
+
+    // the largest value in bucket @i.
+    static uint64 highest(uint32 i);
+
+  private:
+    std::vector<uint64> _counts;
+    uint64 _count;
+    uint64 _sum;
+
+    friend class Histogram;
+};
+
+/*
+ * record() is lock-free, each thread counts in a shard of its own, and
+ * snapshot() sums the shards.  a shard is taken over by a new thread when
+ * its thread exits, so no counts are lost.
+ *
+ *   a Histogram must outlive the threads recording to it, the named ones
+ *   live as long as the process.
+ */
+class Histogram {
+  public:
+    explicit Histogram(const std::string& name);
+    ~Histogram();
+
+    const std::string& name() const {
+        return _name;
+    }
+
+    void record(uint64 v) {
+        Shard* s = static_cast<Shard*>(::pthread_getspecific(_key));
+        if (s == NULL) s = this->new_shard();
+
+        // only the owner thread writes, readers may see a count behind.
+        ++s->counts[HistogramSnapshot::bucket(v)];
+        s->sum += v;
+    }
+
+    HistogramSnapshot snapshot() const;
+
+  private:
+    struct Shard {
+        volatile uint64 counts[HistogramSnapshot::kBuckets];
+        volatile uint64 sum;
+        bool used;
+    };
+
+    std::string _name;
+    pthread_key_t _key;
+
+    mutable ::Mutex _mtx;
+    std::vector<Shard*> _shards;
+
+    Shard* new_shard();
+    static void release_shard(void* shard);
+
+    DISALLOW_COPY_AND_ASSIGN(Histogram);
+};
+
+// the histogram of @name, created on the first call and never freed.
+Histogram* NamedHistogram(const std::string& name);
+
+// one line for each named histogram, in the order of names.
+std::string HistogramReport();
+
+/*
+ * TLOG(@tag) the counts of the last @sec seconds of each named histogram
+ * that has any, every @sec seconds until it is destroyed.
+ */
+class HistogramDumper {
+  public:
+    explicit HistogramDumper(uint32 sec, const char* tag = "histogram");
+    ~HistogramDumper();
+
+  private:
+    const char* _tag;
+    std::map<std::string, HistogramSnapshot> _last;
+    std::unique_ptr<StoppableThread> _thread;
+
+    void dump();
+
+    DISALLOW_COPY_AND_ASSIGN(HistogramDumper);
+};
+
+// records the microseconds of its lifetime to a histogram.
+class HistogramTimer {
+  public:
+    explicit HistogramTimer(Histogram* h)
+        : _h(h) {
+    }
+    ~HistogramTimer() {
+        _h->record(_timer.us());
+    }
+
+  private:
+    Histogram* _h;
+    sys::timer _timer;
+
+    DISALLOW_COPY_AND_ASSIGN(HistogramTimer);
+};
+
+/*
+ * like AUTO_TIMER, but records microseconds of the scope to the named
+ * histogram @_name_, which is looked up only once.
+ *
+ *   HIST_TIMER("es.post");
+ */
+#define HIST_TIMER(_name_) \
+    static Histogram* hist_______ = NamedHistogram(_name_); \
+    HistogramTimer hist_timer_______(hist_______)
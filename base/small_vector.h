@@ -0,0 +1,88 @@
+#pragma once
+
+#include "data_types.h"
+
+#include <algorithm>
+
+/*
+ * a vector of @N elements on the stack, it moves to the heap only when it
+ * grows beyond @N.  for small temporary lists of trivial types, e.g. views
+ * of split_view().
+ *
+ *   SmallVector<util::StringView, 8> v;
+ *   util::split_view(line, ' ', &v);
+ */
+template <typename T, size_t N>
+class SmallVector {
+  public:
+    SmallVector()
+        : _data(_buf), _size(0), _capacity(N) {
+    }
+    ~SmallVector() {
+        if (_data != _buf) delete[] _data;
+    }
+
+    void push_back(const T& v) {
+        if (_size == _capacity) {
+            T x(v);  // @v may be an element of _data, freed by grow()
+            this->grow();
+            _data[_size++] = x;
+            return;
+        }
+        _data[_size++] = v;
+    }
+
+    void clear() {
+        _size = 0;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+    bool empty() const {
+        return _size == 0;
+    }
+
+    T& operator[](size_t i) {
+        return _data[i];
+    }
+    const T& operator[](size_t i) const {
+        return _data[i];
+    }
+
+    T& back() {
+        return _data[_size - 1];
+    }
+    const T& back() const {
+        return _data[_size - 1];
+    }
+
+    T* begin() {
+        return _data;
+    }
+    T* end() {
+        return _data + _size;
+    }
+    const T* begin() const {
+        return _data;
+    }
+    const T* end() const {
+        return _data + _size;
+    }
+
+  private:
+    T _buf[N];
+    T* _data;
+    size_t _size;
+    size_t _capacity;
+
+    void grow() {
+        T* data = new T[_capacity * 2];
+        std::copy(_data, _data + _size, data);
+        if (_data != _buf) delete[] _data;
+        _data = data;
+        _capacity *= 2;
+    }
+
+    DISALLOW_COPY_AND_ASSIGN(SmallVector);
+};
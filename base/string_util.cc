@@ -7,6 +7,13 @@
 #include <errno.h>
 #include <math.h>
 
+#include <memory>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define STRING_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace {
 util::ascii_table kIntUnit {
     std::map<char, int> {
@@ -41,44 +48,294 @@ std::string wchar2str(const wchar_t* wstr, ::size_t wlen) {
 namespace util {
 
 namespace xx {
+// a mismatch retries from the last '*' with one more letter for it, so
+// it's O(m * n) at worst without recursion.
 bool pattern_match(const char* p, const char* e) {
-    if (*p == '*' && *(p + 1) == '\0') return true;
+    const char* star_p = NULL;
+    const char* star_e = NULL;
+
+    while (*e != '\0') {
+        if (*p == '*') {
+            star_p = ++p;
+            star_e = e;
+        } else if (*p != '\0' && (*p == '?' || *p == *e)) {
+            ++p;
+            ++e;
+        } else if (star_p != NULL) {
+            p = star_p;
+            e = ++star_e;
+        } else {
+            return false;
+        }
+    }
 
-    for (; *p != '\0' && *e != '\0';) {
-        char c = *p;
+    // as ever, more than one '*' left doesn't match the empty string.
+    return *p == '\0' || (*p == '*' && *(p + 1) == '\0');
+}
 
-        if (c == '*') {
-            return pattern_match(p + 1, e) || pattern_match(p, e + 1);
+/*
+ * letters of @p with '?' for any letter, @stars[i] is set if a '*' follows
+ * the i-th letter, 0 for the start.  stars in a row are one, but "a**" is
+ * "a?*" as pattern_match() never matches "" with "**".
+ */
+void parse_pattern(const char* p, std::string* letters,
+                   std::vector<bool>* stars) {
+    stars->assign(1, false);
+    for (; *p != '\0'; ++p) {
+        if (*p != '*') {
+            letters->push_back(*p);
+            stars->push_back(false);
+            continue;
         }
 
-        if (c != '?' && c != *e) return false;
-        ++p;
-        ++e;
+        bool more = false;
+        while (*(p + 1) == '*') {
+            ++p;
+            more = true;
+        }
+        if (more && *(p + 1) == '\0') {
+            letters->push_back('?');
+            stars->push_back(false);
+        }
+        stars->back() = true;
     }
-
-    return (*p == '*' && *(p + 1) == '\0') || (*p == '\0' && *e == '\0');
 }
+
+inline bool part_equal(const std::string& part, bool any, const char* s) {
+    if (!any) return ::memcmp(part.data(), s, part.size()) == 0;
+
+    for (size_t i = 0; i < part.size(); ++i) {
+        if (part[i] != '?' && part[i] != s[i]) return false;
+    }
+    return true;
 }
+} // namespace xx
 
 bool pattern_match(const std::string& pattern, const std::string& expression) {
     return xx::pattern_match(pattern.c_str(), expression.c_str());
 }
 
+GlobPattern::GlobPattern(const std::string& pattern)
+    : _star(false), _prefix(), _suffix(), _min_len(0) {
+    std::string letters;
+    std::vector<bool> stars;
+    xx::parse_pattern(pattern.c_str(), &letters, &stars);
+
+    // parts between stars, cut after the i-th letter if a '*' follows.
+    std::vector<Part> parts(1, Part{ std::string(), false });
+    for (size_t i = 0; i <= letters.size(); ++i) {
+        if (i > 0) {
+            parts.back().s.push_back(letters[i - 1]);
+            if (letters[i - 1] == '?') parts.back().any = true;
+        }
+        if (stars[i]) parts.push_back(Part{ std::string(), false });
+    }
+
+    _star = parts.size() > 1;
+    _prefix = parts.front();
+    if (_star) {
+        _suffix = parts.back();
+        _middle.assign(parts.begin() + 1, parts.end() - 1);
+    }
+    _min_len = letters.size();
+}
+
+bool GlobPattern::match(const StringView& s) const {
+    const char* p = s.data();
+    const size_t n = s.size();
+    if (!_star) {
+        return n == _prefix.s.size() &&
+               xx::part_equal(_prefix.s, _prefix.any, p);
+    }
+
+    if (n < _min_len) return false;
+    if (!xx::part_equal(_prefix.s, _prefix.any, p)) return false;
+    if (!xx::part_equal(_suffix.s, _suffix.any, p + n - _suffix.s.size())) {
+        return false;
+    }
+
+    // the leftmost place of each part leaves the most room for the rest.
+    const char* b = p + _prefix.s.size();
+    const char* e = p + n - _suffix.s.size();
+    for (size_t i = 0; i < _middle.size(); ++i) {
+        const Part& m = _middle[i];
+        const size_t len = m.s.size();
+
+        for (;; ++b) {
+            if (static_cast<size_t>(e - b) < len) return false;
+            if (!m.any) {
+                b = static_cast<const char*>(
+                    ::memchr(b, m.s[0], e - b - len + 1));
+                if (b == NULL) return false;
+            }
+            if (xx::part_equal(m.s, m.any, b)) break;
+        }
+        b += len;
+    }
+
+    return true;
+}
+
+GlobSet::GlobSet(const std::vector<std::string>& patterns)
+    : _ncls(1), _words(0), _size(patterns.size()) {
+    std::vector<std::string> letters(patterns.size());
+    std::vector<std::vector<bool>> stars(patterns.size());
+
+    ::memset(_class, 0, sizeof(_class));
+    size_t states = 0;
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        xx::parse_pattern(patterns[i].c_str(), &letters[i], &stars[i]);
+        for (size_t k = 0; k < letters[i].size(); ++k) {
+            uint8 c = static_cast<uint8>(letters[i][k]);
+            if (c != '?' && _class[c] == 0) _class[c] = _ncls++;
+        }
+        states += letters[i].size() + 1;
+    }
+
+    _words = (states + 63) / 64;
+    _enter.assign(_ncls * _words, 0);
+    _init.assign(_words, 0);
+    _loop.assign(_words, 0);
+    _final.assign(_words, 0);
+    _pattern.resize(states);
+
+#define SET_BIT(v, b) (v)[(b) >> 6] |= 1ULL << ((b) & 63)
+
+    // pattern i takes states [x, x + letters), x for the start.
+    size_t x = 0;
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        const std::string& s = letters[i];
+        SET_BIT(_init, x);
+        SET_BIT(_final, x + s.size());
+
+        for (size_t k = 0; k <= s.size(); ++k) {
+            const size_t b = x + k;
+            _pattern[b] = static_cast<uint32>(i);
+            if (stars[i][k]) SET_BIT(_loop, b);
+            if (k == 0) continue;
+
+            const uint8 c = static_cast<uint8>(s[k - 1]);
+            if (c != '?') {
+                SET_BIT(&_enter[_class[c] * _words], b);
+            } else {
+                for (uint32 cls = 0; cls < _ncls; ++cls) {
+                    SET_BIT(&_enter[cls * _words], b);
+                }
+            }
+        }
+        x += s.size() + 1;
+    }
+
+#undef SET_BIT
+}
+
+bool GlobSet::match(const StringView& s, std::vector<uint32>* v) const {
+    v->clear();
+
+    uint64 buf[32];
+    std::unique_ptr<uint64[]> heap;
+    uint64* d = buf;
+    if (_words > 32) {
+        heap.reset(new uint64[_words]);
+        d = heap.get();
+    }
+    ::memcpy(d, _init.data(), _words * sizeof(uint64));
+
+    // d = (d << 1) & enter | d & loop, from the high word down, as a word
+    // takes the top bit of the one below it.
+    for (size_t i = 0; i < s.size(); ++i) {
+        const uint32 cls = _class[static_cast<uint8>(s[i])];
+        const uint64* enter = &_enter[cls * _words];
+        uint64 live = 0;
+        for (size_t w = _words; w-- > 0;) {
+            const uint64 carry = w > 0 ? d[w - 1] >> 63 : 0;
+            d[w] = (((d[w] << 1) | carry) & enter[w]) | (d[w] & _loop[w]);
+            live |= d[w];
+        }
+        if (live == 0) return false;
+    }
+
+    for (size_t w = 0; w < _words; ++w) {
+        for (uint64 m = d[w] & _final[w]; m != 0; m &= m - 1) {
+            v->push_back(_pattern[w * 64 + __builtin_ctzll(m)]);
+        }
+    }
+    return !v->empty();
+}
+
 /*
  * As C++ 11 support move semantics, it's ok to return vector.
  */
-std::vector<std::string> split_string(const std::string& s, char c) {
-    std::vector<std::string> v;
+const char* find_separ(const char* s, size_t n, const char* separ,
+                       size_t separ_size) {
+    if (separ_size == 1) return find_separ(s, n, separ[0]);
+    if (separ_size == 0) return s;
+    if (separ_size > n) return NULL;
+
+    size_t i = 0;
+#ifdef STRING_HAVE_SSE2
+    // candidates of 16 positions are those matching both the first and the
+    // last char of @separ.
+    const __m128i first = _mm_set1_epi8(separ[0]);
+    const __m128i last = _mm_set1_epi8(separ[separ_size - 1]);
+    for (; i + separ_size + 15 <= n; i += 16) {
+        __m128i f = _mm_loadu_si128((const __m128i*) (s + i));
+        __m128i l = _mm_loadu_si128((const __m128i*) (s + i + separ_size - 1));
+        uint32 mask = _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(f, first), _mm_cmpeq_epi8(l, last)));
+        while (mask != 0) {
+            uint32 k = __builtin_ctz(mask);
+            if (::memcmp(s + i + k + 1, separ + 1, separ_size - 2) == 0) {
+                return s + i + k;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
 
-    ::size_t pos = 0, from = 0;
-    if (!s.empty() && s[0] == c) from = 1;
+    for (; i + separ_size <= n; ++i) {
+        if (s[i] == separ[0] && ::memcmp(s + i, separ, separ_size) == 0) {
+            return s + i;
+        }
+    }
+    return NULL;
+}
+
+bool Tokenizer::next(StringView* field) {
+    if (_pos == NULL) return false;
+
+    size_t left = _end - _pos;
+    const char* p;
+    if (_separ.size() == 1) {
+        p = find_separ(_pos, left, _c);
+    } else if (_separ.empty()) {
+        p = NULL;
+    } else {
+        p = find_separ(_pos, left, _separ.data(), _separ.size());
+    }
+
+    if (p != NULL) {
+        *field = StringView(_pos, p - _pos);
+        _pos = p + _separ.size();
+        return true;
+    }
 
-    while ((pos = s.find(c, from)) != std::string::npos) {
-        v.push_back(s.substr(from, pos - from));
-        from = pos + 1;
+    // the last field, not empty.
+    if (left == 0) {
+        _pos = NULL;
+        return false;
     }
+    *field = StringView(_pos, left);
+    _pos = NULL;
+    return true;
+}
+
+std::vector<std::string> split_string(const std::string& s, char c) {
+    std::vector<std::string> v;
 
-    if (from < s.size()) v.push_back(s.substr(from));
+    Tokenizer t(s, c);
+    StringView field;
+    while (t.next(&field)) v.push_back(field.to_string());
 
     return v;
 }
@@ -87,14 +344,9 @@ std::vector<std::string> split_string(const std::string& s,
                                       const std::string& separ) {
     std::vector<std::string> v;
 
-    ::size_t pos = 0, from = 0;
-
-    while ((pos = s.find(separ, from)) != std::string::npos) {
-        if (pos != 0) v.push_back(s.substr(from, pos - from));
-        from = pos + separ.size();
-    }
-
-    if (from < s.size()) v.push_back(s.substr(from));
+    Tokenizer t(s, separ);
+    StringView field;
+    while (t.next(&field)) v.push_back(field.to_string());
 
     return v;
 }
@@ -133,152 +385,351 @@ std::string to_string(const std::wstring& wstr) {
     return wchar2str(wstr.c_str(), wstr.size());
 }
 
-bool to_bool(const std::string& v, bool* r, std::string& err) {
-    if (v == "true" || v == "1") {
-        *r = true;
-        return true;
-    }
+namespace {
+// isspace() of the C locale, as skipped by strtoll().
+inline bool is_space(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
 
-    if (v == "false" || v == "0") {
-        *r = false;
-        return true;
-    }
+inline bool is_digit(char c) {
+    return static_cast<uint8>(c - '0') < 10;
+}
 
-    err = std::string("invalid value for bool") + ": " + v;
-    return false;
+// SWAR: check and convert 8 ascii digits at once.
+inline uint64 load8(const char* p) {
+    uint64 v;
+    ::memcpy(&v, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
 }
 
-bool to_double(const std::string& v, double* r, std::string& err) {
-    char* end = NULL;
-    double x = ::strtod(v.c_str(), &end);
+inline bool is_8digits(uint64 v) {
+    return ((v & 0xF0F0F0F0F0F0F0F0ULL) |
+            (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+           0x3333333333333333ULL;
+}
 
-    if (errno == ERANGE && (x == HUGE_VAL || x == -HUGE_VAL)) {
-        errno = 0;
-        err = std::string("out of range for double") + ": " + v;
-        return false;
+inline uint64 parse_8digits(uint64 v) {
+    v -= 0x3030303030303030ULL;
+    v = v * 10 + (v >> 8);
+    return (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+            (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32))))
+           >> 32;
+}
+
+// append at most @max decimal digits at @p to @m, return the end of them.
+inline const char* scan_digits(const char* p, const char* e, size_t max,
+                               uint64* m) {
+    uint64 x = *m;
+    const char* end = p + std::min<size_t>(max, e - p);
+
+    for (; end - p >= 8; p += 8) {
+        const uint64 v = load8(p);
+        if (!is_8digits(v)) break;
+        x = x * 100000000 + parse_8digits(v);
     }
 
-    if (end != v.c_str() + v.size()) {
-        err = std::string("invalid value for double") + ": " + v;
-        return false;
+    for (; p < end && is_digit(*p); ++p) x = x * 10 + (*p - '0');
+
+    *m = x;
+    return p;
+}
+
+inline int hex_digit(char c) {
+    if (is_digit(c)) return c - '0';
+    c |= 0x20;
+    return (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+}
+
+/*
+ * strtoull(s, &end, 0) within [@s, @e): leading spaces, sign, 0x and 0
+ * prefixes.  return the end of the number, or @s if there are no digits.
+ * @over is set where strtoull() sets ERANGE.
+ */
+const char* scan_int(const char* s, const char* e, uint64* m, bool* neg,
+                     bool* over) {
+    const char* p = s;
+    while (p < e && is_space(*p)) ++p;
+
+    *neg = false;
+    if (p < e && (*p == '-' || *p == '+')) *neg = (*p++ == '-');
+
+    uint64 x = 0;
+    *over = false;
+    const char* begin = p;
+
+    if (p < e && *p == '0') {
+        if (e - p > 2 && (p[1] | 0x20) == 'x' && hex_digit(p[2]) >= 0) {
+            int d;
+            for (p += 2; p < e && (d = hex_digit(*p)) >= 0; ++p) {
+                if (x >> 60) *over = true;
+                x = (x << 4) | d;
+            }
+        } else {
+            for (++p; p < e && *p >= '0' && *p <= '7'; ++p) {
+                if (x >> 61) *over = true;
+                x = (x << 3) | (*p - '0');
+            }
+        }
+
+    } else {
+        // 19 digits never overflow
+        p = scan_digits(p, e, 19, &x);
+        for (; p < e && is_digit(*p); ++p) {
+            const uint32 d = *p - '0';
+            if (x > (MAX_UINT64 - d) / 10) *over = true;
+            x = x * 10 + d;
+        }
     }
 
-    *r = x;
-    return true;
+    if (p == begin) return s;
+    *m = *over ? MAX_UINT64 : x;
+    return p;
 }
 
-int64 to_int64(const char* v, uint32 len, std::string& err) {
-    if (len == 0) return 0;
+// units k, m, g, t, p at the end shift the number left by 10, 20 ... bits.
+inline size_t strip_units(const char* s, size_t len) {
+    while (len > 0 && kIntUnit.check(s[len - 1])) --len;
+    return len;
+}
+
+ParseError parse_int64(const char* s, size_t len, int64* r) {
+    const size_t n = strip_units(s, len);
+    int64 x = 0;
 
-    if (!kIntUnit.check(v[len - 1])) {
-        char* end = NULL;
-        int64 x = ::strtoll(v, &end, 0);
+    if (n > 0) {
+        uint64 m = 0;
+        bool neg, over;
+        const char* end = scan_int(s, s + n, &m, &neg, &over);
 
-        if (errno == ERANGE && (x == MIN_INT64 || x == MAX_INT64)) {
-            errno = 0;
-            goto range_err;
+        if (over || m > static_cast<uint64>(MAX_INT64) + neg) {
+            return PARSE_OUT_OF_RANGE;
         }
+        if (end != s + n) return PARSE_INVALID;
+
+        x = static_cast<int64>(neg ? 0 - m : m);
+    }
 
-        if (end == v + len) return x;
+    for (size_t i = n; i < len && x != 0; ++i) {
+        const int off = kIntUnit.get(s[i]);
+        if (x < (MIN_INT64 >> off) || x > (MAX_INT64 >> off)) {
+            return PARSE_OUT_OF_RANGE;
+        }
+        x = static_cast<int64>(static_cast<uint64>(x) << off);
+    }
 
-        err = std::string("invalid value for integer") + ": " + v;
-        return 0;
+    *r = x;
+    return PARSE_OK;
+}
 
-    } else {
-        int64 x = to_int64(v, len - 1, err);
-        if (x == 0) return 0;
+// a leading '-' negates in uint64 as strtoull() does, units then apply to
+// the value as int64.
+ParseError parse_uint64(const char* s, size_t len, uint64* r) {
+    const size_t n = strip_units(s, len);
+    uint64 x = 0;
 
-        int off = kIntUnit.get(v[len - 1]);
-        if (x < (MIN_INT64 >> off) || x > (MAX_INT64 >> off)) goto range_err;
-        return x << off;
+    if (n > 0) {
+        uint64 m = 0;
+        bool neg, over;
+        const char* end = scan_int(s, s + n, &m, &neg, &over);
+
+        if (over) return PARSE_OUT_OF_RANGE;
+        if (end != s + n) return PARSE_INVALID;
+
+        x = neg ? 0 - m : m;
+    }
+
+    for (size_t i = n; i < len && x != 0; ++i) {
+        const int off = kIntUnit.get(s[i]);
+        const uint64 a = static_cast<int64>(x) < 0 ? 0 - x : x;
+        if (a > (MAX_UINT64 >> off)) return PARSE_OUT_OF_RANGE;
+        x <<= off;
     }
 
-    range_err:
-    err = std::string("out of range for int64") + ": " + v;
-    return 0;
+    *r = x;
+    return PARSE_OK;
 }
 
-uint64 to_uint64(const char* v, uint32 len, std::string& err) {
-    if (len == 0) return 0;
+const double kPow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/*
+ * Clinger's fast path: a significand below 2^53 times or divided by an exact
+ * power of ten is correctly rounded, the same as strtod().  return false for
+ * anything else: more digits, big exponents, hex, inf, nan, spaces...
+ */
+bool fast_double(const char* s, size_t len, double* r) {
+    const char* p = s;
+    const char* e = s + len;
+
+    bool neg = false;
+    if (p < e && (*p == '-' || *p == '+')) neg = (*p++ == '-');
+
+    uint64 m = 0;
+    const char* q = p;
+    p = scan_digits(p, e, 19, &m);
+    if (p < e && is_digit(*p)) return false;
+    size_t n = p - q;
+
+    int exp = 0;
+    if (p < e && *p == '.') {
+        q = ++p;
+        p = scan_digits(p, e, 19 - n, &m);
+        if (p < e && is_digit(*p)) return false;
+        exp = -static_cast<int>(p - q);
+        n += p - q;
+    }
+    if (n == 0) return false;
 
-    if (!kIntUnit.check(v[len - 1])) {
-        char* end = NULL;
-        int64 x = ::strtoull(v, &end, 0);
+    if (p < e && (*p | 0x20) == 'e') {
+        ++p;
+        bool eneg = false;
+        if (p < e && (*p == '-' || *p == '+')) eneg = (*p++ == '-');
+        if (p == e || !is_digit(*p)) return false;
 
-        if (errno == ERANGE && (uint64) x == MAX_UINT64) {
-            errno = 0;
-            goto range_err;
+        int x = 0;
+        for (; p < e && is_digit(*p); ++p) {
+            if (x < 10000) x = x * 10 + (*p - '0');
         }
+        exp += eneg ? -x : x;
+    }
 
-        if (end == v + len) return x;
+    if (p != e || m > (1ULL << 53) || exp < -22 || exp > 22) return false;
 
-        err = std::string("invalid value for integer") + ": " + v;
-        return 0;
+    double d = static_cast<double>(m);
+    d = exp < 0 ? d / kPow10[-exp] : d * kPow10[exp];
+    *r = neg ? -d : d;
+    return true;
+}
 
-    } else {
-        int64 x = to_uint64(v, len - 1, err);
-        if (x == 0) return 0;
+bool set_err(ParseError e, const char* type, const char* v,
+             std::string& err) {
+    err = (e == PARSE_INVALID) ? std::string("invalid value for integer")
+                               : std::string("out of range for ") + type;
+    err += ": ";
+    err += v;
+    return false;
+}
+} // namespace
 
-        int off = kIntUnit.get(v[len - 1]);
-        if (abs(x) > (MAX_UINT64 >> off)) goto range_err;
-        return x << off;
-    }
+ParseError to_int64(const char* s, size_t len, int64* r) {
+    return parse_int64(s, len, r);
+}
 
-    range_err:
-    err = std::string("out of range for uint64") + ": " + v;
-    return 0;
+ParseError to_uint64(const char* s, size_t len, uint64* r) {
+    return parse_uint64(s, len, r);
 }
 
-bool to_int64(const std::string& v, int64* r, std::string& err) {
-    int64 x = to_int64(v.data(), v.size(), err);
-    if (!err.empty()) return false;
+ParseError to_int32(const char* s, size_t len, int32* r) {
+    int64 x;
+    ParseError e = parse_int64(s, len, &x);
+    if (e != PARSE_OK) return e;
+    if (x > MAX_INT32 || x < MIN_INT32) return PARSE_OUT_OF_RANGE;
 
-    *r = x;
-    return true;
+    *r = static_cast<int32>(x);
+    return PARSE_OK;
 }
 
-bool to_uint64(const std::string& v, uint64* r, std::string& err) {
-    uint64 x = to_uint64(v.data(), v.size(), err);
-    if (!err.empty()) return false;
+// negative values wrap around, "-1" is 0xffffffff.
+ParseError to_uint32(const char* s, size_t len, uint32* r) {
+    uint64 x;
+    ParseError e = parse_uint64(s, len, &x);
+    if (e != PARSE_OK) return e;
 
-    *r = x;
-    return true;
+    const uint64 a = static_cast<int64>(x) < 0 ? 0 - x : x;
+    if (a > MAX_UINT32) return PARSE_OUT_OF_RANGE;
+
+    *r = static_cast<uint32>(x);
+    return PARSE_OK;
 }
 
-bool to_int32(const std::string& v, int32* r, std::string& err) {
-    int64 x = to_int64(v.data(), v.size(), err);
-    if (!err.empty()) {
-        if (err[0] == 'o') goto err; // out of range
-        return false;
+ParseError to_double(const char* s, size_t len, double* r) {
+    if (fast_double(s, len, r)) return PARSE_OK;
+
+    // strtod() needs a null-terminated string
+    char buf[64];
+    std::string tmp;
+    const char* v = buf;
+    if (len < sizeof(buf)) {
+        ::memcpy(buf, s, len);
+        buf[len] = '\0';
+    } else {
+        tmp.assign(s, len);
+        v = tmp.c_str();
     }
 
-    if (x > MAX_INT32 || x < MIN_INT32) goto err;
+    char* end = NULL;
+    errno = 0;
+    double x = ::strtod(v, &end);
 
-    *r = static_cast<int32>(x);
-    return true;
+    if (errno == ERANGE && (x == HUGE_VAL || x == -HUGE_VAL)) {
+        errno = 0;
+        return PARSE_OUT_OF_RANGE;
+    }
 
-    err:
-    err = std::string("out of range for int32") + ": " + v;
-    return false;
+    if (end != v + len) return PARSE_INVALID;
+
+    *r = x;
+    return PARSE_OK;
 }
 
-bool to_uint32(const std::string& v, uint32* r, std::string& err) {
-    int64 x = to_uint64(v.data(), v.size(), err);
-    if (!err.empty()) {
-        if (err[0] == 'o') goto err; // out of range
-        return false;
+ParseError to_bool(const char* s, size_t len, bool* r) {
+    if ((len == 4 && ::memcmp(s, "true", 4) == 0) ||
+        (len == 1 && *s == '1')) {
+        *r = true;
+        return PARSE_OK;
     }
 
-    if (abs(x) > MAX_UINT32) goto err;
+    if ((len == 5 && ::memcmp(s, "false", 5) == 0) ||
+        (len == 1 && *s == '0')) {
+        *r = false;
+        return PARSE_OK;
+    }
 
-    *r = static_cast<uint32>(x);
-    return true;
+    return PARSE_INVALID;
+}
+
+bool to_bool(const std::string& v, bool* r, std::string& err) {
+    if (to_bool(v.data(), v.size(), r) == PARSE_OK) return true;
+
+    err = std::string("invalid value for bool") + ": " + v;
+    return false;
+}
 
-    err:
-    err = std::string("out of range for int32") + ": " + v;
+bool to_double(const std::string& v, double* r, std::string& err) {
+    ParseError e = to_double(v.data(), v.size(), r);
+    if (e == PARSE_OK) return true;
+
+    err = std::string(e == PARSE_INVALID ? "invalid value for double"
+                                         : "out of range for double");
+    err += ": " + v;
     return false;
 }
 
+bool to_int64(const std::string& v, int64* r, std::string& err) {
+    ParseError e = parse_int64(v.data(), v.size(), r);
+    return e == PARSE_OK || set_err(e, "int64", v.c_str(), err);
+}
+
+bool to_uint64(const std::string& v, uint64* r, std::string& err) {
+    ParseError e = parse_uint64(v.data(), v.size(), r);
+    return e == PARSE_OK || set_err(e, "uint64", v.c_str(), err);
+}
+
+bool to_int32(const std::string& v, int32* r, std::string& err) {
+    ParseError e = to_int32(v.data(), v.size(), r);
+    return e == PARSE_OK || set_err(e, "int32", v.c_str(), err);
+}
+
+bool to_uint32(const std::string& v, uint32* r, std::string& err) {
+    ParseError e = to_uint32(v.data(), v.size(), r);
+    return e == PARSE_OK || set_err(e, "int32", v.c_str(), err);
+}
+
 #define DEF_fun(type) \
     type to_##type(const std::string& v) { \
         type x; \
@@ -3,6 +3,9 @@
 #include "data_types.h"
 #include "stream_buf.h"
 
+#include <string.h>
+
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <set>
@@ -10,11 +13,267 @@
 
 namespace util {
 
+/*
+ * a read-only view of @size bytes at @data, not null-terminated.  the
+ * memory must outlive the view.
+ */
+class StringView {
+  public:
+    StringView()
+        : _data(""), _size(0) {
+    }
+    StringView(const char* data, size_t size)
+        : _data(data), _size(size) {
+    }
+    StringView(const char* s)
+        : _data(s), _size(::strlen(s)) {
+    }
+    StringView(const std::string& s)
+        : _data(s.data()), _size(s.size()) {
+    }
+
+    const char* data() const {
+        return _data;
+    }
+    size_t size() const {
+        return _size;
+    }
+    bool empty() const {
+        return _size == 0;
+    }
+
+    char operator[](size_t i) const {
+        return _data[i];
+    }
+    const char* begin() const {
+        return _data;
+    }
+    const char* end() const {
+        return _data + _size;
+    }
+
+    StringView substr(size_t pos, size_t n = std::string::npos) const {
+        if (pos > _size) pos = _size;
+        return StringView(_data + pos, std::min(n, _size - pos));
+    }
+
+    std::string to_string() const {
+        return std::string(_data, _size);
+    }
+
+  private:
+    const char* _data;
+    size_t _size;
+};
+
+inline bool operator==(const StringView& a, const StringView& b) {
+    return a.size() == b.size() && ::memcmp(a.data(), b.data(), a.size()) == 0;
+}
+inline bool operator!=(const StringView& a, const StringView& b) {
+    return !(a == b);
+}
+
+inline StreamBuf& operator<<(StreamBuf& sb, const StringView& v) {
+    return sb.append(v.data(), v.size());
+}
+
+/*
+ * the first @c or @separ in [s, s + n), NULL if not found.  single chars
+ * are found by memchr, strings by comparing their first and last chars
+ * 16 positions at a time.
+ */
+inline const char* find_separ(const char* s, size_t n, char c) {
+    return static_cast<const char*>(::memchr(s, c, n));
+}
+const char* find_separ(const char* s, size_t n, const char* separ,
+                       size_t separ_size);
+
+/*
+ * lazy split_string(), fields are views of @s.
+ *
+ *   Tokenizer t(line, ' ');
+ *   for (StringView field : t) { ... }
+ *
+ *   StringView field;
+ *   while (t.next(&field)) { ... }
+ */
+class Tokenizer {
+  public:
+    Tokenizer(const StringView& s, char c)
+        : _pos(s.begin()), _end(s.end()), _separ(&_c, 1), _c(c) {
+        this->skipLeading();
+    }
+    // @separ must outlive the tokenizer.
+    Tokenizer(const StringView& s, const StringView& separ)
+        : _pos(s.begin()), _end(s.end()), _separ(separ),
+          _c(separ.empty() ? '\0' : separ[0]) {
+        this->skipLeading();
+    }
+    Tokenizer(const Tokenizer& t)
+        : _pos(t._pos), _end(t._end), _separ(t._separ), _c(t._c) {
+        if (t._separ.data() == &t._c) _separ = StringView(&_c, 1);
+    }
+
+    // return false if there is no more field.
+    bool next(StringView* field);
+
+    class iterator {
+      public:
+        iterator()
+            : _t(NULL) {
+        }
+        explicit iterator(Tokenizer* t)
+            : _t(t) {
+            ++*this;
+        }
+
+        const StringView& operator*() const {
+            return _field;
+        }
+        const StringView* operator->() const {
+            return &_field;
+        }
+        iterator& operator++() {
+            if (_t != NULL && !_t->next(&_field)) _t = NULL;
+            return *this;
+        }
+
+        bool operator==(const iterator& it) const {
+            return _t == it._t;
+        }
+        bool operator!=(const iterator& it) const {
+            return _t != it._t;
+        }
+
+      private:
+        Tokenizer* _t;
+        StringView _field;
+    };
+
+    iterator begin() {
+        return iterator(this);
+    }
+    iterator end() {
+        return iterator();
+    }
+
+  private:
+    const char* _pos;
+    const char* _end;
+    StringView _separ;
+    char _c;
+
+    // split_string() skips one separator at the beginning.
+    void skipLeading() {
+        size_t n = _separ.size();
+        if (n != 0 && static_cast<size_t>(_end - _pos) >= n &&
+            ::memcmp(_pos, _separ.data(), n) == 0) {
+            _pos += n;
+        }
+    }
+
+    DISALLOW_ASSIGN(Tokenizer);
+};
+
+/*
+ * the same fields as split_string(), as views of @s appended to @v, which
+ * is cleared first.  nothing is allocated if @v has room.
+ *
+ *   SmallVector<StringView, 8> v;
+ *   split_view("x||x", '|', &v);  ==>  { "x", "", "x" }
+ */
+template <typename V>
+void split_view(const StringView& s, char c, V* v) {
+    v->clear();
+    Tokenizer t(s, c);
+    StringView field;
+    while (t.next(&field)) v->push_back(field);
+}
+
+template <typename V>
+void split_view(const StringView& s, const StringView& separ, V* v) {
+    v->clear();
+    Tokenizer t(s, separ);
+    StringView field;
+    while (t.next(&field)) v->push_back(field);
+}
+
 /*
  * '*' for any string, '?' for single letter
  */
 bool pattern_match(const std::string& pattern, const std::string& expression);
 
+/*
+ * a pattern of pattern_match() compiled once, to match many expressions.
+ * the literal text before the first '*' and after the last one is checked
+ * first, then the parts between stars from left to right.
+ *
+ *   GlobPattern p("api_*.json");
+ *   p.match("api_users.json");  // true
+ */
+class GlobPattern {
+  public:
+    explicit GlobPattern(const std::string& pattern);
+
+    bool match(const StringView& s) const;
+
+  private:
+    // literal text, '?' for any letter if @any is set.
+    struct Part {
+        std::string s;
+        bool any;
+    };
+
+    bool _star;
+    Part _prefix;
+    Part _suffix;
+    std::vector<Part> _middle;
+    size_t _min_len;
+
+    DISALLOW_COPY_AND_ASSIGN(GlobPattern);
+};
+
+/*
+ * patterns of pattern_match() merged into one bit-parallel automaton, a
+ * state for each letter and a loop for each '*'.  an expression is matched
+ * against all of them in a single pass.
+ *
+ *   immutable once built, it can be shared between threads.
+ *
+ *   GlobSet set({ "api_*", "*.png", "favicon.ico" });
+ *   std::vector<uint32> v;
+ *   set.match("api_logo.png", &v);  ==>  { 0, 1 }
+ */
+class GlobSet {
+  public:
+    explicit GlobSet(const std::vector<std::string>& patterns);
+
+    // indexes of patterns matching @s, in ascending order, @v is cleared
+    // first.  return false if none matches.
+    bool match(const StringView& s, std::vector<uint32>* v) const;
+
+    size_t size() const {
+        return _size;
+    }
+
+  private:
+    // bytes in no pattern are class 0.
+    uint16 _class[256];
+    uint32 _ncls;
+    size_t _words;
+    size_t _size;
+
+    // class * _words + w: states entered on a letter of the class.
+    std::vector<uint64> _enter;
+    std::vector<uint64> _init;
+    std::vector<uint64> _loop;
+    std::vector<uint64> _final;
+    // state -> pattern index.
+    std::vector<uint32> _pattern;
+
+    DISALLOW_COPY_AND_ASSIGN(GlobSet);
+};
+
 /*
  * split string @s by character @c
  *
@@ -173,4 +432,27 @@ bool to_uint64(const std::string& v, uint64* r, std::string& err);
 bool to_bool(const std::string& v, bool* r, std::string& err);
 
 bool to_double(const std::string& v, double* r, std::string& err);
+
+enum ParseError {
+    PARSE_OK = 0,
+    PARSE_INVALID,
+    PARSE_OUT_OF_RANGE,
+};
+
+/*
+ * the same as above for [@s, @s + @len), which needn't be null-terminated.
+ * nothing is allocated, @r is set only on PARSE_OK.
+ *
+ *   to_int64("32k", 3, &x);    // x = 32768
+ *   to_int32("0x1f", 4, &y);   // y = 31
+ */
+ParseError to_int32(const char* s, size_t len, int32* r);
+ParseError to_int64(const char* s, size_t len, int64* r);
+
+ParseError to_uint32(const char* s, size_t len, uint32* r);
+ParseError to_uint64(const char* s, size_t len, uint64* r);
+
+ParseError to_bool(const char* s, size_t len, bool* r);
+
+ParseError to_double(const char* s, size_t len, double* r);
 } // namespace ut
@@ -25,3 +25,82 @@ bool SyncEvent::timed_wait(uint32 ms) {
     if (!_manual_reset) _signaled = false;
     return true;
 }
+
+// return false if timeout
+bool CondVar::timed_wait(uint32 ms) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += ms % 1000 * 1000000;
+
+    if (ts.tv_nsec > 999999999) {
+        ts.tv_nsec -= 1000000000;
+        ++ts.tv_sec;
+    }
+
+    int ret = pthread_cond_timedwait(&_cond, _mutex.mutex(), &ts);
+    if (ret == ETIMEDOUT) return false;
+
+    CHECK_EQ(ret, 0);
+    return true;
+}
+
+ThreadPool::ThreadPool(uint32 thread_num)
+    : _task_cond(_mutex), _idle_cond(_mutex), _busy(0), _stop(false) {
+    if (thread_num == 0) thread_num = 1;
+
+    for (uint32 i = 0; i < thread_num; ++i) {
+        _threads.emplace_back(
+            new Thread(std::bind(&ThreadPool::thread_fun, this)));
+        CHECK(_threads.back()->start());
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        MutexGuard g(_mutex);
+        _stop = true;
+        _task_cond.broadcast();
+    }
+
+    for (uint32 i = 0; i < _threads.size(); ++i) {
+        _threads[i]->join();
+    }
+}
+
+void ThreadPool::run(std::function<void()> task) {
+    MutexGuard g(_mutex);
+    _tasks.push_back(task);
+    _task_cond.signal();
+}
+
+void ThreadPool::wait() {
+    MutexGuard g(_mutex);
+    while (!_tasks.empty() || _busy != 0) {
+        _idle_cond.wait();
+    }
+}
+
+void ThreadPool::thread_fun() {
+    while (true) {
+        std::function<void()> task;
+        {
+            MutexGuard g(_mutex);
+            while (_tasks.empty() && !_stop) {
+                _task_cond.wait();
+            }
+
+            if (_tasks.empty()) return;  // stopped
+
+            task.swap(_tasks.front());
+            _tasks.pop_front();
+            ++_busy;
+        }
+
+        task();
+
+        MutexGuard g(_mutex);
+        if (--_busy == 0 && _tasks.empty()) _idle_cond.broadcast();
+    }
+}
@@ -9,6 +9,9 @@
 #include <string.h>
 #include <pthread.h>
 #include <functional>
+#include <deque>
+#include <memory>
+#include <vector>
 
 class Mutex {
   public:
@@ -178,6 +181,47 @@ class SpinLockGuard {
     DISALLOW_COPY_AND_ASSIGN(SpinLockGuard);
 };
 
+/*
+ * condition variable bound to a Mutex, the mutex must be locked by the
+ * caller of wait() and timed_wait().
+ */
+class CondVar {
+  public:
+    explicit CondVar(Mutex& mutex)
+        : _mutex(mutex) {
+        pthread_condattr_t attr;
+        CHECK(pthread_condattr_init(&attr) == 0);
+        CHECK(pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) == 0);
+        CHECK(pthread_cond_init(&_cond, &attr) == 0);
+        CHECK(pthread_condattr_destroy(&attr) == 0);
+    }
+
+    ~CondVar() {
+        CHECK(pthread_cond_destroy(&_cond) == 0);
+    }
+
+    void wait() {
+        pthread_cond_wait(&_cond, _mutex.mutex());
+    }
+
+    // return false if timeout
+    bool timed_wait(uint32 ms);
+
+    void signal() {
+        pthread_cond_signal(&_cond);
+    }
+
+    void broadcast() {
+        pthread_cond_broadcast(&_cond);
+    }
+
+  private:
+    pthread_cond_t _cond;
+    Mutex& _mutex;
+
+    DISALLOW_COPY_AND_ASSIGN(CondVar);
+};
+
 // for single producer-consumer
 class SyncEvent {
   public:
@@ -318,6 +362,43 @@ class StoppableThread : public Thread {
     }
 };
 
+/*
+ * fixed number of threads running tasks in FIFO order.
+ *
+ *   tasks may be added from inside a running task, wait() returns when
+ *   the queue is empty and no task is running.
+ */
+class ThreadPool {
+  public:
+    explicit ThreadPool(uint32 thread_num);
+
+    // run remaining tasks and join all threads
+    ~ThreadPool();
+
+    void run(std::function<void()> task);
+
+    void wait();
+
+    uint32 size() const {
+        return static_cast<uint32>(_threads.size());
+    }
+
+  private:
+    Mutex _mutex;
+    CondVar _task_cond;
+    CondVar _idle_cond;
+
+    std::deque<std::function<void()>> _tasks;
+    uint32 _busy;
+    bool _stop;
+
+    std::vector<std::unique_ptr<Thread>> _threads;
+
+    void thread_fun();
+
+    DISALLOW_COPY_AND_ASSIGN(ThreadPool);
+};
+
 template<typename ObjectType>
 class ThreadStorage {
   public:
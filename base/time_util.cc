@@ -1,5 +1,13 @@
 #include "time_util.h"
+#include "file_util.h"
+#include "thread_util.h"
 #include <errno.h>
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define TIME_HAVE_TSC
+#include <cpuid.h>
+#endif
 
 namespace sys {
 namespace xx {
@@ -13,8 +21,205 @@ std::string local_time::to_string(int64 sec, const char* format) {
 
     return s;
 }
+
+#ifdef TIME_HAVE_TSC
+namespace {
+// ns = ns0 + (tsc - tsc0) * mult >> 32
+struct TscRate {
+    bool ok;
+    uint64 tsc0;
+    int64 ns0;
+    uint64 mult;
+};
+
+// the tsc of all cores runs at a constant rate, even in deep c-states.
+bool cpuHasInvariantTsc() {
+    uint32 eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0x80000000, NULL) < 0x80000007) return false;
+    __cpuid(0x80000007, eax, ebx, ecx, edx);
+    return (edx & (1 << 8)) != 0;
+}
+
+// 2ms of spinning, the rate is within tens of ppm.
+TscRate calibrateTsc() {
+    TscRate r = { false, 0, 0, 0 };
+    if (!cpuHasInvariantTsc()) return r;
+
+    int64 ns0 = mono_clock::ns();
+    uint64 tsc0 = __builtin_ia32_rdtsc();
+    int64 ns1;
+    uint64 tsc1;
+    do {
+        ns1 = mono_clock::ns();
+        tsc1 = __builtin_ia32_rdtsc();
+    } while (ns1 - ns0 < 2000000);
+
+    r.ok = tsc1 > tsc0;
+    r.tsc0 = tsc0;
+    r.ns0 = ns0;
+    if (r.ok) r.mult = (static_cast<uint64>(ns1 - ns0) << 32) / (tsc1 - tsc0);
+    return r;
+}
+} // namespace
+
+int64 mono_clock::tsc_ns() {
+    static const TscRate r = calibrateTsc();
+    if (!r.ok) return mono_clock::ns();
+
+    uint64 d = __builtin_ia32_rdtsc() - r.tsc0;
+    return r.ns0 + static_cast<int64>(
+        (static_cast<unsigned __int128>(d) * r.mult) >> 32);
+}
+#else
+int64 mono_clock::tsc_ns() {
+    return mono_clock::ns();
+}
+#endif
+
+namespace {
+// utc and local_time in ms, written only by the updating thread.
+volatile int64 kNowMs = 0;
+volatile int64 kLocalNowMs = 0;
+volatile bool kNowStarted = false;
+Mutex kNowMutex;
+
+void updateNow() {
+    struct timeval now;
+    struct timezone tz;
+    ::gettimeofday(&now, &tz);
+
+    int64 ms = static_cast<int64>(now.tv_sec) * 1000 + now.tv_usec / 1000;
+    kLocalNowMs = ms - tz.tz_minuteswest * 60 * 1000;
+    kNowMs = ms;
+}
+
+// the thread doesn't exist in a forked child.
+void onFork() {
+    kNowStarted = false;
+}
+
+void startNow() {
+    MutexGuard g(kNowMutex);
+    if (kNowStarted) return;
+
+    static bool once = (::pthread_atfork(NULL, NULL, &onFork), true);
+    (void) once;
+
+    updateNow();
+    auto t = new StoppableThread(&updateNow, 1);  // never stops
+    t->start();
+    (void) atomic_swap(&kNowStarted, true);
+}
+} // namespace
+
+int64 cached_now::ms() {
+    if (!kNowStarted) startNow();
+    return kNowMs;
+}
+
+int64 cached_now::local_ms() {
+    if (!kNowStarted) startNow();
+    return kLocalNowMs;
+}
 } // namespace xx
 
+void auto_timer::timedout(int64 ms) {
+    if (_file == NULL) {
+        TLOG(_tag) << _msg << " timedout: " << ms;
+        return;
+    }
+
+    const char* msg = _cmsg != NULL ? _cmsg : _msg.c_str();
+    TLOG(_tag) << sys::split_path(_file).second << ":" << _line << " "
+               << _func << "] " << msg << " timedout: " << ms;
+}
+
+namespace {
+// conversions of strftime() that don't change within a day.
+inline bool same_in_day(char c) {
+    return c != '\0' && ::strchr("aAbBCdDeFgGhjmnuUVwWxyYzZt%", c) != NULL;
+}
+
+inline int64 day_of(int64 sec) {
+    return sec >= 0 ? sec / 86400 : (sec + 1) / 86400 - 1;
+}
+
+inline void put2(char* p, int64 v) {
+    p[0] = static_cast<char>('0' + v / 10);
+    p[1] = static_cast<char>('0' + v % 10);
+}
+} // namespace
+
+time_formatter::time_formatter(const char* format)
+    : _format(format), _patch(true), _sec(MIN_INT64), _len(0),
+      _h(-1), _m(-1), _s(-1) {
+    int h = 0, m = 0, s = 0;
+    for (const char* p = format; *p != '\0'; ++p) {
+        if (*p != '%') continue;
+
+        char c = *++p;
+        if (c == 'H') {
+            ++h;
+        } else if (c == 'M') {
+            ++m;
+        } else if (c == 'S') {
+            ++s;
+        } else if (!same_in_day(c)) {
+            _patch = false;
+            break;
+        }
+    }
+
+    if (h > 1 || m > 1 || s > 1) _patch = false;
+}
+
+void time_formatter::render(int64 sec) {
+    time_t t = static_cast<time_t>(sec);
+    struct tm tm;
+    ::gmtime_r(&t, &tm);
+
+    _len = ::strftime(_buf, sizeof(_buf), _format.c_str(), &tm);
+    _h = _m = _s = -1;
+    if (!_patch || _len == 0) return;
+
+    // the offset of a field is the length of the format before it.
+    char tmp[sizeof(_buf)];
+    std::string prefix;
+    for (size_t i = 0; i + 1 < _format.size(); ++i) {
+        if (_format[i] != '%') continue;
+
+        char c = _format[++i];
+        if (c != 'H' && c != 'M' && c != 'S') continue;
+
+        prefix.assign(_format, 0, i - 1);
+        int off = static_cast<int>(
+            ::strftime(tmp, sizeof(tmp), prefix.c_str(), &tm));
+        if (c == 'H') _h = off;
+        if (c == 'M') _m = off;
+        if (c == 'S') _s = off;
+    }
+}
+
+size_t time_formatter::format(int64 sec, char* buf, size_t n) {
+    if (sec != _sec) {
+        int64 day = day_of(sec);
+        if (_patch && _sec != MIN_INT64 && day == day_of(_sec)) {
+            int64 t = sec - day * 86400;
+            if (_h >= 0) put2(_buf + _h, t / 3600);
+            if (_m >= 0) put2(_buf + _m, t / 60 % 60);
+            if (_s >= 0) put2(_buf + _s, t % 60);
+        } else {
+            this->render(sec);
+        }
+        _sec = sec;
+    }
+
+    if (_len == 0 || n <= _len) return 0;
+    ::memcpy(buf, _buf, _len);
+    buf[_len] = '\0';
+    return _len;
+}
+
 void msleep(uint32 ms) {
     struct timespec ts;
     ts.tv_sec = ms / 1000;
@@ -7,6 +7,13 @@
 #include <string>
 
 namespace sys {
+// clocks of mono_clock, see below.
+enum MonoMode {
+    MONO_PRECISE = 0,
+    MONO_COARSE,
+    MONO_TSC,
+};
+
 namespace xx {
 /*
  * univeral time(UTC)
@@ -90,10 +97,59 @@ struct local_time {
       return local_time::to_string(local_time::sec(), format);
     }
 };
+
+/*
+ * monotonic clocks, for intervals only
+ *
+ *          ns():  CLOCK_MONOTONIC, about 20ns through the vdso.
+ *   coarse_ns():  CLOCK_MONOTONIC_COARSE, a few ns, but it ticks every 1~4ms.
+ *      tsc_ns():  rdtsc at the rate calibrated against CLOCK_MONOTONIC on
+ *                 the first call, under 10ns.  ns() without an invariant tsc.
+ */
+struct mono_clock {
+    static inline int64 ns() {
+      struct timespec ts;
+      ::clock_gettime(CLOCK_MONOTONIC, &ts);
+      return static_cast<int64>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    static inline int64 coarse_ns() {
+      struct timespec ts;
+      ::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+      return static_cast<int64>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    static int64 tsc_ns();
+
+    static inline int64 ns(MonoMode mode) {
+      if (mode == MONO_TSC) return mono_clock::tsc_ns();
+      return mode == MONO_COARSE ? mono_clock::coarse_ns() : mono_clock::ns();
+    }
+};
+
+/*
+ * the wall clock of utc and local_time, refreshed every millisecond by a
+ * background thread, reading it is a load.  the thread starts on the first
+ * call, and again in a forked child.
+ */
+struct cached_now {
+    static int64 ms();
+    static int64 local_ms();
+
+    static inline int64 sec() {
+      return cached_now::ms() / 1000;
+    }
+
+    static inline int64 local_sec() {
+      return cached_now::local_ms() / 1000;
+    }
+};
 }  // namespace xx
 
 extern xx::utc utc;
 extern xx::local_time local_time;
+extern xx::mono_clock mono_clock;
+extern xx::cached_now cached_now;
 
 /*
  * sleep for @ms milliseconds
@@ -112,31 +168,38 @@ inline void sleep(uint32 sec) {
   sys::msleep(sec * 1000);
 }
 
+// MONO_TSC by default, MONO_COARSE is enough for milliseconds.
 class timer {
   public:
-    timer() {
-      _start = sys::utc.us();
+    explicit timer(MonoMode mode = MONO_TSC)
+        : _mode(mode) {
+      _start = sys::mono_clock.ns(_mode);
     }
     ~timer() = default;
 
     void restart() {
-      _start = sys::utc.us();
+      _start = sys::mono_clock.ns(_mode);
+    }
+
+    int64 ns() const {
+      return sys::mono_clock.ns(_mode) - _start;
     }
 
     int64 us() const {
-      return sys::utc.us() - _start;
+      return this->ns() / 1000;
     }
 
     int64 ms() const {
-      return this->us() / 1000;
+      return this->ns() / 1000000;
     }
 
     int64 sec() const {
-      return this->us() / 1000000;
+      return this->ns() / 1000000000;
     }
 
   private:
     int64 _start;
+    MonoMode _mode;
 
     DISALLOW_COPY_AND_ASSIGN(timer);
 };
@@ -145,27 +208,87 @@ class auto_timer {
   public:
     auto_timer(const std::string& msg = std::string(), uint32 ms = 50,
                const char* tag = "timeout")
-        : _msg(msg), _tag(tag), _ms(ms) {
+        : _timer(MONO_COARSE), _msg(msg), _cmsg(NULL), _tag(tag), _ms(ms),
+          _file(NULL), _line(0), _func(NULL) {
+    }
+
+    // the place is formatted as FILE_LINE_FUNC only if it timed out.  @msg
+    // is kept as a pointer, a literal for example, it must outlive the timer.
+    auto_timer(const char* file, int line, const char* func,
+               const char* msg, uint32 ms, const char* tag)
+        : _timer(MONO_COARSE), _cmsg(msg), _tag(tag), _ms(ms),
+          _file(file), _line(line), _func(func) {
+    }
+    auto_timer(const char* file, int line, const char* func,
+               const std::string& msg, uint32 ms, const char* tag)
+        : _timer(MONO_COARSE), _msg(msg), _cmsg(NULL), _tag(tag), _ms(ms),
+          _file(file), _line(line), _func(func) {
     }
 
     ~auto_timer() {
       auto ms = _timer.ms();
-      TLOG_IF(_tag, ms > _ms) << _msg << " timedout: " << ms;
+      if (ms > _ms) this->timedout(ms);
     }
 
   private:
     sys::timer _timer;
     std::string _msg;
+    const char* _cmsg;  // used instead of _msg if not NULL
     const char* _tag;
     uint32 _ms;
+
+    const char* _file;
+    int _line;
+    const char* _func;
+
+    void timedout(int64 ms);
 };
 
 #define FILE_LINE_FUNC \
     sys::split_path(__FILE__).second + ":" + util::to_string(__LINE__) + \
         " " + __FUNCTION__
 
+// a literal @_msg_ isn't copied, nothing is allocated unless it times out.
 #define AUTO_TIMER(_msg_, _ms_, _tag_) \
-    sys::auto_timer timer_______(FILE_LINE_FUNC + "] " + _msg_, _ms_, _tag_)
+    sys::auto_timer timer_______(__FILE__, __LINE__, __FUNCTION__, \
+                                 _msg_, _ms_, _tag_)
+
+/*
+ * local_time::to_string() for a fixed @format, into caller buffers.  the
+ * whole string is rendered once a day, only the digits of %H %M %S are
+ * patched for other seconds, and the same second is a copy.  formats with
+ * other conversions that change within a day (%p %s %T ...) are rendered
+ * every second.
+ *
+ *   not thread-safe, use one for each thread, e.g. by ThreadStorage.
+ */
+class time_formatter {
+  public:
+    explicit time_formatter(const char* format = "%Y-%m-%d %H:%M:%S");
+    ~time_formatter() = default;
+
+    // return the length, @buf is null-terminated.  return 0 if @n isn't
+    // larger than the length, or the result is longer than 63 bytes.
+    size_t format(int64 sec, char* buf, size_t n);
+
+    std::string to_string(int64 sec) {
+      char buf[64];
+      return std::string(buf, this->format(sec, buf, sizeof(buf)));
+    }
+
+  private:
+    std::string _format;
+    bool _patch;  // %H %M %S are all that change within a day
+
+    int64 _sec;   // of _buf, MIN_INT64 for none
+    size_t _len;
+    char _buf[64];
+    int _h, _m, _s;  // offsets of the digits in _buf, -1 for none
+
+    void render(int64 sec);
+
+    DISALLOW_COPY_AND_ASSIGN(time_formatter);
+};
 
 }  // namespace sys
 
@@ -0,0 +1,230 @@
+#include "consistent_hash.h"
+
+#include <cmath>
+
+namespace util {
+namespace {
+
+// the same ring as libketama and twemproxy with equal weights: 40 md5
+// digests of "name-i" for each unit of weight, 4 points from a digest.
+class KetamaHash : public ConsistentHash {
+  public:
+    KetamaHash() = default;
+    virtual ~KetamaHash() = default;
+
+    virtual void add(const std::string& name, uint32 weight);
+    virtual void remove(const std::string& name);
+    virtual const std::string* find(const char* key, uint32 len) const;
+
+    virtual uint32 size() const {
+        return _ids.size();
+    }
+
+  private:
+    // (point, node id), sorted.
+    std::vector<std::pair<uint32, uint32>> _ring;
+    // node id -> name, empty for free ids.
+    std::vector<std::string> _names;
+    std::unordered_map<std::string, uint32> _ids;
+
+    static uint32 point(const unsigned char* digest, int i) {
+        return (static_cast<uint32>(digest[3 + i * 4]) << 24)
+            | (static_cast<uint32>(digest[2 + i * 4]) << 16)
+            | (static_cast<uint32>(digest[1 + i * 4]) << 8)
+            | digest[i * 4];
+    }
+
+    static void md5(const char* data, uint32 len, unsigned char* digest) {
+        MD5_CTX ctx;
+        MD5_Init(&ctx);
+        MD5_Update(&ctx, data, len);
+        MD5_Final(digest, &ctx);
+    }
+};
+
+void KetamaHash::add(const std::string& name, uint32 weight) {
+    if (_ids.find(name) != _ids.end()) this->remove(name);
+
+    uint32 id = 0;
+    while (id < _names.size() && !_names[id].empty()) ++id;
+    if (id == _names.size()) _names.push_back(std::string());
+    _names[id] = name;
+    _ids[name] = id;
+
+    // merge points of the node into the ring, others don't change.
+    size_t mid = _ring.size();
+    unsigned char digest[16];
+    for (uint32 i = 0; i < 40 * weight; ++i) {
+        std::string s = name + "-" + util::to_string(i);
+        md5(s.data(), s.size(), digest);
+        for (int k = 0; k < 4; ++k) {
+            _ring.push_back(std::make_pair(point(digest, k), id));
+        }
+    }
+    std::sort(_ring.begin() + mid, _ring.end());
+    std::inplace_merge(_ring.begin(), _ring.begin() + mid, _ring.end());
+}
+
+void KetamaHash::remove(const std::string& name) {
+    auto it = _ids.find(name);
+    if (it == _ids.end()) return;
+
+    uint32 id = it->second;
+    _ring.erase(std::remove_if(_ring.begin(), _ring.end(),
+                               [id](const std::pair<uint32, uint32>& p) {
+                                   return p.second == id;
+                               }),
+                _ring.end());
+    _names[id].clear();
+    _ids.erase(it);
+}
+
+const std::string* KetamaHash::find(const char* key, uint32 len) const {
+    if (_ring.empty()) return NULL;
+
+    unsigned char digest[16];
+    md5(key, len, digest);
+    auto it = std::lower_bound(_ring.begin(), _ring.end(),
+                               std::make_pair(point(digest, 0), 0u));
+    if (it == _ring.end()) it = _ring.begin();
+    return &_names[it->second];
+}
+
+// removing a node moves the last one to its bucket, so keys of the two
+// nodes move, but not others.
+class JumpHash : public ConsistentHash {
+  public:
+    JumpHash() = default;
+    virtual ~JumpHash() = default;
+
+    virtual void add(const std::string& name, uint32 weight) {
+        if (_index.find(name) != _index.end()) return;
+        _index[name] = _nodes.size();
+        _nodes.push_back(name);
+    }
+
+    virtual void remove(const std::string& name) {
+        auto it = _index.find(name);
+        if (it == _index.end()) return;
+
+        uint32 i = it->second;
+        _index.erase(it);
+        if (i + 1 != _nodes.size()) {
+            _nodes[i].swap(_nodes.back());
+            _index[_nodes[i]] = i;
+        }
+        _nodes.pop_back();
+    }
+
+    virtual const std::string* find(const char* key, uint32 len) const {
+        if (_nodes.empty()) return NULL;
+        return &_nodes[jumpConsistentHash(XXH3Hash64(key, len), _nodes.size())];
+    }
+
+    virtual uint32 size() const {
+        return _nodes.size();
+    }
+
+  private:
+    std::vector<std::string> _nodes;
+    std::unordered_map<std::string, uint32> _index;
+};
+
+// the node of the highest weight / -ln(hash(key, node)), so a node gets
+// keys in proportion to its weight.
+class RendezvousHash : public ConsistentHash {
+  public:
+    RendezvousHash() = default;
+    virtual ~RendezvousHash() = default;
+
+    virtual void add(const std::string& name, uint32 weight) {
+        for (auto& n : _nodes) {
+            if (n.name == name) {
+                n.weight = weight;
+                return;
+            }
+        }
+
+        Node n = { name, XXH3Hash64(name), static_cast<double>(weight) };
+        _nodes.push_back(n);
+    }
+
+    virtual void remove(const std::string& name) {
+        for (auto it = _nodes.begin(); it != _nodes.end(); ++it) {
+            if (it->name == name) {
+                _nodes.erase(it);
+                return;
+            }
+        }
+    }
+
+    virtual const std::string* find(const char* key, uint32 len) const;
+
+    virtual uint32 size() const {
+        return _nodes.size();
+    }
+
+  private:
+    struct Node {
+        std::string name;
+        uint64 seed;
+        double weight;
+    };
+    std::vector<Node> _nodes;
+
+    // murmur3 fmix64.
+    static uint64 mix(uint64 h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+};
+
+const std::string* RendezvousHash::find(const char* key, uint32 len) const {
+    const std::string* best = NULL;
+    double best_score = 0;
+
+    uint64 k = XXH3Hash64(key, len);
+    for (auto& n : _nodes) {
+        // uniform in (0, 1).
+        double u = ((mix(k ^ n.seed) >> 11) + 0.5) / (1ULL << 53);
+        double score = n.weight / -std::log(u);
+        if (best == NULL || score > best_score) {
+            best = &n.name;
+            best_score = score;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+int32 jumpConsistentHash(uint64 key, int32 buckets) {
+    int64 b = -1, j = 0;
+    while (j < buckets) {
+        b = j;
+        key = key * 2862933555777941757ULL + 1;
+        j = (b + 1) * (static_cast<double>(1LL << 31) /
+                       static_cast<double>((key >> 33) + 1));
+    }
+    return static_cast<int32>(b);
+}
+
+ConsistentHash* CreateConsistentHash(HashStrategy strategy) {
+    switch (strategy) {
+        case HASH_KETAMA:
+            return new KetamaHash;
+        case HASH_JUMP:
+            return new JumpHash;
+        case HASH_RENDEZVOUS:
+            return new RendezvousHash;
+        default:
+            CHECK(false) << "unknown hash strategy: " << strategy;
+            return NULL;
+    }
+}
+
+} // namespace util
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "base/base.h"
+
+namespace util {
+
+enum HashStrategy {
+    // libketama compatible ring, 160 points for each unit of weight.
+    HASH_KETAMA = 0,
+    // jump consistent hash of Lamping and Veach, no memory and the most even
+    // spread, weights are ignored.  removing a node moves the node of the
+    // last bucket into its bucket, so keys of both nodes move.
+    HASH_JUMP,
+    // weighted rendezvous (highest random weight), O(n) per lookup, for a
+    // few dozens of nodes at most.
+    HASH_RENDEZVOUS,
+};
+
+/*
+ * map keys to named nodes, only keys of the node added or removed move to
+ * another node, except on remove() of HASH_JUMP, see above.  add() and
+ * remove() update the mapping incrementally.
+ *
+ *   find() can be called concurrently, but not with add() or remove().
+ */
+class ConsistentHash {
+  public:
+    virtual ~ConsistentHash() = default;
+
+    // add @name or update its weight.
+    virtual void add(const std::string& name, uint32 weight = 1) = 0;
+    virtual void remove(const std::string& name) = 0;
+
+    // the node of @key, NULL if there is no node.
+    virtual const std::string* find(const char* key, uint32 len) const = 0;
+    const std::string* find(const std::string& key) const {
+        return this->find(key.data(), key.size());
+    }
+
+    virtual uint32 size() const = 0;
+
+  protected:
+    ConsistentHash() = default;
+
+  private:
+    DISALLOW_COPY_AND_ASSIGN(ConsistentHash);
+};
+
+ConsistentHash* CreateConsistentHash(HashStrategy strategy);
+
+// the bucket in [0, @buckets) of @key, @buckets must be positive.
+int32 jumpConsistentHash(uint64 key, int32 buckets);
+
+} // namespace util
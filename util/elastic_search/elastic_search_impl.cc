@@ -11,6 +11,10 @@
 DEF_string(es_zk, "elastic_search", "es name in zookeeper");
 
 namespace util {
+namespace {
+// microseconds of posts to the node picked by getEntry().
+Histogram* const kPostHistogram = NamedHistogram("es.post");
+}
 
 ElasticSearch* CreateElasticSearch(const std::string& index,
                                    const std::string& zk_path) {
@@ -82,9 +86,10 @@ bool ElasticSearchImpl::post(const std::string& types, const std::string& uri,
 
   sys::timer timer;
   bool ret = entry->post(types, uri, condition, reply);
-  uint32 us = timer.ms();
-  if (us > 50) {
-    DLOG("timedout") << "ES post expired, used: " << us;
+  uint64 us = timer.us();
+  kPostHistogram->record(us);
+  if (us > 50 * 1000) {
+    DLOG("timedout") << "ES post expired, used: " << us / 1000;
   }
 
   if (!ret) {
@@ -104,9 +109,10 @@ bool ElasticSearchImpl::post(const std::string& types,
 
   sys::timer timer;
   bool ret = entry->post(types, request, reply);
-  uint32 us = timer.ms();
-  if (us > 50) {
-    DLOG("timedout") << "ES post expired, used: " << us;
+  uint64 us = timer.us();
+  kPostHistogram->record(us);
+  if (us > 50 * 1000) {
+    DLOG("timedout") << "ES post expired, used: " << us / 1000;
   }
 
   if (!ret) {
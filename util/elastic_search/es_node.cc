@@ -8,6 +8,10 @@
 DEF_uint32(es_timedout, 100, "timedout for es");
 
 namespace util {
+namespace {
+// microseconds of http posts to a node.
+Histogram* const kPostHistogram = NamedHistogram("es.node.post");
+}
 
 ESNode::~ESNode() = default;
 ESNode::ESNode(const std::string& index, const std::string& ip, uint16 port)
@@ -50,9 +54,10 @@ bool ESNode::post(const std::string& types, const std::string& uri,
 
   std::string val;
   auto ret = _http_client->post(url, condition, &val);
-  uint64 used = timer.ms();
-  if (used > 30) {
-    DLOG("timedout") << "es expired, used: " << used;
+  uint64 used = timer.us();
+  kPostHistogram->record(used);
+  if (used > 30 * 1000) {
+    DLOG("timedout") << "es expired, used: " << used / 1000;
   }
 
   if (!ret) {
@@ -68,9 +73,10 @@ bool ESNode::post(const std::string& types, const Json::Value& request,
   sys::timer timer;
   std::string val;
   auto ret = _http_client->post(toUri(types), &val);
-  uint64 used = timer.ms();
-  if (used > 30) {
-    DLOG("timedout") << "es expired, used: " << used;
+  uint64 used = timer.us();
+  kPostHistogram->record(used);
+  if (used > 30 * 1000) {
+    DLOG("timedout") << "es expired, used: " << used / 1000;
   }
 
   return ret ? parseJson(val, reply) : false;
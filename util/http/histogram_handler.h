@@ -0,0 +1,21 @@
+#pragma once
+
+#include "handler_map.h"
+#include "http_reply.h"
+
+namespace http {
+
+/*
+ * serve HistogramReport() of the named histograms, e.g. in registeHandler():
+ *
+ *   handlers->addHandler(http::NewHistogramHandler());
+ */
+inline Handler* NewHistogramHandler(const std::string& uri = "/histograms") {
+  Handler* handler = new Handler(uri);
+  handler->cb = [](const HttpRequest&, HttpReply* reply) {
+    reply->getHttpBody()->setBody(HistogramReport());
+  };
+  return handler;
+}
+
+}
@@ -30,12 +30,29 @@ void HttpScheduler::addEntry(evhtp_request_t* req, const std::string& key,
   evhtp_headers_add_header(req->headers_out, kv);
 }
 
+namespace {
+// one for each thread of the server, they live as long as the process.
+ThreadStorage<sys::time_formatter> kGMTime;
+
+sys::time_formatter* gmtFormatter() {
+  sys::time_formatter* f = kGMTime.get();
+  if (f == NULL) {
+    f = new sys::time_formatter("%a, %d %b %Y %H:%M:%S GMT");
+    kGMTime.set(f);
+  }
+  return f;
+}
+}  // namespace
+
 const std::string HttpScheduler::GMTime() const {
-  return sys::local_time.to_string("%a, %d %b %Y %H:%M:%S GMT");
+  return gmtFormatter()->to_string(sys::cached_now.local_sec());
 }
 
 void HttpScheduler::initHeader(evhtp_request_t* req) const {
-  addEntry(req, "Date", GMTime());
+  char date[64];
+  gmtFormatter()->format(sys::cached_now.local_sec(), date, sizeof(date));
+  evhtp_headers_add_header(req->headers_out,
+                           evhtp_header_new("Date", date, 1, 1));
   addEntry(req, "Content-Type", "text/html; charset=UTF-8");
   addEntry(req, "Server", FLG_serv_name);
   addEntry(req, "Cache-Control", "no-cache");
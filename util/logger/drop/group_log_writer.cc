@@ -0,0 +1,225 @@
+#include "group_log_writer.h"
+
+namespace util {
+
+namespace {
+const uint32 kWriterBits = 16;
+const uint64 kWriterMask = (1ULL << kWriterBits) - 1;
+
+// file offset where a record of @len bytes starting at @offset ends.
+inline uint64 recordEnd(uint64 offset, uint32 len) {
+  uint32 pos = 0;
+  while (true) {
+    uint32 space_size = BLOCK_SIZE - offset % BLOCK_SIZE;
+    if (space_size <= LOG_HEADER_SIZE) {
+      offset += space_size;
+      continue;
+    }
+
+    uint32 avail_len = std::min(space_size - LOG_HEADER_SIZE, len - pos);
+    offset += LOG_HEADER_SIZE + avail_len;
+    pos += avail_len;
+    if (pos == len) return offset;
+  }
+}
+}
+
+GroupLogWriter::GroupLogWriter(RandomAccessFile* log_file,
+                               bool enable_crc_check, uint32 interval_ms,
+                               uint32 ring_blocks)
+    : _log_file(log_file), _crc_check(enable_crc_check),
+      _ring_blocks(ring_blocks), _state(0), _written(0), _cond(_mutex),
+      _synced(0), _codec(LOG_RAW), _compress(false), _frame_offset(0) {
+  CHECK_NOTNULL(log_file);
+  CHECK_GT(ring_blocks, 0U);
+
+  _ring.reset(new char[BLOCK_SIZE * ring_blocks]);
+  _filled.reset(new uint32[ring_blocks]);
+  ::memset(_filled.get(), 0, sizeof(uint32) * ring_blocks);
+
+  _committer.reset(
+      new StoppableThread(std::bind(&GroupLogWriter::commit, this),
+                          interval_ms));
+}
+
+GroupLogWriter::~GroupLogWriter() {
+  if (_log_file->fd() != kInvalidFd) {
+    _committer->join();
+    commit();
+  }
+}
+
+bool GroupLogWriter::Init() {
+  if (!_log_file->Init()) return false;
+  return _committer->start();
+}
+
+bool GroupLogWriter::setCompression(LogCodec codec) {
+  CHECK(_log_file->fd() == kInvalidFd) << "compress after Init()";
+  if (!logCodecSupported(codec)) return false;
+
+  _codec = codec;
+  _compress = true;
+  return true;
+}
+
+uint64 GroupLogWriter::reserve(uint32 len, uint64* start) {
+  uint64 state = __atomic_load_n(&_state, __ATOMIC_RELAXED);
+  while (true) {
+    uint64 end = recordEnd(state >> kWriterBits, len);
+    CHECK_LT(state & kWriterMask, kWriterMask);
+
+    uint64 new_state = (end << kWriterBits) | ((state & kWriterMask) + 1);
+    if (__atomic_compare_exchange_n(&_state, &state, new_state, true,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+      *start = state >> kWriterBits;
+      return end;
+    }
+  }
+}
+
+// wait until the block of @offset is no longer in use by a previous round
+// of the ring.
+char* GroupLogWriter::slot(uint64 offset) {
+  const uint64 ring_size = static_cast<uint64>(BLOCK_SIZE) * _ring_blocks;
+  uint64 block_end = (offset / BLOCK_SIZE + 1) * BLOCK_SIZE;
+
+  if (block_end > __atomic_load_n(&_written, __ATOMIC_ACQUIRE) + ring_size) {
+    _committer->notify();
+
+    MutexGuard g(_mutex);
+    while (block_end > __atomic_load_n(&_written, __ATOMIC_ACQUIRE) +
+        ring_size) {
+      _cond.wait();
+    }
+  }
+
+  return _ring.get() + offset % ring_size;
+}
+
+void GroupLogWriter::fill(uint64 offset, const char* data, uint32 len) {
+  char* buf = slot(offset);
+  if (data != NULL) {
+    ::memcpy(buf, data, len);
+  } else {
+    ::memset(buf, '\0', len);
+  }
+
+  __atomic_add_fetch(&_filled[offset / BLOCK_SIZE % _ring_blocks], len,
+                     __ATOMIC_RELEASE);
+}
+
+void GroupLogWriter::fillHeader(uint64 offset, uint32 type, const char* data,
+                                uint32 len) {
+  // length + type + crc32
+  char* buf = slot(offset);
+  save32(buf, len);  // length
+  buf += 4;
+  save32(buf, type);  // type
+  buf += 4;
+  uint32 crc = 0;
+  if (_crc_check) crc = crc32Value(data, len);
+  save32(buf, crc);  // crc32
+  buf += 4;
+
+  ::memcpy(buf, data, len);
+  __atomic_add_fetch(&_filled[offset / BLOCK_SIZE % _ring_blocks],
+                     LOG_HEADER_SIZE + len, __ATOMIC_RELEASE);
+}
+
+uint64 GroupLogWriter::append(const char* data, uint32 len) {
+  uint64 offset;
+  uint64 end = reserve(len, &offset);
+  uint32 pos = 0;
+
+  while (true) {
+    uint32 space_size = BLOCK_SIZE - offset % BLOCK_SIZE;
+    if (space_size <= LOG_HEADER_SIZE) {
+      fill(offset, NULL, space_size);
+      offset += space_size;
+      continue;
+    }
+
+    uint32 avail_len = std::min(space_size - LOG_HEADER_SIZE, len - pos);
+    uint32 type = 0;
+    if (pos == 0) type |= START_RECORD;
+    if (pos + avail_len == len) type |= LAST_RECORD;
+
+    fillHeader(offset, type, data + pos, avail_len);
+    offset += LOG_HEADER_SIZE + avail_len;
+    pos += avail_len;
+
+    if (pos == len) break;
+  }
+
+  CHECK_EQ(offset, end);
+  __atomic_sub_fetch(&_state, 1, __ATOMIC_RELEASE);
+  return end;
+}
+
+void GroupLogWriter::sync(uint64 seq) {
+  MutexGuard g(_mutex);
+  while (_synced < seq) {
+    _cond.wait();
+  }
+}
+
+// the longest filled range from _written.
+uint64 GroupLogWriter::committable() {
+  uint64 state = __atomic_load_n(&_state, __ATOMIC_ACQUIRE);
+  uint64 reserved = state >> kWriterBits;
+  if ((state & kWriterMask) == 0) return reserved;
+
+  // some records are being copied, only full blocks can be written.
+  uint64 block = _written / BLOCK_SIZE;
+  uint64 last = block + _ring_blocks;
+  while (block < last && (block + 1) * BLOCK_SIZE <= reserved &&
+      __atomic_load_n(&_filled[block % _ring_blocks], __ATOMIC_ACQUIRE) ==
+          BLOCK_SIZE) {
+    ++block;
+  }
+  return std::max(_written, block * BLOCK_SIZE);
+}
+
+// run in the committer thread only, or in the destructor.
+void GroupLogWriter::commit() {
+  uint64 end = committable();
+  if (end == _written) return;
+
+  const uint64 ring_size = static_cast<uint64>(BLOCK_SIZE) * _ring_blocks;
+  _frames.clear();
+  uint64 offset = _written;
+  while (offset < end) {
+    uint64 pos = offset % ring_size;
+    uint32 len = std::min(end - offset, ring_size - pos);
+    if (_compress) {
+      appendFrame(_codec, _crc_check, _ring.get() + pos, len, &_frames);
+    } else {
+      int32 writen = _log_file->write(_ring.get() + pos, len, offset);
+      CHECK_EQ(writen, static_cast<int32>(len))
+          << "write error: " << _log_file->fpath();
+    }
+    offset += len;
+  }
+
+  if (_compress) {
+    int32 writen = _log_file->write(_frames.data(), _frames.size(),
+                                    _frame_offset);
+    CHECK_EQ(writen, static_cast<int32>(_frames.size()))
+        << "write error: " << _log_file->fpath();
+    _frame_offset += _frames.size();
+  }
+  CHECK(_log_file->flush()) << "fdatasync error: " << _log_file->fpath();
+
+  for (uint64 block = _written / BLOCK_SIZE; (block + 1) * BLOCK_SIZE <= end;
+      ++block) {
+    __atomic_store_n(&_filled[block % _ring_blocks], 0, __ATOMIC_RELAXED);
+  }
+  __atomic_store_n(&_written, end, __ATOMIC_RELEASE);
+
+  MutexGuard g(_mutex);
+  _synced = end;
+  _cond.broadcast();
+}
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "base/base.h"
+#include "logger_def.h"
+#include "log_frame.h"
+
+namespace util {
+
+/*
+ * threadsafe LogWriter, the file format is the same.
+ *
+ *   appenders reserve space in a ring of blocks by CAS and copy records in
+ *   parallel, a committer thread writes what has been filled and fdatasync
+ *   once every @interval_ms, so many appends share one write and one sync.
+ *
+ *   GroupLogWriter writer(new RandomAccessFile(path));
+ *   CHECK(writer.Init());
+ *   uint64 seq = writer.append(log);  // any thread
+ *   writer.sync(seq);  // wait until the record is durable, if needed
+ */
+class GroupLogWriter {
+  public:
+    GroupLogWriter(RandomAccessFile* log_file, bool enable_crc_check = true,
+                   uint32 interval_ms = 10, uint32 ring_blocks = 64);
+
+    // commit remaining records, appenders must have returned.
+    ~GroupLogWriter();
+
+    bool Init();
+
+    // compress in the committer thread, call it before Init().
+    bool setCompression(LogCodec codec);
+
+    // return the sequence number of the record, it's the offset where the
+    // record ends in the (uncompressed) file, and increases with the order
+    // of reservation.
+    uint64 append(const char* data, uint32 len);
+    uint64 append(const std::string& log) {
+      return append(log.data(), log.size());
+    }
+
+    // block until records before @seq are written and synced.
+    void sync(uint64 seq);
+
+    // records before synced() are durable.
+    uint64 synced() {
+      MutexGuard g(_mutex);
+      return _synced;
+    }
+
+  private:
+    std::unique_ptr<RandomAccessFile> _log_file;
+    const bool _crc_check;
+
+    const uint32 _ring_blocks;
+    std::unique_ptr<char[]> _ring;
+
+    // reserved offset << 16 | appenders copying records.
+    uint64 _state;
+    // bytes of each block filled, reset when the block is written.
+    std::unique_ptr<uint32[]> _filled;
+    // [0, _written) of the file has been written and synced.
+    uint64 _written;
+
+    Mutex _mutex;
+    CondVar _cond;
+    uint64 _synced;
+
+    std::unique_ptr<StoppableThread> _committer;
+
+    LogCodec _codec;
+    bool _compress;
+    uint64 _frame_offset;  // file offset of the next frame
+    std::string _frames;
+
+    uint64 reserve(uint32 len, uint64* start);
+    char* slot(uint64 offset);
+    void fill(uint64 offset, const char* data, uint32 len);
+    void fillHeader(uint64 offset, uint32 type, const char* data, uint32 len);
+
+    uint64 committable();
+    void commit();
+
+    DISALLOW_COPY_AND_ASSIGN(GroupLogWriter);
+};
+}
@@ -0,0 +1,192 @@
+#undef DISALLOW_COPY_AND_ASSIGN
+#include <snappy.h>
+#undef DISALLOW_COPY_AND_ASSIGN
+#include "log_frame.h"
+
+// build with -DLOG_HAVE_LZ4 and link liblz4 for LOG_LZ4.
+#ifdef LOG_HAVE_LZ4
+#include <lz4.h>
+#endif
+
+namespace util {
+
+namespace {
+const uint32 kFrameMagic = 0x4c460000;  // "LF"
+const uint32 kFrameMask = 0xffff0000;
+
+// compress @data to @out, return the compressed length, 0 if it doesn't
+// compress.
+uint32 compress(LogCodec codec, const char* data, uint32 len, char* out,
+                uint32 out_len) {
+  size_t n = 0;
+  switch (codec) {
+    case LOG_SNAPPY:
+      if (out_len < snappy::MaxCompressedLength(len)) return 0;
+      snappy::RawCompress(data, len, out, &n);
+      break;
+#ifdef LOG_HAVE_LZ4
+    case LOG_LZ4:
+      n = ::LZ4_compress_default(data, out, len, out_len);
+      break;
+#endif
+    default:
+      return 0;
+  }
+
+  return n < len ? n : 0;
+}
+
+bool uncompress(LogCodec codec, const char* data, uint32 len, char* out,
+                uint32 raw_len) {
+  switch (codec) {
+    case LOG_RAW:
+      if (len != raw_len) return false;
+      ::memcpy(out, data, len);
+      return true;
+    case LOG_SNAPPY: {
+      size_t n;
+      if (!snappy::GetUncompressedLength(data, len, &n) || n != raw_len) {
+        return false;
+      }
+      return snappy::RawUncompress(data, len, out);
+    }
+#ifdef LOG_HAVE_LZ4
+    case LOG_LZ4:
+      return ::LZ4_decompress_safe(data, out, len, raw_len) ==
+          static_cast<int>(raw_len);
+#endif
+    default:
+      return false;
+  }
+}
+}
+
+bool logCodecSupported(LogCodec codec) {
+  switch (codec) {
+    case LOG_RAW:
+    case LOG_SNAPPY:
+      return true;
+#ifdef LOG_HAVE_LZ4
+    case LOG_LZ4:
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+void appendFrame(LogCodec codec, bool crc_check, const char* data,
+                 uint32 len, std::string* out) {
+  uint32 pos = out->size();
+  uint32 max_len = len;
+  if (codec == LOG_SNAPPY) max_len = snappy::MaxCompressedLength(len);
+#ifdef LOG_HAVE_LZ4
+  if (codec == LOG_LZ4) max_len = ::LZ4_compressBound(len);
+#endif
+  out->resize(pos + FRAME_HEADER_SIZE + max_len);
+
+  char* buf = &(*out)[pos];
+  char* body = buf + FRAME_HEADER_SIZE;
+  uint32 n = compress(codec, data, len, body, max_len);
+  if (n == 0) {
+    codec = LOG_RAW;
+    n = len;
+    ::memcpy(body, data, len);
+  }
+
+  // length + type + crc32 + raw length
+  save32(buf, n);
+  buf += 4;
+  save32(buf, kFrameMagic | codec);
+  buf += 4;
+  uint32 crc = 0;
+  if (crc_check) crc = crc32Value(body, n);
+  save32(buf, crc);
+  buf += 4;
+  save32(buf, len);
+
+  out->resize(pos + FRAME_HEADER_SIZE + n);
+}
+
+int FrameDecoder::isFramed(const char* head, uint32 len) {
+  if (len < 8) return -1;
+  return (v32((head + 4)) & kFrameMask) == kFrameMagic;
+}
+
+// load the frame holding @offset, return 1 if loaded, 0 at eof, -1 on error.
+int FrameDecoder::nextFrame(uint64 offset) {
+  while (true) {
+    char head[FRAME_HEADER_SIZE];
+    int32 readn = _read(head, FRAME_HEADER_SIZE, _file_offset);
+    if (readn < 0) return -1;
+    if (readn < FRAME_HEADER_SIZE) return 0;
+
+    const char* buf = head;
+    uint32 len = v32(buf);
+    buf += 4;
+    uint32 type = v32(buf);
+    buf += 4;
+    uint32 saved_crc = v32(buf);
+    buf += 4;
+    uint32 raw_len = v32(buf);
+
+    if ((type & kFrameMask) != kFrameMagic) {
+      WLOG<< "bad frame at " << _file_offset;
+      return -1;
+    }
+
+    uint64 end = _end + raw_len;
+    if (offset >= end) {
+      _file_offset += FRAME_HEADER_SIZE + len;
+      _start = _end = end;
+      continue;
+    }
+
+    _frame.resize(len);
+    readn = _read(&_frame[0], len, _file_offset + FRAME_HEADER_SIZE);
+    if (readn < 0) return -1;
+    if (readn < static_cast<int32>(len)) return 0;
+
+    if (_crc_check && saved_crc != 0 &&
+        crc32Value(_frame.data(), len) != saved_crc) {
+      WLOG<< "frame crc error at " << _file_offset;
+      return -1;
+    }
+
+    _data.resize(raw_len);
+    LogCodec codec = static_cast<LogCodec>(type & ~kFrameMask);
+    if (!uncompress(codec, _frame.data(), len, &_data[0], raw_len)) {
+      WLOG<< "uncompress frame error at " << _file_offset << ", codec: "
+          << codec;
+      return -1;
+    }
+
+    _file_offset += FRAME_HEADER_SIZE + len;
+    _start = _end;
+    _end = end;
+    return 1;
+  }
+}
+
+int32 FrameDecoder::read(char* buf, uint32 len, uint64 offset) {
+  CHECK_GE(offset, _start) << "read backward";
+
+  uint32 copied = 0;
+  while (copied < len) {
+    uint64 pos = offset + copied;
+    if (pos >= _end) {
+      int ret = nextFrame(pos);
+      if (ret < 0 && copied == 0) return -1;
+      if (ret <= 0) break;
+      continue;
+    }
+
+    uint32 n = std::min<uint64>(len - copied, _end - pos);
+    ::memcpy(buf + copied, _data.data() + (pos - _start), n);
+    copied += n;
+  }
+
+  return copied;
+}
+
+}
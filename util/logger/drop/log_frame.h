@@ -0,0 +1,65 @@
+#pragma once
+
+#include "base/base.h"
+#include "logger_def.h"
+
+namespace util {
+
+/*
+ * a compressed log file is a sequence of frames, each holds a range of
+ * the uncompressed file, which is in the usual block format.
+ *
+ *   length(4) + type(4) + crc32(4) + raw length(4) + data
+ *
+ *   type is kFrameMagic | codec, never a valid record type, so readers
+ *   tell compressed files from old ones by the first header.  a frame is
+ *   stored raw if it doesn't compress.
+ */
+enum LogCodec {
+  LOG_RAW = 0, LOG_SNAPPY = 1, LOG_LZ4 = 2,
+};
+
+#define FRAME_HEADER_SIZE 16
+
+// LZ4 is supported only if built with LOG_HAVE_LZ4 defined.
+bool logCodecSupported(LogCodec codec);
+
+// append a frame of @data to @out.
+void appendFrame(LogCodec codec, bool crc_check, const char* data,
+                 uint32 len, std::string* out);
+
+// read the uncompressed file of frames.
+class FrameDecoder {
+  public:
+    // pread(2) like, return bytes read, 0 at eof, -1 on error.
+    typedef std::function<int32(char* buf, uint32 len, uint64 offset)> ReadFun;
+
+    FrameDecoder(ReadFun read_fun, bool crc_check)
+        : _read(read_fun), _crc_check(crc_check), _file_offset(0),
+          _start(0), _end(0) {
+    }
+
+    // -1 if @len bytes of the file head aren't enough to tell.
+    static int isFramed(const char* head, uint32 len);
+
+    // bytes read at @offset of the uncompressed file, 0 at eof, -1 on
+    // error.  @offset never goes backward, frames before it are skipped
+    // without being read.  a frame being written is taken as eof.
+    int32 read(char* buf, uint32 len, uint64 offset);
+
+  private:
+    ReadFun _read;
+    const bool _crc_check;
+
+    uint64 _file_offset;  // of the next frame
+    uint64 _start;  // uncompressed range of _data
+    uint64 _end;
+    std::string _data;
+    std::string _frame;
+
+    int nextFrame(uint64 offset);
+
+    DISALLOW_COPY_AND_ASSIGN(FrameDecoder);
+};
+
+}
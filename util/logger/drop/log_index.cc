@@ -0,0 +1,95 @@
+#include "log_index.h"
+
+namespace util {
+
+namespace {
+// file_id + block_offset + block_pos + seq + time + crc32
+const uint32 kEntrySize = 8 + 8 + 4 + 8 + 8 + 4;
+}
+
+std::string logIndexPath(const std::string& log_path) {
+  auto path = sys::split_path(log_path);
+  if (path.first.empty()) return "." + path.second + ".idx";
+  return path.first + "/." + path.second + ".idx";
+}
+
+uint64 logFileId(const std::string& log_path) {
+  return ::strtoull(sys::split_path(log_path).second.c_str(), NULL, 10);
+}
+
+bool LogIndexWriter::append(const LogIndexEntry& entry) {
+  char buf[kEntrySize];
+  char* p = buf;
+  save64(p, entry.file_id);
+  p += 8;
+  save64(p, entry.block_offset);
+  p += 8;
+  save32(p, entry.block_pos);
+  p += 4;
+  save64(p, entry.seq);
+  p += 8;
+  save64(p, entry.time);
+  p += 8;
+  save32(p, crc32Mask(crc32Value(buf, p - buf)));
+
+  return _file.write(buf, kEntrySize) > 0;
+}
+
+bool readLogIndex(const std::string& log_path,
+                  std::vector<LogIndexEntry>* entries) {
+  std::string data;
+  if (!readFile(logIndexPath(log_path), &data)) return false;
+
+  for (uint64 pos = 0; pos + kEntrySize <= data.size(); pos += kEntrySize) {
+    const char* p = data.data() + pos;
+    uint32 crc = crc32Value(p, kEntrySize - 4);
+    if (crc32Unmask(v32((p + kEntrySize - 4))) != crc) {
+      WLOG<< "bad index entry, path: " << log_path << ", pos: " << pos;
+      continue;
+    }
+
+    LogIndexEntry entry;
+    entry.file_id = v64(p);
+    p += 8;
+    entry.block_offset = v64(p);
+    p += 8;
+    entry.block_pos = v32(p);
+    p += 4;
+    entry.seq = v64(p);
+    p += 8;
+    entry.time = v64(p);
+    entries->push_back(entry);
+  }
+
+  return true;
+}
+
+bool saveLogCheckpoint(const std::string& path, const LogCheckpoint& cp) {
+  std::string data = util::to_string(cp.file_id) + " " +
+      util::to_string(cp.offset) + " " + util::to_string(cp.seq) + "\n";
+
+  std::string tmp = path + ".tmp";
+  if (!writeFile(tmp, data)) return false;
+  if (::rename(tmp.c_str(), path.c_str()) != 0) {
+    WLOG<< "rename error, path: " << tmp;
+    return false;
+  }
+  return true;
+}
+
+bool loadLogCheckpoint(const std::string& path, LogCheckpoint* cp) {
+  std::string data;
+  if (!readFile(path, &data)) return false;
+
+  auto v = util::split_string(util::trim_string(data, '\n'), ' ');
+  std::string err;
+  if (v.size() != 3 || !util::to_uint64(v[0], &cp->file_id, err) ||
+      !util::to_uint64(v[1], &cp->offset, err) ||
+      !util::to_uint64(v[2], &cp->seq, err)) {
+    WLOG<< "bad checkpoint, path: " << path << ", data: " << data;
+    return false;
+  }
+  return true;
+}
+
+}
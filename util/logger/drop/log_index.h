@@ -0,0 +1,73 @@
+#pragma once
+
+#include "base/base.h"
+#include "logger_def.h"
+
+namespace util {
+
+/*
+ * sparse index of a log file, LogWriter appends an entry every N records
+ * to a hidden file beside the log file: "dir/.id.idx".
+ */
+struct LogIndexEntry {
+  uint64 file_id;
+  uint64 block_offset;  // file offset of the block the record starts in
+  uint32 block_pos;  // offset of the record header in the block
+  uint64 seq;  // sequence number of the record
+  int64 time;  // ms since EPOCH when the record was appended
+
+  uint64 offset() const {
+    return block_offset + block_pos;
+  }
+};
+
+std::string logIndexPath(const std::string& log_path);
+
+// the file id is the name of the log file.
+uint64 logFileId(const std::string& log_path);
+
+class LogIndexWriter {
+  public:
+    explicit LogIndexWriter(const std::string& log_path)
+        : _file(logIndexPath(log_path)) {
+    }
+
+    bool Init() {
+      return _file.Init();
+    }
+
+    bool append(const LogIndexEntry& entry);
+
+    bool flush() {
+      return _file.flush();
+    }
+
+  private:
+    AppendonlyFile _file;
+
+    DISALLOW_COPY_AND_ASSIGN(LogIndexWriter);
+};
+
+// entries with a bad crc and a torn tail are dropped.
+bool readLogIndex(const std::string& log_path,
+                  std::vector<LogIndexEntry>* entries);
+
+/*
+ * position of a consumer, the next record to read is @seq at @offset of
+ * the log file @file_id.
+ */
+struct LogCheckpoint {
+  LogCheckpoint()
+      : file_id(0), offset(0), seq(0) {
+  }
+
+  uint64 file_id;
+  uint64 offset;
+  uint64 seq;
+};
+
+// written to a temporary file and renamed, so it's never half written.
+bool saveLogCheckpoint(const std::string& path, const LogCheckpoint& cp);
+bool loadLogCheckpoint(const std::string& path, LogCheckpoint* cp);
+
+}
@@ -1,130 +1,529 @@
 #include "log_input_stream.h"
 #include "log_reader.h"
 
-namespace {
-std::string itostring(uint64 i) {
-  std::string buf;
-  while (i != 0) {
-    char c = i % 10 + '0';
-    buf.append(0, c);
-    i /= 10;
-  }
-  return buf;
-}
-}
-
 namespace util {
 
 class LogInputStream::LogDir {
   public:
     explicit LogDir(const std::string& dir)
-        : dit_(dir), dir_name_(dir) {
+        : walker_(dir), dir_name_(dir) {
     }
     ~LogDir() {
     }
 
     bool Init();
 
-    bool nextLogFile(std::string* log_file);
+    bool nextLogFile(std::string* log_file, uint64* id);
+
+    // files before @id won't be returned by nextLogFile().
+    void skipTo(uint64 id) {
+      while (!ids_.empty() && ids_.front() < id) {
+        ids_.pop_front();
+      }
+    }
+
+    const std::deque<uint64>& ids() const {
+      return ids_;
+    }
+
+    std::string path(uint64 id) const {
+      return dir_name_ + "/" + util::to_string(id);
+    }
 
   private:
-    DirIterator dit_;
+    DirWalker walker_;
     const std::string dir_name_;
 
-    std::deque<std::string> log_files_;
+    std::deque<uint64> ids_;
 
     DISALLOW_COPY_AND_ASSIGN(LogDir);
 };
 
 bool LogInputStream::LogDir::Init() {
-  if (!dit_.Init()) return false;
+  if (!walker_.Init()) return false;
+
+  // log files are named by id, skip hidden files.
+  walker_.setFilter([](const std::string& name, uint8 type) {
+    return type == DT_REG && name[0] != '.';
+  });
+
+  std::vector<DirWalker::Entry> entries;
+  if (!walker_.walk(&entries, false)) return false;
 
   std::set<uint64> ids;
-  while (true) {
-    const std::string* file = dit_.next(DirIterator::REG_FILE);
-    if (file != NULL) break;
+  for (auto it = entries.begin(); it != entries.end(); ++it) {
+    ids.insert(::strtoull(it->path.c_str(), NULL, 10));
+  }
+
+  ids_.assign(ids.begin(), ids.end());
+  return true;
+}
+
+bool LogInputStream::LogDir::nextLogFile(std::string* log_file, uint64* id) {
+  if (!ids_.empty()) {
+    *id = ids_.front();
+    *log_file = path(*id);
+    ids_.pop_front();
+    return true;
+  }
+
+  return false;
+}
+
+/*
+ * a reader thread reads files in chunks of blocks into a bounded queue,
+ * a thread pool splits chunks into fragments and verifies crc, and the
+ * consumer takes chunks from the queue head in order.
+ */
+class LogInputStream::Pipeline {
+  public:
+    // start from @start.offset if the first file is @start.file_id.
+    Pipeline(LogDir* dir, bool crc32_check, uint32 thread_num,
+             uint32 queue_size, const LogCheckpoint& start);
+    ~Pipeline();
+
+    void start();
+
+    bool next(const char** data, uint32* len);
+
+    // position of the next record.
+    uint64 fileId() const {
+      return _file_id;
+    }
+    uint64 position() const {
+      return _position;
+    }
+
+  private:
+    struct Fragment {
+      uint32 offset;
+      uint32 len;
+      uint32 type;
+    };
+
+    struct Chunk {
+      uint64 file_id;
+      uint64 offset;  // in the file
+      uint32 start;  // where the first record starts in the chunk
+      std::unique_ptr<char[]> buf;
+      uint32 size;
+
+      std::vector<Fragment> frags;
+      bool corrupt;  // the rest of the file should be skipped after frags
+      bool decoded;
+    };
+
+    LogDir* _dir;
+    const bool _crc32_check;
+    const uint32 _queue_size;
+    const LogCheckpoint _start;
+
+    Mutex _mutex;
+    CondVar _cond;
+    std::deque<std::shared_ptr<Chunk>> _queue;
+    std::vector<std::unique_ptr<char[]>> _free_bufs;
+    bool _eof;
+    bool _stop;
+
+    std::unique_ptr<ThreadPool> _pool;
+    std::unique_ptr<Thread> _reader;
+
+    // for the consumer.
+    std::shared_ptr<Chunk> _chunk;
+    uint32 _frag;
+    bool _skip_file;
+    std::string _scratch;
+    uint64 _file_id;
+    uint64 _position;
+
+    RandomAccessFile* openNextFile(uint64* file_id);
+    void readThread();
+    void decode(Chunk* chunk);
+
+    bool nextChunk();
+
+    static const uint32 kChunkSize = BLOCK_SIZE * 8;
+
+    DISALLOW_COPY_AND_ASSIGN(Pipeline);
+};
+
+LogInputStream::Pipeline::Pipeline(LogDir* dir, bool crc32_check,
+                                   uint32 thread_num, uint32 queue_size,
+                                   const LogCheckpoint& start)
+    : _dir(dir), _crc32_check(crc32_check), _queue_size(queue_size),
+      _start(start), _cond(_mutex), _eof(false), _stop(false), _frag(0),
+      _skip_file(false), _file_id(start.file_id), _position(start.offset) {
+  CHECK_GT(queue_size, 0);
+  _pool.reset(new ThreadPool(thread_num));
+}
+
+LogInputStream::Pipeline::~Pipeline() {
+  {
+    MutexGuard g(_mutex);
+    _stop = true;
+    _cond.broadcast();
+  }
+
+  if (_reader != NULL) _reader->join();
+  _pool.reset();
+}
+
+void LogInputStream::Pipeline::start() {
+  _reader.reset(new Thread(std::bind(&Pipeline::readThread, this)));
+  _reader->start();
+}
+
+// the file is opened one file ahead, so the kernel reads it in advance.
+RandomAccessFile* LogInputStream::Pipeline::openNextFile(uint64* file_id) {
+  std::string log_file;
+
+  while (_dir->nextLogFile(&log_file, file_id)) {
+    RandomAccessFile* file =
+        new RandomAccessFile(log_file, RandomAccessFile::READ_ONLY);
+    if (!file->Init()) {
+      WLOG<< "skip log file can't be opened: " << log_file;
+      delete file;
+      continue;
+    }
+
+    ::posix_fadvise(file->fd(), 0, 0, POSIX_FADV_SEQUENTIAL);
+    ::posix_fadvise(file->fd(), 0, 0, POSIX_FADV_WILLNEED);
+    return file;
+  }
+
+  return NULL;
+}
+
+void LogInputStream::Pipeline::readThread() {
+  uint64 next_id;
+  std::unique_ptr<RandomAccessFile> next_file(openNextFile(&next_id));
+
+  while (next_file != NULL) {
+    uint64 file_id = next_id;
+    std::unique_ptr<RandomAccessFile> file(std::move(next_file));
+    next_file.reset(openNextFile(&next_id));
+
+    uint64 offset = 0;
+    uint32 start = 0;
+    if (file_id == _start.file_id) {
+      offset = _start.offset / BLOCK_SIZE * BLOCK_SIZE;
+      start = _start.offset - offset;
+    }
+
+    // compressed files are uncompressed here, records are still split in
+    // the pool.
+    std::unique_ptr<FrameDecoder> frames;
+    char head[FRAME_HEADER_SIZE];
+    int32 head_len = file->read(head, FRAME_HEADER_SIZE, 0);
+    if (head_len > 0 && FrameDecoder::isFramed(head, head_len) == 1) {
+      RandomAccessFile* f = file.get();
+      frames.reset(new FrameDecoder([f](char* buf, uint32 len, uint64 off) {
+        return f->read(buf, len, off);
+      }, _crc32_check));
+    }
+
+    while (true) {
+      std::shared_ptr<Chunk> chunk(new Chunk);
+      chunk->file_id = file_id;
+      chunk->offset = offset;
+      chunk->start = start;
+      chunk->corrupt = false;
+      chunk->decoded = false;
+
+      {
+        MutexGuard g(_mutex);
+        while (!_stop && _queue.size() >= _queue_size) {
+          _cond.wait();
+        }
+        if (_stop) return;
+
+        if (!_free_bufs.empty()) {
+          chunk->buf = std::move(_free_bufs.back());
+          _free_bufs.pop_back();
+        }
+      }
+
+      if (chunk->buf == NULL) chunk->buf.reset(new char[kChunkSize]);
+      int32 readn = frames != NULL ?
+          frames->read(chunk->buf.get(), kChunkSize, offset) :
+          file->read(chunk->buf.get(), kChunkSize, offset);
+      if (readn <= 0 || readn < static_cast<int32>(start)) break;
+      chunk->size = readn;
+      start = 0;
 
-    CHECK(!file->empty());
-    if (file->at(0) != '.') {
-      ids.insert(atoi(file->c_str()));
+      {
+        MutexGuard g(_mutex);
+        _queue.push_back(chunk);
+      }
+
+      _pool->run([this, chunk]() {
+        decode(chunk.get());
+
+        MutexGuard g(_mutex);
+        chunk->decoded = true;
+        _cond.broadcast();
+      });
+
+      offset += readn;
+      if (readn < static_cast<int32>(kChunkSize)) break;
+    }
+  }
+
+  MutexGuard g(_mutex);
+  _eof = true;
+  _cond.broadcast();
+}
+
+// blocks are aligned in the chunk, the last block may be partial.
+void LogInputStream::Pipeline::decode(Chunk* chunk) {
+  for (uint32 block = 0; block < chunk->size; block += BLOCK_SIZE) {
+    uint32 load_size = std::min(BLOCK_SIZE, chunk->size - block);
+    uint32 offset = block == 0 ? chunk->start : 0;
+
+    while (offset < load_size) {
+      // the trailer of a block is padded with zero.
+      if (load_size == BLOCK_SIZE && BLOCK_SIZE - offset <= LOG_HEADER_SIZE) {
+        break;
+      }
+
+      // the file is truncated or being written.
+      if (load_size - offset < LOG_HEADER_SIZE) {
+        chunk->corrupt = true;
+        return;
+      }
+
+      const char* buf = chunk->buf.get() + block + offset;
+      uint32 size = v32(buf);
+      buf += 4;
+      uint32 type = v32(buf);
+      buf += 4;
+      uint32 saved_crc = v32(buf);
+      buf += 4;
+
+      if (size > load_size - offset - LOG_HEADER_SIZE) {
+        chunk->corrupt = true;
+        return;
+      }
+
+      if (_crc32_check && saved_crc != 0 &&
+          crc32Value(buf, size) != saved_crc) {
+        chunk->corrupt = true;
+        return;
+      }
+
+      Fragment frag = { block + offset + LOG_HEADER_SIZE, size, type };
+      chunk->frags.push_back(frag);
+      offset += LOG_HEADER_SIZE + size;
     }
   }
+}
+
+// wait for the chunk at the head of the queue to be decoded.
+bool LogInputStream::Pipeline::nextChunk() {
+  MutexGuard g(_mutex);
+  if (_chunk != NULL) {
+    _free_bufs.push_back(std::move(_chunk->buf));
+  }
+
+  while (!_stop) {
+    if (!_queue.empty() && _queue.front()->decoded) break;
+    if (_queue.empty() && _eof) return false;
+    _cond.wait();
+  }
+  if (_stop) return false;
+
+  std::shared_ptr<Chunk> chunk = _queue.front();
+  _queue.pop_front();
+  _cond.broadcast();
 
-  for (auto i = ids.begin(); i != ids.end(); ++i) {
-    log_files_.push_back(itostring(*i));
+  // records never span files.
+  if (_chunk == NULL || chunk->file_id != _chunk->file_id) {
+    _scratch.clear();
+    _skip_file = false;
   }
+
+  _chunk = chunk;
+  _frag = 0;
   return true;
 }
 
-bool LogInputStream::LogDir::nextLogFile(std::string* log_file) {
-  if (!log_files_.empty()) {
-    *log_file = dir_name_ + "/" + log_files_.front();
-    log_files_.pop_front();
-    return true;
+bool LogInputStream::Pipeline::next(const char** data, uint32* len) {
+  _scratch.clear();
+
+  while (true) {
+    if (_chunk == NULL || _frag == _chunk->frags.size()) {
+      if (_chunk != NULL && _chunk->corrupt) _skip_file = true;
+      if (!nextChunk()) return false;
+      if (_skip_file) _frag = _chunk->frags.size();
+      continue;
+    }
+
+    const Fragment& frag = _chunk->frags[_frag++];
+    const char* buf = _chunk->buf.get() + frag.offset;
+    if (frag.type & START_RECORD) _scratch.clear();
+
+    if (frag.type & LAST_RECORD) {
+      _file_id = _chunk->file_id;
+      _position = _chunk->offset + frag.offset + frag.len;
+    }
+
+    if ((frag.type & START_RECORD) && (frag.type & LAST_RECORD)) {
+      *data = buf;
+      *len = frag.len;
+      return true;
+    }
+
+    _scratch.append(buf, frag.len);
+    if (frag.type & LAST_RECORD) {
+      *data = _scratch.data();
+      *len = _scratch.size();
+      return true;
+    }
   }
+}
 
-  return false;
+LogInputStream::LogInputStream(bool enable_crc32_check, AioEngine* aio)
+    : _crc32_check(enable_crc32_check), _aio(aio), _file_id(0),
+      _thread_num(0), _queue_size(0), _started(false) {
 }
 
 LogInputStream::~LogInputStream() {
-  STLClear(&_log_queue);
 }
 
 bool LogInputStream::Init(const std::string& log_dir) {
   _dir.reset(new LogDir(log_dir));
-  if (!_dir->Init()) return false;
+  return _dir->Init();
+}
 
-  loadCache();
+bool LogInputStream::restore(const LogCheckpoint& cp) {
+  CHECK(!_started) << "restore after read";
+  _pos = cp;
+  _dir->skipTo(cp.file_id);
   return true;
 }
 
+bool LogInputStream::restore(const std::string& path) {
+  LogCheckpoint cp;
+  if (!loadLogCheckpoint(path, &cp)) return false;
+  return restore(cp);
+}
+
+// index entries are in order, so scan from the newest file, and stop at
+// the first file that has a matching entry.
+bool LogInputStream::findIndex(
+    std::function<bool(const LogIndexEntry&)> pred, LogIndexEntry* entry) {
+  const std::deque<uint64>& ids = _dir->ids();
+  for (auto it = ids.rbegin(); it != ids.rend(); ++it) {
+    std::vector<LogIndexEntry> entries;
+    if (!readLogIndex(_dir->path(*it), &entries)) continue;
+
+    for (auto e = entries.rbegin(); e != entries.rend(); ++e) {
+      if (pred(*e)) {
+        *entry = *e;
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+bool LogInputStream::seek(uint64 seq) {
+  LogCheckpoint cp;
+  LogIndexEntry entry;
+  if (findIndex([seq](const LogIndexEntry& e) {return e.seq <= seq;},
+                &entry)) {
+    cp.file_id = entry.file_id;
+    cp.offset = entry.offset();
+    cp.seq = entry.seq;
+  }
+  if (!restore(cp)) return false;
+
+  const char* data;
+  uint32 len;
+  while (_pos.seq < seq) {
+    if (!next(&data, &len)) return false;
+  }
+  return true;
+}
+
+bool LogInputStream::seekTime(int64 ms) {
+  LogCheckpoint cp;
+  LogIndexEntry entry;
+  if (findIndex([ms](const LogIndexEntry& e) {return e.time <= ms;},
+                &entry)) {
+    cp.file_id = entry.file_id;
+    cp.offset = entry.offset();
+    cp.seq = entry.seq;
+  }
+  return restore(cp);
+}
+
 bool LogInputStream::createReader() {
   std::string log_file;
 
-  SequentialReadonlyFile* file;
-  while (_dir->nextLogFile(&log_file)) {
-    file = new SequentialReadonlyFile(log_file);
-    if (!file->Init()) {
-      delete file;
-      continue;
+  while (_dir->nextLogFile(&log_file, &_file_id)) {
+    std::unique_ptr<LogReader> reader;
+    if (_aio != NULL) {
+      RandomAccessFile* file =
+          new RandomAccessFile(log_file, RandomAccessFile::READ_ONLY);
+      if (!file->Init()) {
+        WLOG<< "skip log file can't be opened: " << log_file;
+        delete file;
+        continue;
+      }
+      reader.reset(new LogReader(file, _aio, _crc32_check));
+
+    } else {
+      SequentialReadonlyFile* file = new SequentialReadonlyFile(log_file);
+      if (!file->Init()) {
+        WLOG<< "skip log file can't be opened: " << log_file;
+        delete file;
+        continue;
+      }
+      reader.reset(new LogReader(file, _crc32_check));
     }
 
-    _reader.reset(new LogReader(file, _crc32_check));
+    if (_file_id == _pos.file_id && _pos.offset != 0) {
+      reader->seek(_pos.offset);
+    }
+    _reader = std::move(reader);
     return true;
   }
 
   return false;
 }
 
-bool LogInputStream::loadCache() {
-  CHECK(_log_queue.empty());
+bool LogInputStream::next(const char** data, uint32* len) {
+  _started = true;
+
+  if (_thread_num != 0) {
+    if (_pipeline == NULL) {
+      _pipeline.reset(new Pipeline(_dir.get(), _crc32_check, _thread_num,
+                                   _queue_size, _pos));
+      _pipeline->start();
+    }
+
+    if (!_pipeline->next(data, len)) return false;
+    _pos.file_id = _pipeline->fileId();
+    _pos.offset = _pipeline->position();
+    ++_pos.seq;
+    return true;
+  }
+
   while (true) {
     if (_reader == NULL && !createReader()) {
       return false;
     }
 
-    CHECK_NOTNULL(_reader.get());
-    if (!_reader->read(&_log_queue, kLoadNumber)) {
-      _reader.reset();
-      continue;
+    if (_reader->next(data, len)) {
+      _pos.file_id = _file_id;
+      _pos.offset = _reader->position();
+      ++_pos.seq;
+      return true;
     }
-    break;
+    _reader.reset();
   }
-
-  CHECK(!_log_queue.empty());
-  return true;
-}
-
-std::string* LogInputStream::next() {
-  if (_log_queue.empty()) {
-    if (!loadCache()) return NULL;
-    if (_log_queue.empty()) return NULL;
-  }
-
-  CHECK(!_log_queue.empty());
-  std::string* log = _log_queue.front();
-  _log_queue.pop_front();
-  return log;
 }
 
 }
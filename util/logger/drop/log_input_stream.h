@@ -1,35 +1,85 @@
 #pragma once
 
 #include "base/base.h"
+#include "log_index.h"
 
 namespace util {
 class LogReader;
 
 class LogInputStream {
   public:
-    explicit LogInputStream(bool enable_crc32_check)
-        : _crc32_check(enable_crc32_check) {
-    }
+    // blocks are read ahead with @aio if it's not NULL.
+    explicit LogInputStream(bool enable_crc32_check, AioEngine* aio = NULL);
     virtual ~LogInputStream();
 
+    // read blocks in a background thread and verify crc in @thread_num
+    // threads, at most @queue_size chunks of blocks are buffered.  records
+    // are still returned in order.  call it before Init(), @aio is unused.
+    void setPipeline(uint32 thread_num = 2, uint32 queue_size = 16) {
+      _thread_num = thread_num;
+      _queue_size = queue_size;
+    }
+
     bool Init(const std::string& log_dir);
 
+    /*
+     * seek(), seekTime() and restore() set where to start, call them after
+     * Init() and before reading.  records are numbered as
+     * LogWriter::enableIndex() does, or from 0 at the first file.
+     */
+
+    // by the sparse index, at most one index interval of records are read
+    // and dropped.
+    bool seek(uint64 seq);
+
+    // the last indexed record appended before @ms. records don't carry a
+    // time, so up to one index interval of older records may be returned.
+    bool seekTime(int64 ms);
+
+    bool restore(const LogCheckpoint& cp);
+    bool restore(const std::string& checkpoint_path);
+
+    // position of the next record.
+    const LogCheckpoint& checkpoint() const {
+      return _pos;
+    }
+    bool saveCheckpoint(const std::string& path) const {
+      return saveLogCheckpoint(path, _pos);
+    }
+
+    // zero-copy, @data is valid until the next call.
+    bool next(const char** data, uint32* len);
+
     // delete by yourself.
-    std::string* next();
+    std::string* next() {
+      const char* data;
+      uint32 len;
+      if (!next(&data, &len)) return NULL;
+      return new std::string(data, len);
+    }
 
   private:
     bool _crc32_check;
-
-    bool loadCache();
-    std::deque<std::string*> _log_queue;
+    AioEngine* _aio;
 
     class LogDir;
     std::unique_ptr<LogDir> _dir;
 
     bool createReader();
     std::unique_ptr<LogReader> _reader;
+    uint64 _file_id;  // of _reader
+
+    uint32 _thread_num;
+    uint32 _queue_size;
+
+    class Pipeline;
+    std::unique_ptr<Pipeline> _pipeline;
+
+    LogCheckpoint _pos;
+    bool _started;
 
-    const static uint32 kLoadNumber = 64;
+    bool findIndex(std::function<bool(const LogIndexEntry&)> pred,
+                   LogIndexEntry* entry);
 
     DISALLOW_COPY_AND_ASSIGN(LogInputStream);
 };
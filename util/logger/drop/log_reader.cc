@@ -2,62 +2,181 @@
 
 namespace util {
 
-bool LogReader::loadCache() {
-  CHECK_EQ(offset_, load_size_);
-  int readn = log_file_->read(block_, BLOCK_SIZE);
-  if (readn > 0) {
-    offset_ = 0;
-    load_size_ = readn;
-    return true;
+void LogReader::readAhead() {
+  CHECK(!ahead_inflight_);
+  ahead_inflight_ = ahead_issued_ = true;
+  bool ret = ra_file_->asyncRead(aio_, ahead_, BLOCK_SIZE,
+                                 file_offset_ + BLOCK_SIZE,
+                                 [this](int32 res) {
+    ahead_res_ = res;
+    ahead_inflight_ = false;
+  });
+  if (!ret) {
+    ahead_res_ = -1;
+    ahead_inflight_ = false;
   }
+}
 
-  LOG<< "read error: " << readn;
-  return false;
+void LogReader::waitAhead() {
+  while (ahead_inflight_) {
+    aio_->poll(1);
+  }
+}
+
+int32 LogReader::readRaw(char* buf, uint32 len, uint64 offset) {
+  if (aio_ == NULL) {
+    // seek only off the sequential path, it drops the stdio buffer.
+    if (offset != read_pos_) log_file_->skip(offset);
+
+    int32 readn = log_file_->read(buf, len);
+    read_pos_ = readn == static_cast<int32>(len) ? offset + len : MAX_UINT64;
+    return readn;
+  }
+
+  int32 res = -1;
+  bool done = false;
+  bool ret = ra_file_->asyncRead(aio_, buf, len, offset,
+                                 [&res, &done](int32 r) {
+    res = r;
+    done = true;
+  });
+  if (!ret) return -1;
+
+  while (!done) {
+    aio_->poll(1);
+  }
+  return res;
+}
+
+int32 LogReader::readFile(char* buf, uint32 len, uint64 offset) {
+  if (frames_ != NULL) return frames_->read(buf, len, offset);
+  return readRaw(buf, len, offset);
 }
 
-bool LogReader::readRecord(std::string* log, bool* is_last) {
-  char* data = block_ + offset_;
-  uint32 len = v32(data);
-  data += 4;
-  CHECK_LE(len, load_size_ - offset_);
-  CHECK_LE(len, BLOCK_SIZE - offset_);
-  offset_ += len + LOG_HEADER_SIZE;
+// compressed files start with a frame header, see log_frame.h.
+bool LogReader::detect() {
+  char head[FRAME_HEADER_SIZE];
+  int32 readn = readRaw(head, FRAME_HEADER_SIZE, 0);
+  if (readn < 0) return false;
+
+  framed_ = FrameDecoder::isFramed(head, readn);
+  if (framed_ < 0) return false;  // empty, or the first header not written
 
-  uint32 type = v32(data);
-  data += 4;
-  if (type & START_RECORD) log->clear();
-  if (type & LAST_RECORD) *is_last = true;
+  if (framed_ == 1) {
+    frames_.reset(new FrameDecoder(
+        std::bind(&LogReader::readRaw, this, std::_1, std::_2, std::_3),
+        crc_check_));
+  }
+  return true;
+}
+
+// blocks are aligned to BLOCK_SIZE in the file. a block may be loaded in
+// several times if the writer hasn't finished it.
+bool LogReader::loadCache() {
+  CHECK_EQ(offset_, load_size_);
+  if (framed_ < 0 && !detect()) return false;
+  int32 readn;
 
-  uint32 saved_crc = v32(data);
-  data += 4;
-  if (crc_check_ && saved_crc != 0) {
-    uint32 crc = crc32Value(data, len);
-    if (crc != saved_crc) {
-      return false;
+  if (load_size_ == 0 || load_size_ == BLOCK_SIZE) {
+    uint64 offset = load_size_ == 0 ? file_offset_ : file_offset_ + BLOCK_SIZE;
+
+    if (ahead_issued_) {
+      waitAhead();
+      ahead_issued_ = false;
+      readn = ahead_res_;
+      if (readn > 0) std::swap(block_, ahead_);
+    } else {
+      readn = readFile(block_, BLOCK_SIZE, offset);
+    }
+
+    if (readn > 0) {
+      file_offset_ = offset;
+      offset_ = 0;
+      load_size_ = readn;
+      if (start_pos_ != 0) {
+        if (start_pos_ > load_size_) {
+          LOG<< "seek beyond eof: " << (file_offset_ + start_pos_);
+          return false;
+        }
+        offset_ = start_pos_;
+        start_pos_ = 0;
+      }
+      if (aio_ != NULL && frames_ == NULL && readn == BLOCK_SIZE) readAhead();
+      return true;
+    }
+
+  } else {
+    readn = readFile(block_ + load_size_, BLOCK_SIZE - load_size_,
+                     file_offset_ + load_size_);
+    if (readn > 0) {
+      load_size_ += readn;
+      if (aio_ != NULL && frames_ == NULL && load_size_ == BLOCK_SIZE) {
+        readAhead();
+      }
+      return true;
     }
   }
 
-  log->append(data, len);
+  LOG<< "read error: " << readn;
+  return false;
+}
+
+bool LogReader::seek(uint64 offset) {
+  CHECK_EQ(load_size_, 0) << "seek after read";
+  file_offset_ = offset / BLOCK_SIZE * BLOCK_SIZE;
+  start_pos_ = offset - file_offset_;
   return true;
 }
 
-bool LogReader::read(std::string* log) {
-  bool is_last = false;
+bool LogReader::next(const char** data, uint32* len) {
+  scratch_.clear();
+
+  while (true) {
+    // the trailer of a block is padded with zero.
+    if (load_size_ == BLOCK_SIZE && BLOCK_SIZE - offset_ <= LOG_HEADER_SIZE) {
+      offset_ = load_size_;
+    }
 
-  while (!is_last) {
     if (offset_ == load_size_) {
       if (!loadCache()) return false;
       continue;
     }
 
-    CHECK_NE(offset_, load_size_);
-    if (!readRecord(log, &is_last)) {
-      return false;
+    CHECK_GE(load_size_ - offset_, LOG_HEADER_SIZE);
+    char* buf = block_ + offset_;
+    uint32 size = v32(buf);
+    buf += 4;
+    uint32 type = v32(buf);
+    buf += 4;
+    uint32 saved_crc = v32(buf);
+    buf += 4;
+
+    CHECK_LE(size, load_size_ - offset_ - LOG_HEADER_SIZE);
+    offset_ += LOG_HEADER_SIZE + size;
+
+    if (crc_check_ && saved_crc != 0) {
+      uint32 crc = crc32Value(buf, size);
+      if (crc != saved_crc) {
+        return false;
+      }
     }
-  }
 
-  return true;
-}
+    if (type & START_RECORD) scratch_.clear();
 
+    // the common case, no copy.
+    if ((type & START_RECORD) && (type & LAST_RECORD)) {
+      *data = buf;
+      *len = size;
+      return true;
+    }
+
+    scratch_.append(buf, size);
+    if (type & LAST_RECORD) {
+      *data = scratch_.data();
+      *len = scratch_.size();
+      return true;
+    }
+  }
 }
 
+}
@@ -2,43 +2,110 @@
 
 #include "base/base.h"
 #include "logger_def.h"
+#include "log_frame.h"
 
 namespace util {
 
 class LogReader {
   public:
     LogReader(SequentialReadonlyFile* log_file, bool enable_crc_check = true)
-        : log_file_(log_file), crc_check_(enable_crc_check), offset_(0), load_size_(
-            0) {
+        : log_file_(log_file), aio_(NULL), crc_check_(enable_crc_check),
+          offset_(0), load_size_(0), start_pos_(0), file_offset_(0),
+          ahead_(NULL), ahead_inflight_(false), ahead_issued_(false),
+          ahead_res_(0), framed_(-1), read_pos_(MAX_UINT64) {
       CHECK_NOTNULL(log_file);
+      bufs_.reset(new char[BLOCK_SIZE]);
+      block_ = bufs_.get();
     }
+
+    // the next block is read ahead by @aio while the current one is parsed.
+    LogReader(RandomAccessFile* log_file, AioEngine* aio,
+              bool enable_crc_check = true)
+        : ra_file_(log_file), aio_(aio), crc_check_(enable_crc_check),
+          offset_(0), load_size_(0), start_pos_(0), file_offset_(0),
+          ahead_inflight_(false), ahead_issued_(false), ahead_res_(0),
+          framed_(-1), read_pos_(MAX_UINT64) {
+      CHECK_NOTNULL(log_file);
+      CHECK_NOTNULL(aio);
+      bufs_.reset(new char[BLOCK_SIZE * 2]);
+      block_ = bufs_.get();
+      ahead_ = block_ + BLOCK_SIZE;
+    }
+
     ~LogReader() {
+      waitAhead();
     }
 
-    bool read(std::string* log);
+    // start from the record at file offset @offset, must be called before
+    // reading.  @offset is from LogIndexEntry or position().
+    bool seek(uint64 offset);
+
+    // file offset of the next record.
+    uint64 position() const {
+      return file_offset_ + (load_size_ == 0 ? start_pos_ : offset_);
+    }
+
+    // zero-copy: records in one fragment point into the block buffer,
+    // others are stitched in a scratch buffer. valid until the next call.
+    bool next(const char** data, uint32* len);
+
+    bool read(std::string* log) {
+      const char* data;
+      uint32 len;
+      if (!next(&data, &len)) return false;
+
+      log->assign(data, len);
+      return true;
+    }
     bool read(std::deque<std::string*>* log_vec, int size) {
+      const char* data;
+      uint32 len;
       for (uint32 i = 0; i < size; ++i) {
-        std::string* log = new std::string;
-        if (!read(log)) {
-          delete log;
-          break;
-        }
-        log_vec->push_back(log);
+        if (!next(&data, &len)) break;
+        log_vec->push_back(new std::string(data, len));
       }
       return !log_vec->empty();
     }
 
   private:
     std::unique_ptr<SequentialReadonlyFile> log_file_;
+    std::unique_ptr<RandomAccessFile> ra_file_;
+    AioEngine* aio_;
 
     const bool crc_check_;
 
     uint32 offset_;
     uint32 load_size_;
-    char block_[BLOCK_SIZE];
+    uint32 start_pos_;  // where to start in the first block, set by seek()
+    char* block_;
+    std::unique_ptr<char[]> bufs_;
+
+    std::string scratch_;
+
+    // file offset of the current block.
+    uint64 file_offset_;
+    char* ahead_;
+    bool ahead_inflight_;
+    bool ahead_issued_;  // the next block is being or has been read ahead
+    int32 ahead_res_;
+
+    // compressed files are read through frames_, offsets are in the
+    // uncompressed file.  -1 if not known yet.
+    int framed_;
+    std::unique_ptr<FrameDecoder> frames_;
+
+    // where log_file_ reads next, MAX_UINT64 if it must seek, e.g. after a
+    // short read, which sets the eof of the stream.
+    uint64 read_pos_;
+
+    bool detect();
 
     bool loadCache();
-    bool readRecord(std::string* log, bool* is_last);
+    int32 readFile(char* buf, uint32 len, uint64 offset);
+    int32 readRaw(char* buf, uint32 len, uint64 offset);
+
+    void readAhead();
+    void waitAhead();
 
     DISALLOW_COPY_AND_ASSIGN(LogReader);
 };
@@ -2,16 +2,52 @@
 
 #include "base/base.h"
 #include "logger_def.h"
+#include "log_index.h"
+#include "log_frame.h"
 
 namespace util {
 
 // not threadsafe.
+//
+// records are written in BLOCK_SIZE blocks aligned in the file, a record
+// is split into fragments if it spans blocks, and the trailer of a block
+// too small for a header is padded with zero.
+//
+// with setCompression(), each flush() writes the new part of the block as
+// a frame, see log_frame.h.
 class LogWriter {
   public:
     LogWriter(AppendonlyMmapedFile* log_file, bool enable_crc_check = true)
-        : _log_file(log_file), _crc_check(enable_crc_check), _block_offset(0) {
+        : _log_file(log_file), _aio(NULL), _crc_check(enable_crc_check),
+          _block_offset(0), _flushed(0), _file_offset(0), _cur(0), _seq(0),
+          _file_id(0), _index_interval(0), _codec(LOG_RAW),
+          _compress(false), _frame_offset(0) {
+      _bufs.reset(new char[BLOCK_SIZE]);
+      _block = _bufs.get();
+      _inflight[0] = _inflight[1] = 0;
     }
+
+    // flush() hands the unflushed part of the block to @aio and returns,
+    // the next block is filled while the previous one is being written.
+    LogWriter(RandomAccessFile* log_file, AioEngine* aio,
+              bool enable_crc_check = true)
+        : _ra_file(log_file), _aio(aio), _crc_check(enable_crc_check),
+          _block_offset(0), _flushed(0), _file_offset(0), _cur(0), _seq(0),
+          _file_id(0), _index_interval(0), _codec(LOG_RAW),
+          _compress(false), _frame_offset(0) {
+      CHECK_NOTNULL(log_file);
+      CHECK_NOTNULL(aio);
+      _bufs.reset(new char[BLOCK_SIZE * 2]);
+      _block = _bufs.get();
+      _inflight[0] = _inflight[1] = 0;
+    }
+
     ~LogWriter() {
+      if (_aio != NULL) {
+        flush();
+        waitWrite(0);
+        waitWrite(1);
+      }
     }
 
     void flush();
@@ -20,15 +56,54 @@ class LogWriter {
       return append(log.data(), log.size());
     }
 
+    // wait for inflight writes and fdatasync, aio mode only.
+    bool sync();
+
+    // records are numbered from @first_seq, and the position of every
+    // @interval records is appended to the index file, see log_index.h.
+    bool enableIndex(uint64 first_seq = 0, uint32 interval = 1024);
+
+    // compress in flush(), call it before appending.
+    bool setCompression(LogCodec codec);
+
+    // sequence number of the next record.
+    uint64 seq() const {
+      return _seq;
+    }
+
   private:
     std::unique_ptr<AppendonlyMmapedFile> _log_file;
+    std::unique_ptr<RandomAccessFile> _ra_file;
+    AioEngine* _aio;
 
     const bool _crc_check;
 
     uint32 _block_offset;
-    char _block[BLOCK_SIZE];
+    uint32 _flushed;  // [0, _flushed) of the block has been written
+    char* _block;
+    std::unique_ptr<char[]> _bufs;
+
+    uint64 _file_offset;  // of the block
+
+    // for aio mode, the block being filled is _bufs[_cur].
+    uint32 _cur;
+    uint32 _inflight[2];
+
+    uint64 _seq;
+    uint64 _file_id;
+    uint32 _index_interval;
+    std::unique_ptr<LogIndexWriter> _index;
+
+    LogCodec _codec;
+    bool _compress;
+    uint64 _frame_offset;  // file offset of the next frame
+    // for aio mode, frames being written from _bufs[i].
+    std::vector<std::unique_ptr<std::string>> _frames[2];
+
+    void append(uint32 type, const char* data, uint32 len);
 
-    bool append(uint32 type, const char* data, uint32 len);
+    void nextBlock();
+    void waitWrite(uint32 index);
 
     DISALLOW_COPY_AND_ASSIGN(LogWriter);
 };
@@ -2,11 +2,8 @@
 
 namespace util {
 
-bool LogWriter::append(uint32 type, const char* data, uint32 len) {
-  uint32 space_len = BLOCK_SIZE - _block_offset;
-  if (space_len < LOG_HEADER_SIZE + len) {
-    return false;
-  }
+void LogWriter::append(uint32 type, const char* data, uint32 len) {
+  CHECK_LE(LOG_HEADER_SIZE + len, BLOCK_SIZE - _block_offset);
 
   // length + type + crc32
   char* buf = _block + _block_offset;
@@ -21,42 +18,139 @@ bool LogWriter::append(uint32 type, const char* data, uint32 len) {
 
   ::memcpy(buf, data, len);
   _block_offset += LOG_HEADER_SIZE + len;
+}
+
+void LogWriter::waitWrite(uint32 index) {
+  while (_inflight[index] != 0) {
+    _aio->poll(1);
+  }
+  _frames[index].clear();
+}
+
+void LogWriter::nextBlock() {
+  flush();
+
+  if (_aio != NULL) {
+    _cur ^= 1;
+    waitWrite(_cur);
+    _block = _bufs.get() + _cur * BLOCK_SIZE;
+  }
+
+  _file_offset += BLOCK_SIZE;
+
+  _block_offset = 0;
+  _flushed = 0;
+}
+
+bool LogWriter::sync() {
+  if (_aio == NULL) return false;
+
+  waitWrite(0);
+  waitWrite(1);
+  if (_index != NULL) _index->flush();
+  return _ra_file->flush();
+}
+
+bool LogWriter::enableIndex(uint64 first_seq, uint32 interval) {
+  CHECK_GT(interval, 0U);
+  const std::string& path =
+      _aio == NULL ? _log_file->fpath() : _ra_file->fpath();
+
+  _index.reset(new LogIndexWriter(path));
+  if (!_index->Init()) {
+    _index.reset();
+    return false;
+  }
+
+  _file_id = logFileId(path);
+  _seq = first_seq;
+  _index_interval = interval;
+  return true;
+}
+
+bool LogWriter::setCompression(LogCodec codec) {
+  CHECK(_file_offset == 0 && _block_offset == 0) << "compress after append";
+  if (!logCodecSupported(codec)) return false;
+
+  _codec = codec;
+  _compress = true;
   return true;
 }
 
 void LogWriter::flush() {
-  if (_block_offset != 0) {
-    int32 writen = _log_file->write(_block, _block_offset);
-    CHECK_EQ(writen, _block_offset);
+  if (_flushed == _block_offset) return;
+
+  const char* data = _block + _flushed;
+  uint32 len = _block_offset - _flushed;
+  uint64 offset = _file_offset + _flushed;
+
+  std::unique_ptr<std::string> frame;
+  if (_compress) {
+    frame.reset(new std::string);
+    appendFrame(_codec, _crc_check, data, len, frame.get());
+    data = frame->data();
+    len = frame->size();
+    offset = _frame_offset;
+    _frame_offset += len;
+  }
+
+  if (_aio == NULL) {
+    int32 writen = _log_file->write(data, len);
+    CHECK_EQ(writen, static_cast<int32>(len));
     _log_file->flush();
-    _block_offset = 0;
+    if (_index != NULL) _index->flush();
+
+  } else {
+    uint32 index = _cur;
+    if (frame != NULL) _frames[index].push_back(std::move(frame));
+
+    ++_inflight[index];
+    bool ret = _ra_file->asyncWrite(_aio, data, len, offset,
+                                    [this, index, len](int32 res) {
+      CHECK_EQ(res, static_cast<int32>(len)) << "async write error";
+      --_inflight[index];
+    });
+    CHECK(ret);
   }
+
+  _flushed = _block_offset;
 }
 
 bool LogWriter::append(const char* data, uint32 len) {
-  for (uint32 pos = 0; pos != len; /* empty */) {
+  uint32 pos = 0;
+
+  while (true) {
     uint32 space_size = BLOCK_SIZE - _block_offset;
     if (space_size <= LOG_HEADER_SIZE) {
       ::memset(_block + _block_offset, '\0', space_size);
-      flush();
+      _block_offset = BLOCK_SIZE;
+      nextBlock();
       continue;
     }
 
-    CHECK_GT(space_size, LOG_HEADER_SIZE);
-    uint32 avail_len = std::min(space_size, len - pos);
+    if (pos == 0 && _index != NULL && _seq % _index_interval == 0) {
+      LogIndexEntry entry;
+      entry.file_id = _file_id;
+      entry.block_offset = _file_offset;
+      entry.block_pos = _block_offset;
+      entry.seq = _seq;
+      entry.time = sys::utc.ms();
+      CHECK(_index->append(entry));
+    }
+
+    uint32 avail_len = std::min(space_size - LOG_HEADER_SIZE, len - pos);
     uint32 type = 0;
     if (pos == 0) type |= START_RECORD;
     if (pos + avail_len == len) type |= LAST_RECORD;
 
-    if (!append(type, data + pos, avail_len)) {
-      return false;
-    }
-
+    append(type, data + pos, avail_len);
     pos += avail_len;
+
+    if (pos == len) break;
   }
 
+  ++_seq;
   return true;
 }
 
 }
-
@@ -6,67 +6,51 @@ DEF_uint32(slot_reflesh_interval, 3, "slot reflesh interval");
 
 namespace {
 
-bool parseServer(const std::string &server, std::string* ip, uint16* port) {
-  auto ipport = util::split_string(server, ':');
+bool parseServer(const util::StringView& server, std::string* ip,
+                 uint16* port) {
+  SmallVector<util::StringView, 4> ipport;
+  util::split_view(server, ':', &ipport);
   if (ipport.size() != 2) {
     ELOG<<"server in wrong format: " << server;
     return false;
   }
 
-  *ip = ipport[0];
-  *port = util::to_uint32(ipport[1]);
+  *ip = ipport[0].to_string();
+  *port = util::to_uint32(ipport[1].to_string());
   return true;
 }
 
 bool parseSlot(const std::string& item, std::string* ip, uint16* port,
                uint32* slot_begin, uint32* slot_end) {
-  auto vec = util::split_string(item, ' ');
+  SmallVector<util::StringView, 4> vec;
+  util::split_view(item, ' ', &vec);
   if (vec.size() != 2) {
     WLOG<< "wrong slot item: " << item;
     return false;
   }
 
-  auto slots_vec = util::split_string(vec[0], '~');
+  SmallVector<util::StringView, 4> slots_vec;
+  util::split_view(vec[0], '~', &slots_vec);
   if (slots_vec.size() != 2) {
     WLOG<< "wrong slot range: " << vec[0];
     return false;
   }
 
-  *slot_begin = util::to_int32(slots_vec[0]);
-  *slot_end = util::to_int32(slots_vec[1]);
+  *slot_begin = util::to_int32(slots_vec[0].to_string());
+  *slot_end = util::to_int32(slots_vec[1].to_string());
 
-  auto serv_vec = util::split_string(vec[1], ',');
-  if (serv_vec.empty()) {
+  util::Tokenizer servers(vec[1], ',');
+  util::StringView server;
+  if (!servers.next(&server)) {
     WLOG<< "wrong server: " << vec[1];
     return false;
   }
 
-  return parseServer(serv_vec[0], ip, port);
+  return parseServer(server, ip, port);
 }
 
 uint32_t HASH_SLOT(const std::string &strKey) {
-  const char *pszKey = strKey.data();
-  size_t nKeyLen = strKey.size();
-  size_t nStart, nEnd; /* start-end indexes of { and  } */
-
-  /* Search the first occurrence of '{'. */
-  for (nStart = 0; nStart < nKeyLen; nStart++)
-    if (pszKey[nStart] == '{') break;
-
-  /* No '{' ? Hash the whole key. This is the base case. */
-  if (nStart == nKeyLen) return crc16(pszKey, nKeyLen) & 16383;
-
-  /* '{' found? Check if we have the corresponding '}'. */
-  for (nEnd = nStart + 1; nEnd < nKeyLen; nEnd++)
-    if (pszKey[nEnd] == '}') break;
-
-  /* No '}' or nothing between {} ? Hash the whole key. */
-  if (nEnd == nKeyLen || nEnd == nStart + 1)
-    return crc16(pszKey, nKeyLen) & 16383;
-
-  /* If we are here there is both a { and a  } on its right. Hash
-   * what is in the middle between { and  }. */
-  return crc16(pszKey + nStart + 1, nEnd - nStart - 1) & 16383;
+  return redisHashSlot(strKey);
 }
 
 }
@@ -327,14 +311,15 @@ bool DBImpl::handleErrorMsg(const std::string &err) {
  */
 bool DBImpl::parseMovedErrorMsg(const std::string &err, uint32 *slot,
                                 std::string *ip, uint16 *port) const {
-  auto vec_err = util::split_string(err, ' ');
+  SmallVector<util::StringView, 4> vec_err;
+  util::split_view(err, ' ', &vec_err);
   if (vec_err.size() < 3) {
     ELOG<< "parse error: " << err;
     return false;
   }
 
-  auto server = *vec_err.rbegin();
-  *slot = util::to_int32(vec_err[1]);
+  auto server = vec_err.back();
+  *slot = util::to_int32(vec_err[1].to_string());
 
   if (!parseServer(server, ip, port)) {
     return false;
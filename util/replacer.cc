@@ -0,0 +1,123 @@
+#include "replacer.h"
+
+#include <deque>
+
+namespace util {
+
+ReplacePatterns::ReplacePatterns(
+    const std::map<std::string, std::string>& patterns)
+    : _ncls(1), _max_len(0) {
+    ::memset(_class, 0, sizeof(_class));
+    for (auto it = patterns.begin(); it != patterns.end(); ++it) {
+        for (size_t i = 0; i < it->first.size(); ++i) {
+            uint8 c = static_cast<uint8>(it->first[i]);
+            if (_class[c] == 0) _class[c] = _ncls++;
+        }
+    }
+
+    // the trie, -1 for missing edges.
+    _next.assign(_ncls, -1);
+    _out.assign(1, -1);
+
+    for (auto it = patterns.begin(); it != patterns.end(); ++it) {
+        const std::string& src = it->first;
+        if (src.empty()) continue;
+
+        int32 state = 0;
+        for (size_t i = 0; i < src.size(); ++i) {
+            size_t k = state * _ncls + _class[static_cast<uint8>(src[i])];
+            if (_next[k] < 0) {
+                _next[k] = static_cast<int32>(_out.size());
+                _next.resize(_next.size() + _ncls, -1);
+                _out.push_back(-1);
+            }
+            state = _next[k];
+        }
+
+        _out[state] = static_cast<int32>(_dst.size());
+        _len.push_back(src.size());
+        _dst.push_back(it->second);
+        _max_len = std::max(_max_len, src.size());
+    }
+
+    // breadth first, failure links of a state are done before its children.
+    std::vector<int32> fail(_out.size(), 0);
+    std::deque<int32> q;
+    for (uint32 c = 0; c < _ncls; ++c) {
+        int32& v = _next[c];
+        if (v < 0) {
+            v = 0;
+        } else {
+            q.push_back(v);
+        }
+    }
+
+    while (!q.empty()) {
+        int32 u = q.front();
+        q.pop_front();
+
+        for (uint32 c = 0; c < _ncls; ++c) {
+            int32& v = _next[u * _ncls + c];
+            const int32 w = _next[fail[u] * _ncls + c];
+            if (v < 0) {
+                v = w;
+                continue;
+            }
+
+            // patterns ending at the failure state are suffixes, and shorter.
+            fail[v] = w;
+            if (_out[v] < 0) _out[v] = _out[w];
+            q.push_back(v);
+        }
+    }
+}
+
+void ReplacePatterns::replace(const char* s, size_t n,
+                              std::string* out) const {
+    if (_dst.empty()) {
+        out->append(s, n);
+        return;
+    }
+
+    const int32* next = _next.data();
+    size_t done = 0;  // s[0, done) is in @out
+    size_t i = 0;
+    int32 state = 0;
+
+    // the leftmost match so far, a later one may start no earlier than
+    // _max_len bytes before its end.
+    int32 best = -1;
+    size_t best_start = 0;
+
+    while (true) {
+        if (best >= 0 && (i == n || i - best_start >= _max_len)) {
+            out->append(s + done, best_start - done);
+            out->append(_dst[best]);
+
+            // rescan what follows the match.
+            i = done = best_start + _len[best];
+            state = 0;
+            best = -1;
+        }
+
+        if (state == 0 && best < 0) {
+            while (i < n && _class[static_cast<uint8>(s[i])] == 0) ++i;
+        }
+        if (i == n) break;
+
+        state = next[state * _ncls + _class[static_cast<uint8>(s[i++])]];
+        const int32 p = _out[state];
+        if (p >= 0) {
+            const size_t start = i - _len[p];
+            if (best < 0 || start < best_start ||
+                (start == best_start && _len[p] > _len[best])) {
+                best = p;
+                best_start = start;
+            }
+        }
+    }
+
+    out->append(s + done, n - done);
+}
+
+} // namespace util
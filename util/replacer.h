@@ -4,6 +4,57 @@
 
 namespace util {
 
+/*
+ * patterns compiled to an Aho-Corasick automaton, all of them are replaced
+ * in a single pass over the input.  the leftmost match wins, and the longest
+ * one of those starting at the same position.  replaced text isn't scanned
+ * again, empty patterns are ignored.
+ *
+ *   immutable once built, it can be shared between threads.
+ *
+ *   ReplacePatterns p({ {"{{name}}", "foo"}, {"{{id}}", "23"} });
+ *   std::string page = p.replace(tpl);
+ */
+class ReplacePatterns {
+  public:
+    explicit ReplacePatterns(
+        const std::map<std::string, std::string>& patterns);
+    ~ReplacePatterns() = default;
+
+    std::string replace(const std::string& s) const {
+        std::string out;
+        this->replace(s.data(), s.size(), &out);
+        return out;
+    }
+
+    // append [@s, @s + @n) with patterns replaced to @out.
+    void replace(const char* s, size_t n, std::string* out) const;
+
+    size_t size() const {
+        return _dst.size();
+    }
+
+  private:
+    // bytes not in any pattern are class 0.
+    uint16 _class[256];
+    uint32 _ncls;
+    size_t _max_len;
+
+    // state * _ncls + class -> state, the failure links resolved.
+    std::vector<int32> _next;
+    // state -> the longest pattern ending there, -1 for none.
+    std::vector<int32> _out;
+
+    std::vector<uint32> _len;
+    std::vector<std::string> _dst;
+
+    DISALLOW_COPY_AND_ASSIGN(ReplacePatterns);
+};
+
+/*
+ * replace patterns in @str, the automaton is built on the first replace()
+ * after push().  see ReplacePatterns.
+ */
 class Replacer {
   public:
     Replacer(std::string* str)
@@ -14,28 +65,24 @@ class Replacer {
     }
 
     void replace() {
-      for (auto it = _map.begin(); it != _map.end(); ++it) {
-        const auto& src = it->first;
-        const auto& dst = it->second;
-        while (true) {
-          auto pos = _str->find(src);
-          if (pos == std::string::npos) {
-            break;
-          }
-
-          _str->replace(pos, src.size(), dst);
-        }
-      }
+      if (_patterns == NULL) _patterns.reset(new ReplacePatterns(_map));
+
+      std::string out;
+      out.reserve(_str->size());
+      _patterns->replace(_str->data(), _str->size(), &out);
+      _str->swap(out);
     }
 
     void push(const std::string& src, const std::string& dst) {
       _map[src] = dst;
+      _patterns.reset();
     }
 
   private:
     std::string* _str;
 
     std::map<std::string, std::string> _map;
+    std::unique_ptr<ReplacePatterns> _patterns;
 
     DISALLOW_COPY_AND_ASSIGN(Replacer);
 };
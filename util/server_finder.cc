@@ -38,6 +38,11 @@ bool ServerFinder::init() {
         }
     }
 
+    {
+        WriteLockGuard g(_rw_lock);
+        for (auto& x : _server_list) this->ring_add(x.first, x.second);
+    }
+
     LOG << "server finder init success, server num: " << _server_list.size()
         << ", servers: " << this->server_list();
     return true;
@@ -55,6 +60,42 @@ ServerFinder::IpPort ServerFinder::next_server() {
     return *_last_server;
 }
 
+ServerFinder::IpPort ServerFinder::next_server(const std::string& key) {
+    ReadLockGuard g(_rw_lock);
+
+    const std::string* name = _ring->find(key);
+    if (name != NULL) {
+        auto it = _nodes.find(*name);
+        if (it != _nodes.end()) return it->second;
+    }
+
+    if (!_server_list.empty()) return _server_list[0];
+
+    CHECK(_last_server != NULL);
+    return *_last_server;
+}
+
+void ServerFinder::set_weight(const std::string& ip, uint32 port,
+                              uint32 weight) {
+    WriteLockGuard g(_rw_lock);
+    const std::string name = node_name(ip, port);
+    _weights[name] = weight;
+    if (_nodes.find(name) != _nodes.end()) _ring->add(name, weight);
+}
+
+void ServerFinder::ring_add(const std::string& ip, uint32 port) {
+    const std::string name = node_name(ip, port);
+    auto it = _weights.find(name);
+    _ring->add(name, it != _weights.end() ? it->second : 1);
+    _nodes[name] = std::make_pair(ip, port);
+}
+
+void ServerFinder::ring_del(const std::string& ip, uint32 port) {
+    const std::string name = node_name(ip, port);
+    _ring->remove(name);
+    _nodes.erase(name);
+}
+
 void ServerFinder::on_server_up(const std::string& ip, uint32 port) {
     WriteLockGuard g(_rw_lock);
     TLOG("up") << "server up, ip: " << ip << ", port: " << port;
@@ -105,6 +146,7 @@ void ServerFinder::add_server(const std::string& ip, uint32 port) {
     }
 
     _server_list.push_back(std::make_pair(ip, port));
+    this->ring_add(ip, port);
 }
 
 void ServerFinder::del_server(const std::string& ip, uint32 port) {
@@ -114,6 +156,7 @@ void ServerFinder::del_server(const std::string& ip, uint32 port) {
         const auto& server = *it;
         if (server.first == ip && server.second == port) {
             _server_list.erase(it);
+            this->ring_del(ip, port);
             break;
         }
     }
@@ -129,6 +172,20 @@ void ServerFinder::update_server_list() {
     WriteLockGuard g(_rw_lock);
     _server_list.swap(server_list);
 
+    // apply the difference to the ring, keys of unchanged servers stay.
+    std::set<std::string> names;
+    for (auto& x : _server_list) {
+        names.insert(node_name(x.first, x.second));
+        if (_nodes.find(node_name(x.first, x.second)) == _nodes.end()) {
+            this->ring_add(x.first, x.second);
+        }
+    }
+    for (auto& x : server_list) {
+        if (names.find(node_name(x.first, x.second)) == names.end()) {
+            this->ring_del(x.first, x.second);
+        }
+    }
+
     DLOG("server_list") << "server_list: " << this->server_list();
 
     if (_last_server != NULL && !_server_list.empty()) {
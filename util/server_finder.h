@@ -1,6 +1,7 @@
 #pragma once
 
 #include "include/thread_safe.h"
+#include "consistent_hash.h"
 #include "./zkclient/smart_finder/smart_finder.h"
 
 namespace util {
@@ -10,16 +11,26 @@ class ServerFinder {
     typedef std::pair<std::string, uint32> IpPort;
     typedef std::function<void(const std::string&, uint32)> Callback;
 
-    explicit ServerFinder(SmartFinder* finder)
-        : _finder(finder) {
+    // @strategy is used by next_server(key).
+    explicit ServerFinder(SmartFinder* finder,
+                          HashStrategy strategy = HASH_KETAMA)
+        : _finder(finder), _ring(CreateConsistentHash(strategy)) {
         CHECK_NOTNULL(finder);
     }
     ~ServerFinder();
 
     bool init();
 
+    // a random server.
     IpPort next_server();
 
+    // the same server for @key as long as it's up, so backends see stable
+    // key sets.  only keys of a server going up or down move.
+    IpPort next_server(const std::string& key);
+
+    // weight of a server, 1 by default, ignored by HASH_JUMP.
+    void set_weight(const std::string& ip, uint32 port, uint32 weight);
+
     void add_down_callback(const std::string& ip, uint32 port,
                            Callback cb) {
         _cbs[this->hash(ip, port)] = cb;
@@ -37,6 +48,13 @@ class ServerFinder {
 
     void update_server_list();
 
+    static std::string node_name(const std::string& ip, uint32 port) {
+        return ip + ":" + util::to_string(port);
+    }
+
+    void ring_add(const std::string& ip, uint32 port);
+    void ring_del(const std::string& ip, uint32 port);
+
     uint32 hash(const std::string& ip, uint32 port) {
         return ::SuperFastHash(ip + util::to_string(port));
     }
@@ -62,6 +80,11 @@ class ServerFinder {
     std::vector<IpPort> _server_list;
     std::unique_ptr<IpPort> _last_server;
 
+    // servers of _server_list by node name.
+    std::unique_ptr<ConsistentHash> _ring;
+    std::map<std::string, IpPort> _nodes;
+    std::map<std::string, uint32> _weights;
+
     std::unique_ptr<StoppableThread> _update_thread;
 
     DISALLOW_COPY_AND_ASSIGN(ServerFinder);
@@ -1,22 +1,26 @@
 #include "url_coder.h"
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#define URL_HAVE_SIMD
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
 namespace {
 class UrlCoder {
   public:
     UrlCoder();
     ~UrlCoder() = default;
 
-    std::string decode(const std::string& src) const;
-    std::string encode(const std::string& src) const;
-
-    int hex2int(char c) const {
-        if (c >= '0' && c <= '9') return c - '0';
-        return ::tolower(c) - 'a' + 10;
-    }
+    int64 decode(const char* src, size_t n, char* dst) const;
+    size_t encode(const char* src, size_t n, char* dst) const;
 
   private:
-    util::ascii_table _uncoded;
-    util::ascii_table _hex;
+    uint8 _uncoded[256];
+    int8 _hex[256];  // -1 for non-hex
+
+    // length of the run of uncoded letters at @s.
+    size_t uncoded(const char* s, size_t n) const;
 
     DISALLOW_COPY_AND_ASSIGN(UrlCoder);
 };
@@ -28,76 +32,153 @@ class UrlCoder {
  *
  * hex: 0...9  a...f  A...F
  */
-UrlCoder::UrlCoder()
-    : _uncoded(std::vector<char> {
-                   '-', '_', '.', '~', /* unreserved */
-                   '!', '*', '\'', '(', ')', ';', ':', '@', '&',
-                   '=', '+', '$', ',', '/', '?', '#', '[', ']'
-               }) {
+UrlCoder::UrlCoder() {
+    ::memset(_uncoded, 0, sizeof(_uncoded));
+    ::memset(_hex, -1, sizeof(_hex));
+
+    const char* s = "-_.~" /* unreserved */ "!*'();:@&=+$,/?#[]";
+    for (; *s != '\0'; ++s) _uncoded[static_cast<uint8>(*s)] = 1;
+
     for (int i = 'A'; i <= 'Z'; ++i) {
-        _uncoded.set(i);
-        _uncoded.set(i + 'a' - 'A');
+        _uncoded[i] = 1;
+        _uncoded[i + 'a' - 'A'] = 1;
     }
 
     for (int i = '0'; i <= '9'; ++i) {
-        _uncoded.set(i);
-        _hex.set(i);
+        _uncoded[i] = 1;
+        _hex[i] = i - '0';
     }
 
     for (int i = 'A'; i <= 'F'; ++i) {
-        _hex.set(i);
-        _hex.set(i + 'a' - 'A');
+        _hex[i] = i - 'A' + 10;
+        _hex[i + 'a' - 'A'] = i - 'A' + 10;
     }
 }
 
-std::string UrlCoder::decode(const std::string& src) const {
-    std::string dst;
-    dst.reserve(src.size());
-
-    for (int i = 0; i < src.size(); ++i) {
-        if (_uncoded.check(src[i])) {
-            dst.push_back(src[i]);
-            continue;
-        } /* for uncoded character */
-
-        // ' ' may be encoded as '+'
-        if (src[i] == '+') {
-            dst.push_back(' ');
-            continue;
+#ifdef URL_HAVE_SIMD
+// uncoded letters are 0x21...0x7e but " % < > \ ^ ` { | }, signed compares
+// also drop bytes above 0x7f.
+#define URL_UNCODED(V, X, SET1, GT, LT, EQ, OR, ANDNOT) \
+    ANDNOT(OR(OR(OR(EQ(V, SET1('"')), EQ(V, SET1('%'))), \
+                 OR(EQ(V, SET1('<')), EQ(V, SET1('>')))), \
+              OR(OR(OR(EQ(V, SET1('\\')), EQ(V, SET1('^'))), \
+                    OR(EQ(V, SET1('`')), EQ(V, SET1('{')))), \
+                 OR(EQ(V, SET1('|')), EQ(V, SET1('}'))))), \
+           X(GT(V, SET1(0x20)), LT(V, SET1(0x7f))))
+
+static size_t uncodedSse2(const char* s, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        __m128i ok = URL_UNCODED(v, _mm_and_si128, _mm_set1_epi8,
+                               _mm_cmpgt_epi8, _mm_cmplt_epi8, _mm_cmpeq_epi8,
+                               _mm_or_si128, _mm_andnot_si128);
+        uint32 m = ~_mm_movemask_epi8(ok) & 0xffff;
+        if (m != 0) return i + __builtin_ctz(m);
+    }
+    return i;
+}
+
+#define URL_LT256(a, b) _mm256_cmpgt_epi8(b, a)
+
+__attribute__((target("avx2")))
+static size_t uncodedAvx2(const char* s, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(s + i));
+        __m256i ok = URL_UNCODED(v, _mm256_and_si256, _mm256_set1_epi8,
+                               _mm256_cmpgt_epi8, URL_LT256,
+                               _mm256_cmpeq_epi8, _mm256_or_si256,
+                               _mm256_andnot_si256);
+        uint32 m = ~static_cast<uint32>(_mm256_movemask_epi8(ok));
+        if (m != 0) {
+            _mm256_zeroupper();
+            return i + __builtin_ctz(m);
         }
+    }
+    _mm256_zeroupper();
+    return i;
+}
 
-        // for encoded character: %xx
-        CHECK_EQ(src[i], '%');
-        CHECK_LT(i + 2, src.size());
-        CHECK(_hex.check(src[i + 1])) << static_cast<int>(src[i + 1]);
-        CHECK(_hex.check(src[i + 2])) << static_cast<int>(src[i + 2]);
+#undef URL_LT256
+#undef URL_UNCODED
 
-        int h4 = this->hex2int(src[i + 1]);
-        int l4 = this->hex2int(src[i + 2]);
-        char c = (h4 << 4) | l4;
+// the os must save ymm registers too.
+static bool cpuHasAvx2() {
+    uint32 eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+    if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) return false;
 
-        dst.push_back(c);
-        i += 2;
-    }
+    uint32 xcr0, xcr0_hi;
+    __asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0_hi) : "c"(0));
+    if ((xcr0 & 6) != 6) return false;
 
-    return dst;
+    if (__get_cpuid_max(0, NULL) < 7) return false;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return (ebx & bit_AVX2) != 0;
 }
 
-std::string UrlCoder::encode(const std::string& src) const {
-    std::string dst;
+static const bool kHaveAvx2 = cpuHasAvx2();
+#endif
+
+// simd for long runs, values in a query string are mostly short.
+size_t UrlCoder::uncoded(const char* s, size_t n) const {
+    size_t i = 0;
+#ifdef URL_HAVE_SIMD
+    if (n >= 32 && kHaveAvx2) {
+        i = uncodedAvx2(s, n);
+    } else if (n >= 16) {
+        i = uncodedSse2(s, n);
+    }
+#endif
+    while (i < n && _uncoded[static_cast<uint8>(s[i])]) ++i;
+    return i;
+}
 
-    for (int i = 0; i < src.size(); ++i) {
-        if (_uncoded.check(src[i])) {
-            dst.push_back(src[i]);
-            continue;
-        }
+int64 UrlCoder::decode(const char* src, size_t n, char* dst) const {
+    size_t i = 0;
+    char* p = dst;
 
-        dst.push_back('%');
-        dst.push_back("0123456789ABCDEF"[static_cast<uint8>(src[i]) >> 4]);
-        dst.push_back("0123456789ABCDEF"[static_cast<uint8>(src[i]) & 0x0F]);
+    while (true) {
+        size_t run = this->uncoded(src + i, n - i);
+        if (run != 0 && p != src + i) ::memmove(p, src + i, run);
+        p += run;
+        i += run;
+        if (i == n) break;
+
+        // for encoded character: %xx
+        if (src[i] != '%' || i + 2 >= n) return -1;
+        int h4 = _hex[static_cast<uint8>(src[i + 1])];
+        int l4 = _hex[static_cast<uint8>(src[i + 2])];
+        if ((h4 | l4) < 0) return -1;
+
+        *p++ = static_cast<char>((h4 << 4) | l4);
+        i += 3;
     }
 
-    return dst;
+    return p - dst;
+}
+
+size_t UrlCoder::encode(const char* src, size_t n, char* dst) const {
+    size_t i = 0;
+    char* p = dst;
+
+    while (true) {
+        size_t run = this->uncoded(src + i, n - i);
+        ::memcpy(p, src + i, run);
+        p += run;
+        i += run;
+        if (i == n) break;
+
+        const uint8 c = static_cast<uint8>(src[i++]);
+        p[0] = '%';
+        p[1] = "0123456789ABCDEF"[c >> 4];
+        p[2] = "0123456789ABCDEF"[c & 0x0F];
+        p += 3;
+    }
+
+    return p - dst;
 }
 
 UrlCoder kUrlCoder;
@@ -105,10 +186,34 @@ UrlCoder kUrlCoder;
 
 namespace util {
 std::string decode_url(const std::string& src) {
-    return kUrlCoder.decode(src);
+    std::string dst(src);
+    CHECK(decode_url(&dst)) << "invalid url: " << src;
+    return dst;
 }
 
 std::string encode_url(const std::string& src) {
-    return kUrlCoder.encode(src);
+    std::string dst;
+    dst.resize(encode_url_bound(src.size()));
+    dst.resize(kUrlCoder.encode(src.data(), src.size(), &dst[0]));
+    return dst;
+}
+
+int64 decode_url(const char* src, size_t n, char* dst) {
+    return kUrlCoder.decode(src, n, dst);
+}
+
+bool decode_url(std::string* s) {
+    int64 n = kUrlCoder.decode(s->data(), s->size(), &(*s)[0]);
+    if (n < 0) {
+        s->clear();
+        return false;
+    }
+
+    s->resize(n);
+    return true;
+}
+
+size_t encode_url(const char* src, size_t n, char* dst) {
+    return kUrlCoder.encode(src, n, dst);
 }
 } // namespace util
@@ -3,7 +3,27 @@
 #include "base/base.h"
 
 namespace util {
+// CHECK failed if @src is malformed.
 std::string decode_url(const std::string& src);
 
 std::string encode_url(const std::string& src);
+
+/*
+ * decode [@src, @src + @n) to @dst, which has room for @n bytes and may be
+ * @src, the output is never longer.  return the decoded length, or -1 if
+ * there is a letter that should be encoded, or a bad %xx.
+ */
+int64 decode_url(const char* src, size_t n, char* dst);
+
+// in place, return false if @s is malformed, @s is cleared then.
+bool decode_url(std::string* s);
+
+// the max length of [@src, @src + @n) encoded.
+inline size_t encode_url_bound(size_t n) {
+    return n * 3;
+}
+
+// encode to @dst, which has room for encode_url_bound(@n) bytes, return
+// the encoded length.
+size_t encode_url(const char* src, size_t n, char* dst);
 }
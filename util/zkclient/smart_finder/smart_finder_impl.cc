@@ -161,16 +161,15 @@ bool SmartFinderImpl::parseEntry(const std::string& node, ServerEntry* entry) {
     return false;
   }
 
-  auto ip_ports = util::split_string(data, ":");
+  SmallVector<util::StringView, 4> ip_ports;
+  util::split_view(data, ':', &ip_ports);
   if (ip_ports.size() != 2) {
     DLOG("zk_error") << "parse entry error, data: " << data;
     return false;
   }
 
-  const auto& ip = ip_ports[0];
-  auto port = util::to_uint32(ip_ports[1]);
-  entry->first = ip;
-  entry->second = port;
+  entry->first = ip_ports[0].to_string();
+  entry->second = util::to_uint32(ip_ports[1].to_string());
 //  WLOG<< "server: " << _server << ", ip: " << ip << ", port: " << port;
 
   return true;